@@ -4,20 +4,54 @@ CONFIG += c++17
 # 在 Ubuntu 上使用系统安装的 libarchive
 unix:!macx {
     CONFIG += link_pkgconfig
-    PKGCONFIG += libarchive
+    PKGCONFIG += libarchive zlib
+
+    # 可选：libtiff（超大 TIFF 的分块区域解码）
+    packagesExist(libtiff-4) {
+        PKGCONFIG += libtiff-4
+        DEFINES += HAVE_LIBTIFF
+    }
+
+    # 可选：libpng（超大 PNG 的逐行流式缩小，PNG 直接解码后端）
+    packagesExist(libpng) {
+        PKGCONFIG += libpng
+        DEFINES += HAVE_LIBPNG
+    }
+
+    # 可选：TurboJPEG / libwebp（JPEG、WebP 直接解码后端）
+    packagesExist(libturbojpeg) {
+        PKGCONFIG += libturbojpeg
+        DEFINES += HAVE_TURBOJPEG
+    }
+    packagesExist(libwebp) {
+        PKGCONFIG += libwebp
+        DEFINES += HAVE_LIBWEBP
+    }
 }
 
 # Windows 或其他情况
 win32 {
-    LIBS += -larchive
+    LIBS += -larchive -lzlib
     INCLUDEPATH += "J:\vcpkg\installed\x64-windows\include"  # 修改为实际路径
     LIBS += -L"J:\vcpkg\installed\x64-windows\lib"
 }
 
 SOURCES += main.cpp \
+    animationplayer.cpp \
     archivehandler.cpp \
+    archiveinput.cpp \
+    benchmark.cpp \
     canvascontrolpanel.cpp \
     configmanager.cpp \
+    decodedimagecache.cpp \
+    directoryscanner.cpp \
+    filereadahead.cpp \
+    folderwatcher.cpp \
+    imagecodecs.cpp \
+    imagelistsorter.cpp \
+    imagemetadatatable.cpp \
+    imageorientation.cpp \
+    imageresampler.cpp \
     imagewidget_archive.cpp \
     imagewidget_canvas.cpp \
     imagewidget_config.cpp \
@@ -28,19 +62,46 @@ SOURCES += main.cpp \
     imagewidget_keyboard.cpp \
     imagewidget_menu.cpp \
     imagewidget_mouse.cpp \
+    imagewidget_prefetch.cpp \
     imagewidget_shortcuts.cpp \
     imagewidget_slideshow.cpp \
     imagewidget_transform.cpp \
     imagewidget_view.cpp \
     imagewidget_viewmode.cpp \
-    thumbnailwidget.cpp
+    jpegrestartdecoder.cpp \
+    mappedimagefile.cpp \
+    pixelbufferpool.cpp \
+    regionimagesource.cpp \
+    scanlinedownsampler.cpp \
+    tarcheckpointindex.cpp \
+    thumbnailwidget.cpp \
+    tiledimagerenderer.cpp
 
 HEADERS += \
+    animationplayer.h \
     archivehandler.h \
+    archiveinput.h \
+    benchmark.h \
     canvascontrolpanel.h \
     configmanager.h \
+    decodedimagecache.h \
+    directoryscanner.h \
+    filereadahead.h \
+    folderwatcher.h \
+    imagecodecs.h \
+    imagelistsorter.h \
+    imagemetadatatable.h \
+    imageorientation.h \
+    imageresampler.h \
     imagewidget.h \
-    thumbnailwidget.h
+    jpegrestartdecoder.h \
+    mappedimagefile.h \
+    pixelbufferpool.h \
+    regionimagesource.h \
+    scanlinedownsampler.h \
+    tarcheckpointindex.h \
+    thumbnailwidget.h \
+    tiledimagerenderer.h
 
 # 资源文件
 RESOURCES += \
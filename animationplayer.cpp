@@ -0,0 +1,254 @@
+// animationplayer.cpp
+#include "animationplayer.h"
+#include "imageresampler.h"
+#include <QImageReader>
+#include <QTimer>
+#include <QtConcurrent>
+#include <QDebug>
+
+namespace {
+
+// 浏览器的惯例：不大于 10ms 的帧延迟按 100ms 处理，否则很多 GIF 会播放得过快
+const int kMaxTooFastDelay = 10;
+const int kDefaultFrameDelay = 100;
+// 落后墙钟超过该值（解码跟不上、窗口被挂起）时重新对齐，不连续快进追帧
+const qint64 kMaxLagMs = 250;
+
+int normalizedDelay(int delay)
+{
+    return delay <= kMaxTooFastDelay ? kDefaultFrameDelay : delay;
+}
+
+} // namespace
+
+AnimationPlayer::AnimationPlayer(QObject *parent)
+    : QObject(parent),
+      frameTimer(new QTimer(this)),
+      nextFrameDue(0),
+      active(false),
+      ringLimit(kDefaultRingBytes)
+{
+    decodePool.setMaxThreadCount(1);
+    frameTimer->setSingleShot(true);
+    frameTimer->setTimerType(Qt::PreciseTimer);
+    connect(frameTimer, &QTimer::timeout, this, &AnimationPlayer::presentFrame);
+}
+
+AnimationPlayer::~AnimationPlayer()
+{
+    stop();
+    decodePool.waitForDone();
+}
+
+bool AnimationPlayer::isAnimated(const QString &filePath)
+{
+    QImageReader reader(filePath);
+    if (!reader.canRead() || !reader.supportsAnimation()) {
+        return false;
+    }
+    // 部分插件在读完之前不知道帧数，返回 0
+    return reader.imageCount() != 1;
+}
+
+bool AnimationPlayer::start(const QString &filePath, const QSize &targetSize)
+{
+    stop();
+
+    QImageReader reader(filePath);
+    if (!reader.canRead() || !reader.supportsAnimation()) {
+        return false;
+    }
+
+    currentPath = filePath;
+    fullSize = reader.size();
+    state = QSharedPointer<DecodeState>::create();
+    state->ringLimit = ringLimit;
+    state->targetSize = targetSize;
+    clock.invalidate();
+    nextFrameDue = 0;
+    active = true;
+
+    qDebug() << "开始播放动画:" << filePath << "尺寸:" << fullSize << "帧数:" << reader.imageCount()
+             << "循环:" << reader.loopCount();
+
+    QSharedPointer<DecodeState> decodeState = state;
+    QPointer<AnimationPlayer> guard(this);
+    QtConcurrent::run(&decodePool, [decodeState, filePath, guard]() {
+        decodeLoop(decodeState, filePath, guard);
+    });
+    return true;
+}
+
+void AnimationPlayer::stop()
+{
+    frameTimer->stop();
+    if (state) {
+        QMutexLocker locker(&state->mutex);
+        state->stopRequested = true;
+        state->ring.clear();
+        state->ringBytes = 0;
+        state->spaceAvailable.wakeAll();
+    }
+    state.reset();
+    active = false;
+    currentPath.clear();
+    fullSize = QSize();
+}
+
+void AnimationPlayer::setTargetSize(const QSize &size)
+{
+    if (!state) {
+        return;
+    }
+    QMutexLocker locker(&state->mutex);
+    state->targetSize = size;
+}
+
+void AnimationPlayer::setRingLimit(qint64 bytes)
+{
+    ringLimit = qMax<qint64>(0, bytes);
+    if (state) {
+        QMutexLocker locker(&state->mutex);
+        state->ringLimit = ringLimit;
+        state->spaceAvailable.wakeAll();
+    }
+}
+
+void AnimationPlayer::decodeLoop(QSharedPointer<DecodeState> state, QString filePath,
+                                 QPointer<AnimationPlayer> guard)
+{
+    QImageReader reader(filePath);
+    // loopCount: -1 为无限循环，0 为只播放一遍，N 为再重复 N 遍
+    const int loopCount = reader.loopCount();
+    int pass = 0;
+    int framesInPass = 0;
+
+    forever {
+        QSize targetSize;
+        {
+            QMutexLocker locker(&state->mutex);
+            while (!state->stopRequested && state->ring.size() >= kMinQueuedFrames &&
+                   state->ringBytes >= state->ringLimit) {
+                state->spaceAvailable.wait(&state->mutex);
+            }
+            if (state->stopRequested) {
+                return;
+            }
+            targetSize = state->targetSize;
+        }
+
+        QImage image;
+        int delay = kDefaultFrameDelay;
+        if (reader.canRead()) {
+            image = reader.read();
+            delay = normalizedDelay(reader.nextImageDelay());
+        }
+
+        if (image.isNull()) {
+            // 一遍播放结束（或解码出错），按循环次数从头重新读取
+            ++pass;
+            bool again = framesInPass > 0 && (loopCount < 0 || pass <= loopCount);
+            if (!again) {
+                QMutexLocker locker(&state->mutex);
+                state->decodeFinished = true;
+                break;
+            }
+            framesInPass = 0;
+            reader.setFileName(filePath);
+            continue;
+        }
+        ++framesInPass;
+
+        // 大于显示尺寸的帧在这里缩小，界面线程只处理显示大小的图像
+        if (image.format() != QImage::Format_ARGB32_Premultiplied) {
+            image.convertTo(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied
+                                                    : QImage::Format_RGB32);
+        }
+        if (!targetSize.isEmpty() &&
+            (image.width() > targetSize.width() || image.height() > targetSize.height())) {
+            image = ImageResampler::scaled(image, targetSize, Qt::KeepAspectRatio);
+        }
+
+        QMutexLocker locker(&state->mutex);
+        if (state->stopRequested) {
+            return;
+        }
+        state->ring.enqueue({image, delay});
+        state->ringBytes += image.sizeInBytes();
+        if (!state->consumerWaiting) {
+            continue;
+        }
+        state->consumerWaiting = false;
+        locker.unlock();
+
+        if (guard) {
+            const DecodeState *source = state.data();
+            QMetaObject::invokeMethod(guard, [guard, source]() {
+                if (guard) {
+                    guard->onFrameDecoded(source);
+                }
+            }, Qt::QueuedConnection);
+        }
+    }
+
+    // 解码结束，通知界面线程（队列为空时由它发出 finished）
+    if (guard) {
+        const DecodeState *source = state.data();
+        QMetaObject::invokeMethod(guard, [guard, source]() {
+            if (guard) {
+                guard->onFrameDecoded(source);
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+void AnimationPlayer::onFrameDecoded(const DecodeState *source)
+{
+    // 忽略上一次播放的解码线程发来的通知
+    if (!active || state.data() != source || frameTimer->isActive()) {
+        return;
+    }
+    presentFrame();
+}
+
+void AnimationPlayer::presentFrame()
+{
+    if (!active || !state) {
+        return;
+    }
+
+    Frame frame;
+    {
+        QMutexLocker locker(&state->mutex);
+        if (state->ring.isEmpty()) {
+            if (state->decodeFinished) {
+                locker.unlock();
+                qDebug() << "动画播放完毕:" << currentPath;
+                active = false;
+                emit finished();
+                return;
+            }
+            // 解码跟不上，等下一帧解码完成后立即显示
+            state->consumerWaiting = true;
+            return;
+        }
+        frame = state->ring.dequeue();
+        state->ringBytes -= frame.image.sizeInBytes();
+        state->spaceAvailable.wakeOne();
+    }
+
+    if (!clock.isValid()) {
+        clock.start();
+        nextFrameDue = 0;
+    }
+
+    emit frameChanged(frame.image);
+
+    // 下一帧的时间点按墙钟累加，定时器的误差不会逐帧累积
+    const qint64 now = clock.elapsed();
+    nextFrameDue += frame.delay;
+    if (nextFrameDue < now - kMaxLagMs) {
+        nextFrameDue = now;
+    }
+    frameTimer->start(static_cast<int>(qMax<qint64>(0, nextFrameDue - now)));
+}
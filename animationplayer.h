@@ -0,0 +1,88 @@
+// animationplayer.h
+#ifndef ANIMATIONPLAYER_H
+#define ANIMATIONPLAYER_H
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <QPointer>
+
+class QTimer;
+
+// 动画播放（GIF / WebP 以及图片插件支持的其他多帧格式）
+// 后台线程提前解码帧放入按字节数限制的环形队列，大于显示尺寸的帧在解码线程中缩小；
+// 界面线程只负责按墙钟时间取出帧并发出 frameChanged。
+class AnimationPlayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AnimationPlayer(QObject *parent = nullptr);
+    ~AnimationPlayer() override;
+
+    // 文件是否是多帧动画
+    static bool isAnimated(const QString &filePath);
+
+    // 开始播放；targetSize 为显示尺寸（设备像素），为空时不缩小
+    bool start(const QString &filePath, const QSize &targetSize = QSize());
+    void stop();
+
+    bool isActive() const { return active; }
+    QString filePath() const { return currentPath; }
+    QSize frameSize() const { return fullSize; }  // 动画的原始尺寸
+
+    // 显示尺寸改变时调用，之后解码的帧按新尺寸缩小（已在队列中的帧不变）
+    void setTargetSize(const QSize &size);
+    // 环形队列上限（字节），至少保留 kMinQueuedFrames 帧
+    void setRingLimit(qint64 bytes);
+
+    static constexpr qint64 kDefaultRingBytes = 64 * 1024 * 1024;
+    static constexpr int kMinQueuedFrames = 2;
+
+signals:
+    void frameChanged(const QImage &frame);
+    void finished();  // 按循环次数播放完毕，最后一帧保持显示
+
+private:
+    struct Frame {
+        QImage image;
+        int delay;  // 毫秒
+    };
+
+    // 解码线程与界面线程共享的状态，每次 start 新建一份，旧线程只会写入自己的那份
+    struct DecodeState {
+        QMutex mutex;
+        QWaitCondition spaceAvailable;
+        QQueue<Frame> ring;
+        qint64 ringBytes = 0;
+        qint64 ringLimit = kDefaultRingBytes;
+        QSize targetSize;
+        bool stopRequested = false;
+        bool decodeFinished = false;
+        bool consumerWaiting = true;  // 界面线程在等待下一帧，解码后需要通知
+    };
+
+    static void decodeLoop(QSharedPointer<DecodeState> state, QString filePath,
+                           QPointer<AnimationPlayer> guard);
+    void onFrameDecoded(const DecodeState *source);
+    void presentFrame();
+
+    QSharedPointer<DecodeState> state;
+    QThreadPool decodePool;   // 单独的线程，不占用全局线程池
+    QTimer *frameTimer;
+    QElapsedTimer clock;
+    qint64 nextFrameDue;      // 下一帧应显示的时间点（相对 clock）
+    bool active;
+    QString currentPath;
+    QSize fullSize;
+    qint64 ringLimit;
+};
+
+#endif // ANIMATIONPLAYER_H
@@ -1,9 +1,20 @@
 #include "archivehandler.h"
+#include "archiveinput.h"
 #include <QFileInfo>
+#include <QFile>
 #include <QDebug>
-
-ArchiveHandler::ArchiveHandler() : archive(nullptr)
+#include <QtConcurrent>
+#include <algorithm>
+#include <climits>
+
+ArchiveHandler::ArchiveHandler() : archive(nullptr),
+    solidFormat(false),
+    compressedStream(false),
+    cursor(nullptr),
+    cursorOrder(0),
+    spillCache(128 * 1024 * 1024) // 128MB
 {
+    indexPool.setMaxThreadCount(1);
 }
 
 ArchiveHandler::~ArchiveHandler()
@@ -21,25 +32,33 @@ bool ArchiveHandler::isSupportedArchive(const QString &filePath)
             suffix == "tar" || suffix == "gz" || suffix == "bz2");
 }
 
+struct archive *ArchiveHandler::openReader() const
+{
+    struct archive *reader = archive_read_new();
+    archive_read_support_format_all(reader);
+    archive_read_support_filter_all(reader);
+
+    int r = ArchiveInput::open(reader, archivePath);
+    if (r != ARCHIVE_OK) {
+        qDebug() << "Failed to open archive:" << archivePath
+                 << archive_error_string(reader);
+        archive_read_free(reader);
+        return nullptr;
+    }
+    return reader;
+}
+
 bool ArchiveHandler::openArchive(const QString &filePath)
 {
     closeArchive();
 
-    archive = archive_read_new();
-    archive_read_support_format_all(archive);
-    archive_read_support_filter_all(archive);
-
-    int r = archive_read_open_filename(
-        archive, filePath.toLocal8Bit().constData(), 10240);
-    if (r != ARCHIVE_OK) {
-        qDebug() << "Failed to open archive:" << filePath
-                 << archive_error_string(archive);
-        archive_read_free(archive);
-        archive = nullptr;
+    archivePath = filePath;
+    archive = openReader();
+    if (!archive) {
+        archivePath.clear();
         return false;
     }
 
-    archivePath = filePath;
     return true;
 }
 
@@ -50,7 +69,27 @@ void ArchiveHandler::closeArchive()
         archive_read_free(archive);
         archive = nullptr;
     }
+    // 正在建立的索引：中止并等待，之后 archivePath 可以安全地清空
+    indexBuildCancelled.storeRelaxed(1);
+    indexPool.waitForDone();
+    indexBuildCancelled.storeRelaxed(0);
+    {
+        QMutexLocker locker(&indexMutex);
+        tarIndex.reset();
+    }
     archivePath.clear();
+
+    {
+        QMutexLocker locker(&cursorMutex);
+        resetCursor();
+        entryOrder.clear();
+        solidFormat = false;
+        compressedStream = false;
+    }
+
+    QMutexLocker locker(&spillMutex);
+    spillCache.clear();
+    upcomingFiles.clear();
 }
 
 QStringList ArchiveHandler::getImageFiles()
@@ -61,23 +100,58 @@ QStringList ArchiveHandler::getImageFiles()
 
     qDebug() << "=== 获取压缩包内图片文件列表 ===";
 
-    // 保存当前读取位置
-    int currentPosition = archive_read_header_position(archive);
+    // tar.gz：已有保存的检查点索引时直接列出条目，提取从最近的检查点开始；
+    // 否则在后台建立索引，这次仍按顺序扫描列出
+    if (TarCheckpointIndex::isCandidate(archivePath)) {
+        QSharedPointer<TarCheckpointIndex> index(new TarCheckpointIndex);
+        if (index->loadSaved(archivePath)) {
+            {
+                QMutexLocker locker(&indexMutex);
+                tarIndex = index;
+            }
+            const QStringList entryNames = index->entryNames();
+            for (const QString &entryName : entryNames) {
+                if (isImageFile(entryName)) {
+                    imageFiles.append(entryName);
+                }
+            }
+            qDebug() << "通过检查点索引找到" << entryNames.size() << "个文件，其中图片文件:" << imageFiles.size();
+            return imageFiles;
+        }
+        if (indexPool.activeThreadCount() == 0) {
+            startIndexBuild();
+        }
+    }
 
     // 重置到开始位置
     archive_read_free(archive);
-    archive = archive_read_new();
-    archive_read_support_format_all(archive);
-    archive_read_support_filter_all(archive);
-    archive_read_open_filename(archive, archivePath.toLocal8Bit().constData(), 10240);
+    archive = openReader();
+    if (!archive) return imageFiles;
+
+    QMutexLocker locker(&cursorMutex);
+    resetCursor();
+    entryOrder.clear();
 
     struct archive_entry *entry;
     int entryCount = 0;
+    int headerCount = 0;
     while (archive_read_next_header(archive, &entry) == ARCHIVE_OK) {
+        if (headerCount == 0) {
+            // 读到第一个条目后格式和过滤器才确定
+            int format = archive_format(archive) & ARCHIVE_FORMAT_BASE_MASK;
+            compressedStream = archive_filter_code(archive, 0) != ARCHIVE_FILTER_NONE;
+            if (format == ARCHIVE_FORMAT_7ZIP) {
+                solidFormat = true;
+            } else if (format == ARCHIVE_FORMAT_RAR || format == ARCHIVE_FORMAT_RAR_V5) {
+                solidFormat = detectSolidRar(archivePath);
+            }
+        }
+
         const char *filename = archive_entry_pathname(entry);
         if (filename) {
             QString filePath = QString::fromUtf8(filename);
             entryCount++;
+            entryOrder.insert(filePath, headerCount);
 
             qDebug() << "找到文件" << entryCount << ":" << filePath;
 
@@ -88,107 +162,300 @@ QStringList ArchiveHandler::getImageFiles()
                 qDebug() << "  ❌ 不是图片文件";
             }
         }
+        headerCount++;
         archive_read_data_skip(archive);
     }
 
     qDebug() << "总共找到" << entryCount << "个文件，其中图片文件:" << imageFiles.size();
+    qDebug() << "固实压缩:" << isSolid();
     qDebug() << "图片文件列表:" << imageFiles;
 
     // 重新打开以准备后续读取（保持原有逻辑）
     archive_read_free(archive);
-    archive = archive_read_new();
-    archive_read_support_format_all(archive);
-    archive_read_support_filter_all(archive);
-    archive_read_open_filename(archive, archivePath.toLocal8Bit().constData(), 10240);
+    archive = openReader();
 
     return imageFiles;
 }
 
-QByteArray ArchiveHandler::extractFile(const QString &filePath)
+bool ArchiveHandler::isSolid() const
 {
-    QByteArray data;
+    return solidFormat || (compressedStream && !currentTarIndex());
+}
 
-    if (!archive) {
-        qDebug() << "❌ ArchiveHandler: archive 为 null";
-        return data;
+void ArchiveHandler::startIndexBuild()
+{
+    const QString path = archivePath;
+    QtConcurrent::run(&indexPool, [this, path]() {
+        QSharedPointer<TarCheckpointIndex> index(new TarCheckpointIndex);
+        if (!index->loadOrBuild(path, &indexBuildCancelled)) {
+            return;
+        }
+        // closeArchive 会等待这里结束，archivePath 不会在途中改变
+        QMutexLocker locker(&indexMutex);
+        tarIndex = index;
+        qDebug() << "tar.gz 检查点索引已就绪，之后按检查点随机访问:" << path;
+    });
+}
+
+QSharedPointer<const TarCheckpointIndex> ArchiveHandler::currentTarIndex() const
+{
+    QMutexLocker locker(&indexMutex);
+    return tarIndex;
+}
+
+// RAR4 主头标志 0x0008 / RAR5 主头归档标志 0x0004 表示固实压缩
+bool ArchiveHandler::detectSolidRar(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray head = file.read(64);
+
+    auto byteAt = [&head](int index) -> int {
+        return index < head.size() ? static_cast<unsigned char>(head[index]) : -1;
+    };
+
+    if (head.startsWith(QByteArray("Rar!\x1a\x07\x01\x00", 8))) {
+        // RAR5: CRC32(4) + vint 头大小 + vint 类型 + vint 标志 [+ vint 附加区大小] [+ vint 数据大小] + vint 归档标志
+        int pos = 8 + 4;
+        auto readVint = [&]() -> quint64 {
+            quint64 value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                int b = byteAt(pos++);
+                if (b < 0) return 0;
+                value |= static_cast<quint64>(b & 0x7f) << shift;
+                if (!(b & 0x80)) break;
+            }
+            return value;
+        };
+        readVint();                       // 头大小
+        quint64 headerType = readVint();
+        quint64 headerFlags = readVint();
+        if (headerType != 1) return false; // 不是主归档头
+        if (headerFlags & 0x0001) readVint();
+        if (headerFlags & 0x0002) readVint();
+        quint64 archiveFlags = readVint();
+        return (archiveFlags & 0x0004) != 0;
     }
 
-    qDebug() << "=== ArchiveHandler 提取文件 ===";
-    qDebug() << "目标文件:" << filePath;
-    qDebug() << "当前archive路径:" << archivePath;
+    if (head.startsWith(QByteArray("Rar!\x1a\x07\x00", 7))) {
+        // RAR4: 标记块(7) + HEAD_CRC(2) + HEAD_TYPE(1) + HEAD_FLAGS(2)
+        if (byteAt(9) != 0x73) return false;
+        int flags = byteAt(10) | (byteAt(11) << 8);
+        return flags >= 0 && (flags & 0x0008) != 0;
+    }
 
-    // 使用新的archive实例来避免影响当前状态
-    struct archive *tempArchive = archive_read_new();
-    archive_read_support_format_all(tempArchive);
-    archive_read_support_filter_all(tempArchive);
+    return false;
+}
 
-    int r = archive_read_open_filename(tempArchive, archivePath.toLocal8Bit().constData(), 10240);
-    if (r != ARCHIVE_OK) {
-        qDebug() << "❌ 无法打开临时archive:" << archive_error_string(tempArchive);
-        archive_read_free(tempArchive);
-        return data;
+void ArchiveHandler::setSpillCacheLimit(int maxSizeMB)
+{
+    QMutexLocker locker(&spillMutex);
+    spillCache.setMaxCost(static_cast<qsizetype>(maxSizeMB) * 1024 * 1024);
+}
+
+qint64 ArchiveHandler::spillCacheLimit() const
+{
+    QMutexLocker locker(&spillMutex);
+    return spillCache.maxCost();
+}
+
+void ArchiveHandler::setUpcomingFiles(const QStringList &filePaths)
+{
+    QMutexLocker locker(&spillMutex);
+    upcomingFiles = QSet<QString>(filePaths.cbegin(), filePaths.cend());
+}
+
+void ArchiveHandler::storeInSpillCache(const QString &filePath, const QByteArray &data)
+{
+    if (data.isEmpty()) return;
+    QMutexLocker locker(&spillMutex);
+    spillCache.insert(filePath, new QByteArray(data), data.size());
+}
+
+void ArchiveHandler::resetCursor()
+{
+    if (cursor) {
+        archive_read_close(cursor);
+        archive_read_free(cursor);
+        cursor = nullptr;
+    }
+    cursorOrder = 0;
+}
+
+QByteArray ArchiveHandler::readEntryData(struct archive *reader)
+{
+    QByteArray data;
+    const void *buff;
+    size_t size;
+    la_int64_t offset;
+
+    while (archive_read_data_block(reader, &buff, &size, &offset) == ARCHIVE_OK) {
+        data.append(static_cast<const char *>(buff), size);
+    }
+    return data;
+}
+
+// 沿游标向前读取，依次取出目标条目；经过即将需要的条目时顺便保存
+void ArchiveHandler::readForward(const QStringList &sortedPaths,
+                                 QMap<QString, QByteArray> &results)
+{
+    QSet<QString> wanted(sortedPaths.cbegin(), sortedPaths.cend());
+    QSet<QString> upcoming;
+    {
+        QMutexLocker locker(&spillMutex);
+        upcoming = upcomingFiles;
+    }
+
+    // 游标已经越过第一个目标条目时只能从头开始
+    int firstOrder = entryOrder.value(sortedPaths.first(), -1);
+    if (!cursor || firstOrder < 0 || firstOrder < cursorOrder) {
+        resetCursor();
+        cursor = openReader();
+        if (!cursor) return;
     }
 
     struct archive_entry *entry;
-    bool found = false;
-    int scannedFiles = 0;
+    int passedEntries = 0;
+    while (!wanted.isEmpty() && archive_read_next_header(cursor, &entry) == ARCHIVE_OK) {
+        cursorOrder++;
+        passedEntries++;
 
-    while (archive_read_next_header(tempArchive, &entry) == ARCHIVE_OK) {
         const char *filename = archive_entry_pathname(entry);
-        scannedFiles++;
+        QString currentFile = filename ? QString::fromUtf8(filename) : QString();
 
-        if (filename) {
-            QString currentFile = QString::fromUtf8(filename);
-            qDebug() << "扫描文件" << scannedFiles << ":" << currentFile;
-
-            if (currentFile == filePath) {
-                qDebug() << "✅ 找到目标文件，开始提取数据";
-                found = true;
-
-                // 读取数据
-                const void *buff;
-                size_t size;
-                la_int64_t offset;
-                int dataBlocks = 0;
-                int totalSize = 0;
-
-                while (archive_read_data_block(tempArchive, &buff, &size, &offset) == ARCHIVE_OK) {
-                    data.append(static_cast<const char *>(buff), size);
-                    dataBlocks++;
-                    totalSize += size;
-                    qDebug() << "  数据块" << dataBlocks << "大小:" << size << "偏移:" << offset;
-                }
-                qDebug() << "提取完成: 数据块:" << dataBlocks << "总大小:" << totalSize;
-                break;
+        bool isWanted = wanted.contains(currentFile);
+        bool isUpcoming = false;
+        if (!isWanted && upcoming.contains(currentFile)) {
+            QMutexLocker locker(&spillMutex);
+            isUpcoming = !spillCache.contains(currentFile);
+        }
+
+        if (isWanted || isUpcoming) {
+            QByteArray data = readEntryData(cursor);
+            storeInSpillCache(currentFile, data);
+            if (isWanted) {
+                results.insert(currentFile, data);
+                wanted.remove(currentFile);
             }
+        } else {
+            archive_read_data_skip(cursor);
         }
-        archive_read_data_skip(tempArchive);
     }
 
-    if (!found) {
-        qDebug() << "❌ 未找到文件:" << filePath << "扫描了" << scannedFiles << "个文件";
+    qDebug() << "顺序读取经过" << passedEntries << "个条目，游标位置:" << cursorOrder;
 
-        // 输出前几个文件用于调试
-        qDebug() << "前5个文件:";
-        // 重新扫描输出前5个文件
-        archive_read_free(tempArchive);
-        tempArchive = archive_read_new();
-        archive_read_support_format_all(tempArchive);
-        archive_read_support_filter_all(tempArchive);
-        archive_read_open_filename(tempArchive, archivePath.toLocal8Bit().constData(), 10240);
+    if (!wanted.isEmpty()) {
+        qDebug() << "❌ 未找到文件:" << QStringList(wanted.cbegin(), wanted.cend());
+        resetCursor();
+    }
+}
 
-        for (int i = 0; i < 5 && archive_read_next_header(tempArchive, &entry) == ARCHIVE_OK; i++) {
-            const char *filename = archive_entry_pathname(entry);
-            if (filename) {
-                qDebug() << "  " << i+1 << ":" << QString::fromUtf8(filename);
+QMap<QString, QByteArray> ArchiveHandler::extractFiles(const QStringList &filePaths)
+{
+    QMap<QString, QByteArray> results;
+    QStringList missing;
+
+    {
+        QMutexLocker locker(&spillMutex);
+        for (const QString &filePath : filePaths) {
+            if (QByteArray *cached = spillCache.object(filePath)) {
+                results.insert(filePath, *cached);
+            } else if (!missing.contains(filePath)) {
+                missing.append(filePath);
             }
-            archive_read_data_skip(tempArchive);
         }
     }
 
-    archive_read_close(tempArchive);
-    archive_read_free(tempArchive);
+    if (missing.isEmpty() || archivePath.isEmpty()) {
+        return results;
+    }
+
+    // tar.gz 已建立检查点索引：每个条目都可以直接定位
+    const QSharedPointer<const TarCheckpointIndex> index = currentTarIndex();
+    if (index) {
+        QStringList failed;
+        for (const QString &filePath : std::as_const(missing)) {
+            QByteArray data = index->extract(filePath);
+            if (!data.isEmpty()) {
+                results.insert(filePath, data);
+            } else {
+                failed.append(filePath);
+            }
+        }
+        if (failed.isEmpty()) {
+            return results;
+        }
+        qDebug() << "检查点索引提取失败，回退到顺序扫描:" << failed;
+        missing = failed;
+    }
+
+    // 按条目在包内的顺序排序，合并为一次顺序读取
+    QMutexLocker locker(&cursorMutex);
+    std::sort(missing.begin(), missing.end(),
+              [this](const QString &a, const QString &b) {
+                  return entryOrder.value(a, INT_MAX) < entryOrder.value(b, INT_MAX);
+              });
+    if (!isSolid()) {
+        // 非固实：不需要共享游标，释放锁后用独立的读取器提取
+        locker.unlock();
+        readRandomAccess(missing, results);
+        return results;
+    }
+    readForward(missing, results);
+
+    return results;
+}
+
+// 非固实压缩包：每个条目单独压缩，跳过其他条目只需 seek，不解压
+void ArchiveHandler::readRandomAccess(const QStringList &sortedPaths,
+                                      QMap<QString, QByteArray> &results)
+{
+    struct archive *reader = openReader();
+    if (!reader) return;
+
+    QSet<QString> wanted(sortedPaths.cbegin(), sortedPaths.cend());
+    struct archive_entry *entry;
+    while (!wanted.isEmpty() && archive_read_next_header(reader, &entry) == ARCHIVE_OK) {
+        const char *filename = archive_entry_pathname(entry);
+        QString currentFile = filename ? QString::fromUtf8(filename) : QString();
+
+        if (wanted.remove(currentFile)) {
+            QByteArray data = readEntryData(reader);
+            storeInSpillCache(currentFile, data);
+            results.insert(currentFile, data);
+        } else {
+            archive_read_data_skip(reader);
+        }
+    }
+
+    archive_read_close(reader);
+    archive_read_free(reader);
+
+    if (!wanted.isEmpty()) {
+        qDebug() << "❌ 未找到文件:" << QStringList(wanted.cbegin(), wanted.cend());
+    }
+}
+
+void ArchiveHandler::prefetchFiles(const QStringList &filePaths)
+{
+    extractFiles(filePaths);
+}
+
+QByteArray ArchiveHandler::extractFile(const QString &filePath)
+{
+    if (!archive) {
+        qDebug() << "❌ ArchiveHandler: archive 为 null";
+        return QByteArray();
+    }
+
+    qDebug() << "=== ArchiveHandler 提取文件 ===";
+    qDebug() << "目标文件:" << filePath;
+    qDebug() << "当前archive路径:" << archivePath;
 
+    QByteArray data = extractFiles(QStringList{filePath}).value(filePath);
+    qDebug() << "提取完成，大小:" << data.size();
     return data;
 }
 
@@ -4,9 +4,19 @@
 #include <QString>
 #include <QStringList>
 #include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QCache>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QAtomicInt>
 #include <archive.h>
 #include <archive_entry.h>
 
+#include "tarcheckpointindex.h"
+
 class ArchiveHandler
 {
 public:
@@ -28,6 +38,24 @@ public:
     // 从压缩包中提取文件到内存
     QByteArray extractFile(const QString &filePath);
 
+    // 批量提取：按包内顺序排序后合并为一次顺序读取（固实压缩包只解压一遍）
+    QMap<QString, QByteArray> extractFiles(const QStringList &filePaths);
+
+    // 预取：提取到暂存缓存中，之后的 extractFile 直接命中
+    void prefetchFiles(const QStringList &filePaths);
+
+    // 设置即将需要的条目，顺序读取途中经过它们时顺便保存到暂存缓存
+    void setUpcomingFiles(const QStringList &filePaths);
+
+    // 固实压缩包（7z、固实 RAR、未建索引的 tar.gz/tar.bz2）提取第 k 个条目需要解压之前的全部数据：
+    // 请求沿共享的顺序读取游标进行，经过即将需要的条目时保存到暂存缓存。
+    // 其他压缩包（zip、非固实 RAR、tar）每次请求使用独立的读取器跳到目标条目，多个线程可以并行提取
+    bool isSolid() const;
+
+    // 暂存缓存上限（MB）
+    void setSpillCacheLimit(int maxSizeMB);
+    qint64 spillCacheLimit() const;
+
     // 获取压缩包基本信息
     QString getArchivePath() const { return archivePath; }
     bool isOpen() const { return archive != nullptr; }
@@ -36,6 +64,38 @@ private:
     struct archive *archive;
     QString archivePath;
 
+    // tar.gz 检查点索引（用于随机访问）。没有保存的索引时在后台完整扫描一次建立，
+    // 建好之前按普通固实压缩包顺序读取
+    QSharedPointer<const TarCheckpointIndex> tarIndex;
+    mutable QMutex indexMutex;
+    QThreadPool indexPool;
+    QAtomicInt indexBuildCancelled;
+    void startIndexBuild();
+    QSharedPointer<const TarCheckpointIndex> currentTarIndex() const;
+
+    // 固实块信息：libarchive 不提供 7z 文件夹边界，固实格式整体视为一个块
+    bool solidFormat;
+    bool compressedStream;
+    QHash<QString, int> entryOrder;   // 条目在包内的顺序
+
+    // 顺序读取游标：连续的批量请求沿同一次顺序读取继续，不必每次从头解压
+    struct archive *cursor;
+    int cursorOrder;                  // 游标下一个要读取的条目序号
+    QMutex cursorMutex;
+
+    // 已解压条目的暂存缓存（按字节限制）
+    QCache<QString, QByteArray> spillCache;
+    QSet<QString> upcomingFiles;
+    mutable QMutex spillMutex;
+
+    struct archive *openReader() const;
+    void resetCursor();
+    void readForward(const QStringList &sortedPaths, QMap<QString, QByteArray> &results);
+    void readRandomAccess(const QStringList &sortedPaths, QMap<QString, QByteArray> &results);
+    QByteArray readEntryData(struct archive *reader);
+    void storeInSpillCache(const QString &filePath, const QByteArray &data);
+    static bool detectSolidRar(const QString &filePath);
+
     // 检查文件是否是图片
     bool isImageFile(const QString &fileName);
 };
@@ -0,0 +1,155 @@
+// archiveinput.cpp
+#include "archiveinput.h"
+#include <QFile>
+#include <QByteArray>
+#include <QMutex>
+#include <QDebug>
+#include <cerrno>
+#include <cstdio>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+QMutex optionsMutex;
+ArchiveInput::Options globalOptions;
+
+// 每个读取器独立的数据源，由 close 回调释放
+struct InputSource {
+    QFile file;
+    uchar *mapped = nullptr;
+    qint64 size = 0;
+    qint64 position = 0;
+    int blockSize = 0;
+    QByteArray buffer;
+};
+
+la_ssize_t readCallback(struct archive *reader, void *clientData, const void **buffer)
+{
+    InputSource *source = static_cast<InputSource *>(clientData);
+
+    if (source->mapped) {
+        qint64 length = qMin<qint64>(source->blockSize, source->size - source->position);
+        *buffer = source->mapped + source->position;
+        source->position += length;
+        return static_cast<la_ssize_t>(length);
+    }
+
+    qint64 length = source->file.read(source->buffer.data(), source->blockSize);
+    if (length < 0) {
+        archive_set_error(reader, EIO, "%s", source->file.errorString().toLocal8Bit().constData());
+        return -1;
+    }
+    *buffer = source->buffer.constData();
+    source->position += length;
+    return static_cast<la_ssize_t>(length);
+}
+
+la_int64_t skipCallback(struct archive *, void *clientData, la_int64_t request)
+{
+    InputSource *source = static_cast<InputSource *>(clientData);
+    qint64 target = qMin(source->position + request, source->size);
+    qint64 skipped = target - source->position;
+
+    if (!source->mapped && !source->file.seek(target)) {
+        return 0;
+    }
+    source->position = target;
+    return skipped;
+}
+
+la_int64_t seekCallback(struct archive *, void *clientData, la_int64_t offset, int whence)
+{
+    InputSource *source = static_cast<InputSource *>(clientData);
+    qint64 target = offset;
+    if (whence == SEEK_CUR) {
+        target = source->position + offset;
+    } else if (whence == SEEK_END) {
+        target = source->size + offset;
+    }
+    if (target < 0 || target > source->size) {
+        return ARCHIVE_FATAL;
+    }
+
+    if (!source->mapped && !source->file.seek(target)) {
+        return ARCHIVE_FATAL;
+    }
+    source->position = target;
+    return target;
+}
+
+int closeCallback(struct archive *, void *clientData)
+{
+    InputSource *source = static_cast<InputSource *>(clientData);
+    if (source->mapped) {
+        source->file.unmap(source->mapped);
+    }
+    delete source;
+    return ARCHIVE_OK;
+}
+
+} // namespace
+
+ArchiveInput::Options ArchiveInput::defaultOptions()
+{
+    QMutexLocker locker(&optionsMutex);
+    return globalOptions;
+}
+
+void ArchiveInput::setDefaultOptions(const Options &options)
+{
+    QMutexLocker locker(&optionsMutex);
+    globalOptions = options;
+    globalOptions.blockSize = qMax(4096, options.blockSize);
+}
+
+QString ArchiveInput::modeName(Mode mode)
+{
+    return mode == MemoryMapped ? QStringLiteral("mmap") : QStringLiteral("read");
+}
+
+int ArchiveInput::open(struct archive *reader, const QString &filePath, const Options &options)
+{
+    InputSource *source = new InputSource;
+    source->file.setFileName(filePath);
+    source->blockSize = qMax(4096, options.blockSize);
+
+    if (!source->file.open(QIODevice::ReadOnly)) {
+        archive_set_error(reader, ENOENT, "%s", source->file.errorString().toLocal8Bit().constData());
+        delete source;
+        return ARCHIVE_FATAL;
+    }
+    source->size = source->file.size();
+
+    if (options.mode == MemoryMapped && source->size > 0) {
+        source->mapped = source->file.map(0, source->size);
+        if (!source->mapped) {
+            qDebug() << "压缩包内存映射失败，回退到顺序读取:" << filePath;
+        }
+    }
+
+#ifdef Q_OS_LINUX
+    // 提示内核按顺序预读
+    if (source->mapped) {
+        madvise(source->mapped, static_cast<size_t>(source->size), MADV_SEQUENTIAL);
+    } else {
+        posix_fadvise(source->file.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+
+    if (!source->mapped) {
+        source->buffer.resize(source->blockSize);
+    }
+
+    archive_read_set_callback_data(reader, source);
+    archive_read_set_read_callback(reader, readCallback);
+    archive_read_set_skip_callback(reader, skipCallback);
+    archive_read_set_seek_callback(reader, seekCallback);
+    archive_read_set_close_callback(reader, closeCallback);
+
+    // source 由 close 回调释放（打开失败时在 archive_read_free 中调用）
+    return archive_read_open1(reader);
+}
@@ -0,0 +1,35 @@
+// archiveinput.h
+#ifndef ARCHIVEINPUT_H
+#define ARCHIVEINPUT_H
+
+#include <QString>
+#include <archive.h>
+
+// libarchive 输入层：内存映射整个压缩包，或按大块顺序读取
+// 替代 archive_read_open_filename(..., 10240) 每 10KB 一次系统调用的读取方式
+class ArchiveInput
+{
+public:
+    enum Mode {
+        MemoryMapped,   // 映射文件，直接把映射区交给 libarchive，无拷贝
+        BufferedRead    // 大块顺序读取 + posix_fadvise(SEQUENTIAL)
+    };
+
+    struct Options {
+        Mode mode = MemoryMapped;
+        int blockSize = 1024 * 1024;   // 每次交给 libarchive 的字节数
+    };
+
+    // 全局默认选项（可由命令行调整）
+    static Options defaultOptions();
+    static void setDefaultOptions(const Options &options);
+
+    // 为已设置好格式/过滤器的读取器打开输入，返回 libarchive 状态码
+    // 映射失败时自动回退到顺序读取
+    static int open(struct archive *reader, const QString &filePath,
+                    const Options &options = defaultOptions());
+
+    static QString modeName(Mode mode);
+};
+
+#endif // ARCHIVEINPUT_H
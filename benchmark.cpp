@@ -0,0 +1,392 @@
+// benchmark.cpp
+#include "benchmark.h"
+#include "archiveinput.h"
+#include "imagecodecs.h"
+#include "jpegrestartdecoder.h"
+#include "pixelbufferpool.h"
+#include "imageresampler.h"
+#include <QDirIterator>
+#include <QFile>
+#include <QMap>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QVector>
+#include <QImage>
+#include <QRandomGenerator>
+#include <archive.h>
+#include <archive_entry.h>
+
+namespace {
+
+struct ArchiveRunResult {
+    bool ok = false;
+    QString formatName;
+    int entries = 0;
+    qint64 bytes = 0;       // 提取出的未压缩字节数
+    qint64 elapsedNs = 0;
+};
+
+struct ArchiveInputConfig {
+    QString label;
+    bool useFilename;       // 基准：原来的 archive_read_open_filename(..., 10240)
+    ArchiveInput::Options options;
+};
+
+ArchiveRunResult runArchivePass(const QString &path, const ArchiveInputConfig &config, bool extract)
+{
+    ArchiveRunResult result;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    struct archive *reader = archive_read_new();
+    archive_read_support_format_all(reader);
+    archive_read_support_filter_all(reader);
+
+    int r = config.useFilename
+                ? archive_read_open_filename(reader, path.toLocal8Bit().constData(), 10240)
+                : ArchiveInput::open(reader, path, config.options);
+    if (r != ARCHIVE_OK) {
+        archive_read_free(reader);
+        return result;
+    }
+
+    struct archive_entry *entry;
+    while (archive_read_next_header(reader, &entry) == ARCHIVE_OK) {
+        if (result.entries == 0) {
+            result.formatName = QString::fromUtf8(archive_format_name(reader));
+        }
+        result.entries++;
+
+        if (extract) {
+            const void *buff;
+            size_t size;
+            la_int64_t offset;
+            while (archive_read_data_block(reader, &buff, &size, &offset) == ARCHIVE_OK) {
+                result.bytes += static_cast<qint64>(size);
+            }
+        } else {
+            archive_read_data_skip(reader);
+        }
+    }
+
+    archive_read_close(reader);
+    archive_read_free(reader);
+
+    result.elapsedNs = timer.nsecsElapsed();
+    result.ok = true;
+    return result;
+}
+
+double megabytesPerSecond(qint64 bytes, qint64 elapsedNs)
+{
+    if (elapsedNs <= 0) return 0.0;
+    return (bytes / (1024.0 * 1024.0)) / (elapsedNs / 1e9);
+}
+
+// 渐变加噪声的合成图，避免纯色输入让某些实现走捷径
+QImage syntheticImage(const QSize &size)
+{
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    QRandomGenerator random(42);
+    for (int y = 0; y < size.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            int noise = random.bounded(32);
+            line[x] = qRgb((x * 255 / size.width() + noise) & 0xff,
+                           (y * 255 / size.height() + noise) & 0xff,
+                           ((x ^ y) + noise) & 0xff);
+        }
+    }
+    return image;
+}
+
+// 取三次中最快的一次
+template <typename Fn>
+qint64 bestOfThree(Fn fn)
+{
+    qint64 best = -1;
+    for (int i = 0; i < 3; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        fn();
+        qint64 elapsed = timer.nsecsElapsed();
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+// 基准期间的像素缓冲池命中情况
+void reportPool(QTextStream &out)
+{
+    const PixelBufferPool::Stats stats = PixelBufferPool::shared().stats();
+    const quint64 requests = stats.hits + stats.misses;
+    out << "\n像素缓冲池: 请求 " << requests << "，命中 " << stats.hits
+        << " (" << QString::number(requests ? 100.0 * stats.hits / requests : 0.0, 'f', 1) << "%)"
+        << "，复用 " << stats.bytesRecycled / (1024 * 1024) << " MB"
+        << "，新分配 " << stats.bytesAllocated / (1024 * 1024) << " MB\n";
+}
+
+} // namespace
+
+int Benchmark::runArchiveBenchmark(const QStringList &archivePaths)
+{
+    QTextStream out(stdout);
+
+    QVector<ArchiveInputConfig> configs;
+    configs.append({"filename 10K", true, ArchiveInput::Options()});
+    for (int blockKB : {64, 1024, 4096}) {
+        ArchiveInput::Options options;
+        options.mode = ArchiveInput::BufferedRead;
+        options.blockSize = blockKB * 1024;
+        configs.append({QString("read %1K").arg(blockKB), false, options});
+    }
+    for (int blockKB : {1024, 4096}) {
+        ArchiveInput::Options options;
+        options.mode = ArchiveInput::MemoryMapped;
+        options.blockSize = blockKB * 1024;
+        configs.append({QString("mmap %1K").arg(blockKB), false, options});
+    }
+
+    out << "压缩包输入层基准（第一轮可能受冷缓存影响，建议运行两次）\n";
+
+    for (const QString &path : archivePaths) {
+        QFileInfo fileInfo(path);
+        if (!fileInfo.exists()) {
+            out << "文件不存在: " << path << "\n";
+            continue;
+        }
+
+        out << "\n== " << fileInfo.fileName() << " (" << fileInfo.size() / (1024 * 1024) << " MB) ==\n";
+        out << qSetFieldWidth(14) << Qt::left << "input"
+            << qSetFieldWidth(10) << "format"
+            << qSetFieldWidth(9) << "entries"
+            << qSetFieldWidth(12) << "scan ms"
+            << qSetFieldWidth(12) << "scan MB/s"
+            << qSetFieldWidth(12) << "extract ms"
+            << qSetFieldWidth(12) << "extract MB/s"
+            << qSetFieldWidth(0) << "\n";
+
+        for (const ArchiveInputConfig &config : std::as_const(configs)) {
+            ArchiveRunResult scan = runArchivePass(path, config, false);
+            ArchiveRunResult extract = runArchivePass(path, config, true);
+            if (!scan.ok || !extract.ok) {
+                out << config.label << ": 无法打开\n";
+                continue;
+            }
+
+            // 扫描吞吐量按压缩包大小计算，提取吞吐量按解压后的数据量计算
+            out << qSetFieldWidth(14) << config.label
+                << qSetFieldWidth(10) << scan.formatName.left(9)
+                << qSetFieldWidth(9) << scan.entries
+                << qSetFieldWidth(12) << QString::number(scan.elapsedNs / 1e6, 'f', 1)
+                << qSetFieldWidth(12) << QString::number(megabytesPerSecond(fileInfo.size(), scan.elapsedNs), 'f', 1)
+                << qSetFieldWidth(12) << QString::number(extract.elapsedNs / 1e6, 'f', 1)
+                << qSetFieldWidth(12) << QString::number(megabytesPerSecond(extract.bytes, extract.elapsedNs), 'f', 1)
+                << qSetFieldWidth(0) << "\n";
+            out.flush();
+        }
+    }
+
+    return 0;
+}
+
+int Benchmark::runResampleBenchmark(const QStringList &imagePaths)
+{
+    QTextStream out(stdout);
+
+    QVector<QPair<QString, QImage>> inputs;
+    for (const QString &path : imagePaths) {
+        QImage image(path);
+        if (image.isNull()) {
+            out << "无法加载: " << path << "\n";
+            continue;
+        }
+        inputs.append(qMakePair(QFileInfo(path).fileName(),
+                                image.convertToFormat(QImage::Format_ARGB32_Premultiplied)));
+    }
+    if (inputs.isEmpty()) {
+        inputs.append(qMakePair(QString("synthetic"), syntheticImage(QSize(6000, 4000))));
+    }
+
+    QVector<ImageResampler::Kernel> kernels;
+    for (ImageResampler::Kernel kernel : {ImageResampler::ScalarKernel, ImageResampler::Sse41Kernel,
+                                          ImageResampler::Avx2Kernel, ImageResampler::NeonKernel}) {
+        if (ImageResampler::isKernelSupported(kernel)) {
+            kernels.append(kernel);
+        }
+    }
+
+    out << "图像缩放基准（三次取最快，自动选择: "
+        << ImageResampler::kernelName(ImageResampler::activeKernel()) << "）\n";
+
+    for (const auto &input : std::as_const(inputs)) {
+        const QImage &image = input.second;
+        const QSize fitSize = image.size().scaled(QSize(1920, 1080), Qt::KeepAspectRatio);
+        const QSize thumbSize = image.size().scaled(QSize(150, 150), Qt::KeepAspectRatio);
+        const QImage crop = image.copy(0, 0, qMin(512, image.width()), qMin(512, image.height()));
+
+        struct Target {
+            QString label;
+            const QImage *source;
+            QSize size;
+        };
+        const QVector<Target> targets = {
+            {"fit", &image, fitSize},
+            {"thumb", &image, thumbSize},
+            {"up 2x", &crop, crop.size() * 2},
+        };
+
+        out << "\n== " << input.first << " " << image.width() << "x" << image.height() << " ==\n";
+        out << qSetFieldWidth(8) << Qt::left << "target"
+            << qSetFieldWidth(12) << "size"
+            << qSetFieldWidth(16) << "method"
+            << qSetFieldWidth(10) << "kernel"
+            << qSetFieldWidth(10) << "ms"
+            << qSetFieldWidth(12) << "in Mpix/s"
+            << qSetFieldWidth(0) << "\n";
+
+        for (const Target &target : targets) {
+            const double inputMegapixels = target.source->width() * double(target.source->height()) / 1e6;
+            const QString sizeText = QString("%1x%2").arg(target.size.width()).arg(target.size.height());
+
+            auto report = [&](const QString &method, const QString &kernel, qint64 ns) {
+                out << qSetFieldWidth(8) << target.label
+                    << qSetFieldWidth(12) << sizeText
+                    << qSetFieldWidth(16) << method
+                    << qSetFieldWidth(10) << kernel
+                    << qSetFieldWidth(10) << QString::number(ns / 1e6, 'f', 2)
+                    << qSetFieldWidth(12) << QString::number(inputMegapixels / (ns / 1e9), 'f', 1)
+                    << qSetFieldWidth(0) << "\n";
+                out.flush();
+            };
+
+            report("QImage::scaled", "-", bestOfThree([&]() {
+                target.source->scaled(target.size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            }));
+
+            for (ImageResampler::Filter filter : {ImageResampler::Area, ImageResampler::Lanczos3}) {
+                const QString method = filter == ImageResampler::Area ? "area" : "lanczos3";
+                for (ImageResampler::Kernel kernel : std::as_const(kernels)) {
+                    ImageResampler::setKernel(kernel);
+                    report(method, ImageResampler::kernelName(kernel), bestOfThree([&]() {
+                        ImageResampler::scaled(*target.source, target.size, filter);
+                    }));
+                }
+            }
+            ImageResampler::setKernel(ImageResampler::AutoKernel);
+        }
+    }
+
+    reportPool(out);
+    return 0;
+}
+
+int Benchmark::runCodecBenchmark(const QStringList &paths)
+{
+    QTextStream out(stdout);
+
+    QStringList files;
+    for (const QString &path : paths) {
+        if (QFileInfo(path).isDir()) {
+            QDirIterator it(path, QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                files.append(it.next());
+            }
+        } else {
+            files.append(path);
+        }
+    }
+    if (files.isEmpty()) {
+        out << "用法: PictureView --bench-codecs <图片或目录>...\n";
+        return 1;
+    }
+
+    struct CodecTotals {
+        int files = 0;
+        int failures = 0;
+        double megapixels = 0;
+        qint64 fullNs = 0;
+        qint64 thumbNs = 0;
+    };
+    QMap<QString, CodecTotals> totals;   // "格式 后端" → 汇总
+    int skipped = 0;
+
+    const QSize thumbBox(150, 150);
+    for (const QString &filePath : std::as_const(files)) {
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            ++skipped;
+            continue;
+        }
+        const QByteArray bytes = file.readAll();
+        const QByteArray format = ImageCodecs::detectFormat(bytes);
+        if (format.isEmpty()) {
+            ++skipped;
+            continue;
+        }
+
+        struct Run {
+            ImageCodecs::Backend backend;
+            bool parallel;      // JPEG 是否允许按重启标记并行
+            QString label;
+        };
+        QVector<Run> runs = {{ImageCodecs::QtPlugin, false, ImageCodecs::backendName(ImageCodecs::QtPlugin)}};
+        const ImageCodecs::Backend direct = ImageCodecs::backendFor(format);
+        if (direct == ImageCodecs::TurboJpeg && JpegRestartDecoder(bytes).isValid()) {
+            runs.append({direct, false, ImageCodecs::backendName(direct)});
+            runs.append({direct, true, ImageCodecs::backendName(direct) + "+rst"});
+        } else if (direct != ImageCodecs::QtPlugin) {
+            runs.append({direct, true, ImageCodecs::backendName(direct)});
+        }
+
+        for (const Run &run : std::as_const(runs)) {
+            const ImageCodecs::Backend backend = run.backend;
+            JpegRestartDecoder::setParallelEnabled(run.parallel);
+            CodecTotals &total = totals[QString("%1 %2").arg(QString::fromLatin1(format), run.label)];
+            const QImage full = ImageCodecs::decodeWith(backend, bytes, format);
+            if (full.isNull()) {
+                ++total.failures;
+                continue;
+            }
+            const QSize thumbSize = full.size().scaled(thumbBox, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+
+            ++total.files;
+            total.megapixels += full.width() * double(full.height()) / 1e6;
+            total.fullNs += bestOfThree([&]() {
+                ImageCodecs::decodeWith(backend, bytes, format);
+            });
+            // 缩略图：允许缩放解码，再缩小到最终尺寸
+            total.thumbNs += bestOfThree([&]() {
+                ImageResampler::scaled(ImageCodecs::decodeWith(backend, bytes, format, thumbBox), thumbSize);
+            });
+        }
+    }
+    JpegRestartDecoder::setParallelEnabled(true);
+
+    out << "解码器基准（三次取最快，" << files.size() << " 个文件，跳过 " << skipped << " 个）\n";
+    out << qSetFieldWidth(20) << Qt::left << "format/backend"
+        << qSetFieldWidth(8) << "files"
+        << qSetFieldWidth(8) << "failed"
+        << qSetFieldWidth(12) << "full ms"
+        << qSetFieldWidth(10) << "Mpix/s"
+        << qSetFieldWidth(12) << "thumb ms"
+        << qSetFieldWidth(0) << "\n";
+    for (auto it = totals.constBegin(); it != totals.constEnd(); ++it) {
+        const CodecTotals &total = it.value();
+        const double fullMs = total.fullNs / 1e6;
+        out << qSetFieldWidth(20) << it.key()
+            << qSetFieldWidth(8) << total.files
+            << qSetFieldWidth(8) << total.failures
+            << qSetFieldWidth(12) << QString::number(fullMs, 'f', 1)
+            << qSetFieldWidth(10) << QString::number(total.fullNs > 0 ? total.megapixels / (total.fullNs / 1e9) : 0.0, 'f', 1)
+            << qSetFieldWidth(12) << QString::number(total.thumbNs / 1e6, 'f', 1)
+            << qSetFieldWidth(0) << "\n";
+    }
+
+    reportPool(out);
+    return 0;
+}
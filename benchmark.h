@@ -0,0 +1,25 @@
+// benchmark.h
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QStringList>
+
+// 命令行基准测试（不启动界面），用于选择合理的默认参数
+namespace Benchmark {
+
+// 压缩包输入层：对比 archive_read_open_filename(10KB)、不同块大小的顺序读取和内存映射
+// 分别统计扫描（只读条目头）和提取（读出全部数据）的吞吐量
+int runArchiveBenchmark(const QStringList &archivePaths);
+
+// 图像缩放：对比 QImage::scaled(SmoothTransformation) 与 ImageResampler 各指令集实现
+// 未指定图片时使用 6000x4000 的合成图
+int runResampleBenchmark(const QStringList &imagePaths);
+
+// 解码器：对比 Qt 插件与直接后端（TurboJPEG / libpng / libwebp）
+// 参数可以是图片或目录（递归），按格式和后端汇总完整解码和缩略图解码的耗时
+// 带重启标记的 JPEG 另外统计按段并行解码（turbojpeg+rst）
+int runCodecBenchmark(const QStringList &paths);
+
+}
+
+#endif // BENCHMARK_H
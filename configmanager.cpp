@@ -11,7 +11,17 @@ ConfigManager::Config::Config() :
     windowMaximized(false),
     transparentBackground(false),
     titleBarVisible(true),
-    alwaysOnTop(false) {}
+    alwaysOnTop(false),
+    prefetchAhead(3),
+    prefetchBehind(1),
+    readAheadWindow(20),
+    directCodecs(true),
+    archiveLookahead(8),
+    archiveSpillCacheMB(128),
+    thumbnailCacheMB(128),
+    sortMode("natural"),
+    recursiveListing(false),
+    recursiveMaxDepth(16) {}
 
 // ConfigManager 构造函数
 ConfigManager::ConfigManager(const QString& filename)
@@ -47,6 +57,24 @@ bool ConfigManager::saveConfig(const Config& config)
     settings.setValue("LastOpenPath", config.lastOpenPath);
     settings.endGroup();
 
+    // 保存预取窗口和解码器设置
+    settings.beginGroup("Performance");
+    settings.setValue("PrefetchAhead", config.prefetchAhead);
+    settings.setValue("PrefetchBehind", config.prefetchBehind);
+    settings.setValue("ReadAheadWindow", config.readAheadWindow);
+    settings.setValue("DirectCodecs", config.directCodecs);
+    settings.setValue("ArchiveLookahead", config.archiveLookahead);
+    settings.setValue("ArchiveSpillCacheMB", config.archiveSpillCacheMB);
+    settings.setValue("ThumbnailCacheMB", config.thumbnailCacheMB);
+    settings.endGroup();
+
+    // 保存浏览设置
+    settings.beginGroup("Browse");
+    settings.setValue("SortMode", config.sortMode);
+    settings.setValue("Recursive", config.recursiveListing);
+    settings.setValue("RecursiveMaxDepth", config.recursiveMaxDepth);
+    settings.endGroup();
+
     settings.sync();
     return (settings.status() == QSettings::NoError);
 }
@@ -86,6 +114,24 @@ ConfigManager::Config ConfigManager::loadConfig()
     config.lastOpenPath = settings.value("LastOpenPath", config.lastOpenPath).toString();
     settings.endGroup();
 
+    // 加载预取窗口和解码器设置
+    settings.beginGroup("Performance");
+    config.prefetchAhead = settings.value("PrefetchAhead", config.prefetchAhead).toInt();
+    config.prefetchBehind = settings.value("PrefetchBehind", config.prefetchBehind).toInt();
+    config.readAheadWindow = settings.value("ReadAheadWindow", config.readAheadWindow).toInt();
+    config.directCodecs = settings.value("DirectCodecs", config.directCodecs).toBool();
+    config.archiveLookahead = settings.value("ArchiveLookahead", config.archiveLookahead).toInt();
+    config.archiveSpillCacheMB = settings.value("ArchiveSpillCacheMB", config.archiveSpillCacheMB).toInt();
+    config.thumbnailCacheMB = settings.value("ThumbnailCacheMB", config.thumbnailCacheMB).toInt();
+    settings.endGroup();
+
+    // 加载浏览设置
+    settings.beginGroup("Browse");
+    config.sortMode = settings.value("SortMode", config.sortMode).toString();
+    config.recursiveListing = settings.value("Recursive", config.recursiveListing).toBool();
+    config.recursiveMaxDepth = settings.value("RecursiveMaxDepth", config.recursiveMaxDepth).toInt();
+    settings.endGroup();
+
     qDebug() << "Config loaded from:" << configPath;
     return config;
 }
@@ -27,6 +27,25 @@ public:
         // 最近打开文件路径
         QString lastOpenPath;
 
+        // 单张浏览时沿浏览方向 / 反方向预取的张数
+        int prefetchAhead;
+        int prefetchBehind;
+        // 只预读压缩数据的窗口（张数）
+        int readAheadWindow;
+        // JPEG/PNG/WebP 使用直接解码后端（关闭后全部走 Qt 插件）
+        bool directCodecs;
+        // 固实压缩包顺序读取时保存的后续条目数，以及暂存缓存上限（MB）
+        int archiveLookahead;
+        int archiveSpillCacheMB;
+        // 缩略图缓存上限（MB），超出后最久未绘制的缩略图被淘汰，滚动回来时重新加载
+        int thumbnailCacheMB;
+
+        // 图片列表排序方式（ImageListSorter::modeName）
+        QString sortMode;
+        // 递归浏览子文件夹及最大深度
+        bool recursiveListing;
+        int recursiveMaxDepth;
+
         // 默认构造函数
         Config();
     };
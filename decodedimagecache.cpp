@@ -0,0 +1,131 @@
+// decodedimagecache.cpp
+#include "decodedimagecache.h"
+#include <QDebug>
+
+DecodedImageCache &DecodedImageCache::shared()
+{
+    static DecodedImageCache instance;
+    return instance;
+}
+
+DecodedImageCache::DecodedImageCache()
+{
+    caches[FullImages].setMaxCost(kDefaultFullImageBudget);
+    caches[Thumbnails].setMaxCost(kDefaultThumbnailBudget);
+}
+
+bool DecodedImageCache::lookup(Namespace space, const QString &key, DecodedImage *result)
+{
+    QMutexLocker locker(&mutex);
+    DecodedImage *image = caches[space].object(key);
+    if (!image) {
+        return false;
+    }
+    if (result) {
+        *result = *image;
+    }
+    return true;
+}
+
+QImage DecodedImageCache::lookupImage(Namespace space, const QString &key)
+{
+    QMutexLocker locker(&mutex);
+    DecodedImage *image = caches[space].object(key);
+    return image ? image->image : QImage();
+}
+
+bool DecodedImageCache::contains(Namespace space, const QString &key) const
+{
+    QMutexLocker locker(&mutex);
+    return caches[space].contains(key);
+}
+
+bool DecodedImageCache::insert(Namespace space, const DecodedImage &image)
+{
+    if (image.image.isNull()) {
+        return false;
+    }
+    const qint64 cost = costOf(image.image);
+    QMutexLocker locker(&mutex);
+    if (cost > caches[space].maxCost()) {
+        qDebug() << "图片超过缓存预算，不缓存:" << image.filePath << cost / (1024 * 1024) << "MB";
+        return false;
+    }
+    return caches[space].insert(image.filePath, new DecodedImage(image), cost);
+}
+
+bool DecodedImageCache::insertImage(Namespace space, const QString &key, const QImage &image)
+{
+    DecodedImage entry;
+    entry.filePath = key;
+    entry.image = image;
+    return insert(space, entry);
+}
+
+void DecodedImageCache::remove(Namespace space, const QString &key)
+{
+    QMutexLocker locker(&mutex);
+    caches[space].remove(key);
+}
+
+void DecodedImageCache::remove(const QString &key)
+{
+    QMutexLocker locker(&mutex);
+    for (auto &cache : caches) {
+        cache.remove(key);
+    }
+}
+
+void DecodedImageCache::clear(Namespace space)
+{
+    QMutexLocker locker(&mutex);
+    caches[space].clear();
+}
+
+void DecodedImageCache::clear()
+{
+    QMutexLocker locker(&mutex);
+    for (auto &cache : caches) {
+        cache.clear();
+    }
+}
+
+void DecodedImageCache::setBudget(Namespace space, qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    caches[space].setMaxCost(qMax<qint64>(0, bytes));
+}
+
+qint64 DecodedImageCache::budget(Namespace space) const
+{
+    QMutexLocker locker(&mutex);
+    return caches[space].maxCost();
+}
+
+qint64 DecodedImageCache::usedBytes(Namespace space) const
+{
+    QMutexLocker locker(&mutex);
+    return caches[space].totalCost();
+}
+
+qint64 DecodedImageCache::usedBytes() const
+{
+    QMutexLocker locker(&mutex);
+    qint64 total = 0;
+    for (const auto &cache : caches) {
+        total += cache.totalCost();
+    }
+    return total;
+}
+
+int DecodedImageCache::count(Namespace space) const
+{
+    QMutexLocker locker(&mutex);
+    return caches[space].count();
+}
+
+// 按像素缓冲区的实际大小计费（含行对齐），而不是按张数
+qint64 DecodedImageCache::costOf(const QImage &image)
+{
+    return qMax<qint64>(1, image.sizeInBytes());
+}
@@ -0,0 +1,65 @@
+// decodedimagecache.h
+#ifndef DECODEDIMAGECACHE_H
+#define DECODEDIMAGECACHE_H
+
+#include <QString>
+#include <QImage>
+#include <QCache>
+#include <QMutex>
+#include <QSharedPointer>
+#include "regionimagesource.h"
+
+// 一张解码完成的图片：只包含 QImage，可以在任意线程生成，QPixmap 在界面线程转换
+struct DecodedImage {
+    QString filePath;
+    QImage image;
+    QSharedPointer<RegionImageSource> region;  // 区域解码模式下 image 为预览图
+    bool animated = false;                     // 多帧动画，image 为第一帧
+};
+
+// 全程序共用的已解码图片缓存
+// 按用途分为互不影响的命名空间（原图 / 缩略图），各自按图像实际占用的字节数计费，
+// 超出预算时淘汰该命名空间中最久未使用的条目。线程安全：后台线程直接写入，界面线程读取。
+class DecodedImageCache
+{
+public:
+    enum Namespace {
+        FullImages,     // 单张浏览的原图（预取窗口、异步加载结果）
+        Thumbnails,     // 缩略图（文件夹与压缩包条目）
+        NamespaceCount
+    };
+
+    static DecodedImageCache &shared();
+
+    // 命中时复制到 result（QImage 隐式共享，不复制像素）并标记为最近使用
+    bool lookup(Namespace space, const QString &key, DecodedImage *result);
+    QImage lookupImage(Namespace space, const QString &key);
+    bool contains(Namespace space, const QString &key) const;
+    // 单张超过该命名空间的预算时不缓存，返回 false
+    bool insert(Namespace space, const DecodedImage &image);
+    bool insertImage(Namespace space, const QString &key, const QImage &image);
+    void remove(Namespace space, const QString &key);
+    void remove(const QString &key);   // 所有命名空间（删除文件时）
+    void clear(Namespace space);
+    void clear();
+
+    void setBudget(Namespace space, qint64 bytes);
+    qint64 budget(Namespace space) const;
+    qint64 usedBytes(Namespace space) const;
+    qint64 usedBytes() const;
+    int count(Namespace space) const;
+
+    static constexpr qint64 kDefaultFullImageBudget = 512LL * 1024 * 1024;
+    static constexpr qint64 kDefaultThumbnailBudget = 128LL * 1024 * 1024;
+
+private:
+    DecodedImageCache();
+    Q_DISABLE_COPY(DecodedImageCache)
+
+    static qint64 costOf(const QImage &image);
+
+    mutable QMutex mutex;
+    QCache<QString, DecodedImage> caches[NamespaceCount];
+};
+
+#endif // DECODEDIMAGECACHE_H
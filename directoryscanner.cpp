@@ -0,0 +1,385 @@
+// directoryscanner.cpp
+#include "directoryscanner.h"
+#include <QFile>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QtConcurrent>
+#include <QDebug>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+// 批次按条数或时间送出，慢速网络文件系统上也能持续看到进展
+class ChunkBuffer
+{
+public:
+    explicit ChunkBuffer(const DirectoryScanner::ChunkCallback &callback)
+        : onChunk(callback), limit(DirectoryScanner::kFirstChunkSize), aborted(false)
+    {
+        timer.start();
+    }
+
+    bool append(const QString &fileName)
+    {
+        pending.append(fileName);
+        if (pending.size() >= limit || timer.elapsed() >= DirectoryScanner::kChunkIntervalMs) {
+            return flush();
+        }
+        return true;
+    }
+
+    bool flush()
+    {
+        if (!pending.isEmpty()) {
+            aborted = !onChunk(pending);
+            pending.clear();
+            limit = DirectoryScanner::kChunkSize;
+        }
+        timer.restart();
+        return !aborted;
+    }
+
+private:
+    const DirectoryScanner::ChunkCallback &onChunk;
+    QStringList pending;
+    int limit;
+    bool aborted;
+    QElapsedTimer timer;
+};
+
+// 后缀：最后一个点之后的部分（"a.tar.gz" → "gz"，与原来的 endsWith 过滤一致）
+QString suffixOf(const QString &fileName)
+{
+    const int dot = fileName.lastIndexOf(QLatin1Char('.'));
+    return dot > 0 ? fileName.mid(dot + 1).toLower() : QString();
+}
+
+#ifdef Q_OS_UNIX
+
+struct DirectoryTask {
+    QByteArray path;      // 编码后的绝对路径
+    QString prefix;       // 相对根目录的前缀，以 / 结尾
+    int depth = 0;
+};
+
+// 每个线程一个任务队列：自己从末尾取，空闲线程从其他队列开头窃取
+class TraversalState
+{
+public:
+    TraversalState(int workerCount, int depthLimit)
+        : queues(workerCount), queueMutexes(workerCount), maxDepth(depthLimit)
+    {
+    }
+
+    void push(int worker, DirectoryTask task)
+    {
+        pending.fetchAndAddOrdered(1);
+        QMutexLocker locker(&queueMutexes[worker]);
+        queues[worker].append(std::move(task));
+    }
+
+    bool pop(int worker, DirectoryTask *task)
+    {
+        {
+            QMutexLocker locker(&queueMutexes[worker]);
+            if (!queues[worker].isEmpty()) {
+                *task = queues[worker].takeLast();
+                return true;
+            }
+        }
+        for (int i = 1; i < queues.size(); ++i) {
+            const int victim = (worker + i) % queues.size();
+            QMutexLocker locker(&queueMutexes[victim]);
+            if (!queues[victim].isEmpty()) {
+                *task = queues[victim].takeFirst();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void finishTask() { pending.fetchAndSubOrdered(1); }
+    bool hasPendingTasks() const { return pending.loadAcquire() > 0; }
+
+    // 同一个文件夹（经由符号链接或绑定挂载）只进入一次
+    bool markVisited(dev_t device, ino_t inode, const QString &prefix)
+    {
+        QMutexLocker locker(&visitedMutex);
+        const QPair<quint64, quint64> key(quint64(device), quint64(inode));
+        if (visited.contains(key)) {
+            return false;
+        }
+        visited.insert(key);
+        if (!prefix.isEmpty()) {
+            visitedPaths.append(prefix.chopped(1));
+        }
+        return true;
+    }
+
+    QVector<QVector<DirectoryTask>> queues;
+    std::vector<QMutex> queueMutexes;
+    QAtomicInt pending;
+    QAtomicInt aborted;
+    QAtomicInt directories;
+    QAtomicInt files;
+    QMutex visitedMutex;
+    QSet<QPair<quint64, quint64>> visited;
+    QStringList visitedPaths;   // 进入过的子文件夹，相对路径
+    const int maxDepth;
+};
+
+// 枚举一个文件夹：文件送入 buffer，子文件夹放进本线程的队列
+bool listDirectory(TraversalState &state, int worker, const DirectoryTask &task, ChunkBuffer &buffer)
+{
+    DIR *dir = opendir(task.path.constData());
+    if (!dir) {
+        return true;
+    }
+    struct stat dirInfo;
+    if (fstat(dirfd(dir), &dirInfo) != 0 || !state.markVisited(dirInfo.st_dev, dirInfo.st_ino, task.prefix)) {
+        closedir(dir);
+        return true;
+    }
+    state.directories.fetchAndAddRelaxed(1);
+
+    while (dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        bool regular = entry->d_type == DT_REG;
+        bool directory = entry->d_type == DT_DIR;
+        const QByteArray path = task.path + '/' + entry->d_name;
+        if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+            struct stat info;
+            if (::stat(path.constData(), &info) != 0) {
+                continue;
+            }
+            regular = S_ISREG(info.st_mode);
+            directory = S_ISDIR(info.st_mode);
+        }
+
+        const QString fileName = QFile::decodeName(entry->d_name);
+        if (directory) {
+            if (task.depth < state.maxDepth) {
+                state.push(worker, DirectoryTask{path, task.prefix + fileName + QLatin1Char('/'), task.depth + 1});
+            }
+        } else if (regular && DirectoryScanner::isListedFileName(fileName)) {
+            state.files.fetchAndAddRelaxed(1);
+            if (!buffer.append(task.prefix + fileName)) {
+                closedir(dir);
+                return false;
+            }
+        }
+    }
+    closedir(dir);
+    return true;
+}
+
+void traverse(TraversalState &state, int worker, const DirectoryScanner::ChunkCallback &onChunk)
+{
+    ChunkBuffer buffer(onChunk);
+    while (state.aborted.loadAcquire() == 0) {
+        DirectoryTask task;
+        if (!state.pop(worker, &task)) {
+            if (!state.hasPendingTasks()) {
+                break;
+            }
+            // 其他线程还在枚举，随时可能产生新的子文件夹
+            QThread::usleep(200);
+            continue;
+        }
+        const bool keepGoing = listDirectory(state, worker, task, buffer);
+        state.finishTask();
+        if (!keepGoing) {
+            state.aborted.storeRelease(1);
+        }
+    }
+    if (state.aborted.loadAcquire() == 0 && !buffer.flush()) {
+        state.aborted.storeRelease(1);
+    }
+}
+
+QThreadPool *traversalPool()
+{
+    static QThreadPool *pool = [] {
+        QThreadPool *threads = new QThreadPool;
+        threads->setMaxThreadCount(DirectoryScanner::kMaxTraversalThreads);
+        return threads;
+    }();
+    return pool;
+}
+
+#endif
+
+} // namespace
+
+const QSet<QString> &DirectoryScanner::imageSuffixes()
+{
+    static const QSet<QString> suffixes = {
+        "png", "jpg", "bmp", "jpeg", "webp", "gif", "tiff", "tif"
+    };
+    return suffixes;
+}
+
+const QSet<QString> &DirectoryScanner::archiveSuffixes()
+{
+    static const QSet<QString> suffixes = {
+        "zip", "rar", "7z", "tar", "gz", "bz2"
+    };
+    return suffixes;
+}
+
+bool DirectoryScanner::isListedFileName(const QString &fileName)
+{
+    const QString suffix = suffixOf(fileName);
+    return imageSuffixes().contains(suffix) || archiveSuffixes().contains(suffix);
+}
+
+bool DirectoryScanner::scan(const QString &dirPath, const ChunkCallback &onChunk)
+{
+    QElapsedTimer timer;
+    timer.start();
+    ChunkBuffer buffer(onChunk);
+    int found = 0;
+    int statCalls = 0;
+
+#ifdef Q_OS_UNIX
+    const QByteArray encodedDir = QFile::encodeName(dirPath);
+    DIR *dir = opendir(encodedDir.constData());
+    if (!dir) {
+        qDebug() << "无法打开文件夹:" << dirPath;
+        return false;
+    }
+
+    while (dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        // 先按后缀过滤，无关文件不会再触发 stat
+        const QString fileName = QFile::decodeName(entry->d_name);
+        if (!isListedFileName(fileName)) {
+            continue;
+        }
+
+        bool regular = entry->d_type == DT_REG;
+        if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+            // 部分文件系统（如部分 NFS 实现）不提供类型；符号链接按目标判断
+            struct stat info;
+            const QByteArray path = encodedDir + '/' + entry->d_name;
+            regular = ::stat(path.constData(), &info) == 0 && S_ISREG(info.st_mode);
+            ++statCalls;
+        }
+        if (!regular) {
+            continue;
+        }
+
+        ++found;
+        if (!buffer.append(fileName)) {
+            closedir(dir);
+            return false;
+        }
+    }
+    closedir(dir);
+#else
+    // Windows 的目录枚举本身就带回文件属性，QDirIterator 不会逐个 stat
+    QDirIterator it(dirPath, QDir::Files);
+    while (it.hasNext()) {
+        it.next();
+        const QString fileName = it.fileName();
+        if (!isListedFileName(fileName)) {
+            continue;
+        }
+        ++found;
+        if (!buffer.append(fileName)) {
+            return false;
+        }
+    }
+#endif
+
+    if (!buffer.flush()) {
+        return false;
+    }
+    qDebug() << "文件夹枚举完成:" << dirPath << found << "个文件，stat" << statCalls << "次，耗时"
+             << timer.elapsed() << "ms";
+    return true;
+}
+
+bool DirectoryScanner::scanRecursive(const QString &dirPath, int maxDepth, const ChunkCallback &onChunk,
+                                     QStringList *directories)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+#ifdef Q_OS_UNIX
+    const int workerCount = qBound(1, QThread::idealThreadCount(), kMaxTraversalThreads);
+    TraversalState state(workerCount, qMax(0, maxDepth));
+    state.push(0, DirectoryTask{QFile::encodeName(QDir(dirPath).absolutePath()), QString(), 0});
+
+    // 调用线程本身作为第 0 个线程
+    QVector<QFuture<void>> workers;
+    for (int worker = 1; worker < workerCount; ++worker) {
+        workers.append(QtConcurrent::run(traversalPool(), [&state, &onChunk, worker]() {
+            traverse(state, worker, onChunk);
+        }));
+    }
+    traverse(state, 0, onChunk);
+    for (QFuture<void> &future : workers) {
+        future.waitForFinished();
+    }
+
+    if (state.aborted.loadAcquire() != 0) {
+        return false;
+    }
+    if (directories) {
+        *directories = state.visitedPaths;
+    }
+    qDebug() << "递归枚举完成:" << dirPath << state.files.loadRelaxed() << "个文件，"
+             << state.directories.loadRelaxed() << "个文件夹，" << workerCount << "个线程，耗时"
+             << timer.elapsed() << "ms";
+    return true;
+#else
+    // 其他平台：QDirIterator 单线程遍历，不跟随符号链接（避免循环）
+    ChunkBuffer buffer(onChunk);
+    const QDir root(dirPath);
+    QDirIterator it(dirPath, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    QStringList visitedPaths;
+    int found = 0;
+    while (it.hasNext()) {
+        const QString relativePath = root.relativeFilePath(it.next());
+        if (it.fileInfo().isDir()) {
+            if (relativePath.count(QLatin1Char('/')) < maxDepth) {
+                visitedPaths.append(relativePath);
+            }
+            continue;
+        }
+        if (relativePath.count(QLatin1Char('/')) > maxDepth ||
+            !isListedFileName(it.fileName())) {
+            continue;
+        }
+        ++found;
+        if (!buffer.append(relativePath)) {
+            return false;
+        }
+    }
+    if (!buffer.flush()) {
+        return false;
+    }
+    if (directories) {
+        *directories = visitedPaths;
+    }
+    qDebug() << "递归枚举完成:" << dirPath << found << "个文件，耗时" << timer.elapsed() << "ms";
+    return true;
+#endif
+}
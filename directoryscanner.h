@@ -0,0 +1,45 @@
+// directoryscanner.h
+#ifndef DIRECTORYSCANNER_H
+#define DIRECTORYSCANNER_H
+
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <functional>
+
+// 文件夹枚举（后台线程）
+// Unix 上直接 readdir（glibc 内部即 getdents64），按后缀哈希表过滤，只有目录项类型未知或是
+// 符号链接时才 stat，不像 QDir::entryInfoList 那样对每个文件都取属性。
+// 结果分批回调：第一批很小，首屏可以立即显示；之后按条数或时间间隔成批送出。
+// 和 QDir::Files 一致，跳过隐藏文件和目录。
+// scanRecursive 用多个线程遍历整个目录树：每个线程优先处理自己队列末尾的子文件夹（深度优先），
+// 空闲时从其他线程队列的开头窃取（通常是较大的子树），在 SSD/NVMe 上枚举时间随核心数缩短。
+class DirectoryScanner
+{
+public:
+    // 返回 false 时停止枚举
+    using ChunkCallback = std::function<bool(const QStringList &fileNames)>;
+
+    // 支持的图片和压缩包后缀（小写，不含点）
+    static const QSet<QString> &imageSuffixes();
+    static const QSet<QString> &archiveSuffixes();
+    static bool isListedFileName(const QString &fileName);
+
+    // 枚举 dirPath 中的图片和压缩包。回调在调用线程执行，顺序即目录项顺序（未排序）。
+    // 被回调中止或目录无法打开时返回 false
+    static bool scan(const QString &dirPath, const ChunkCallback &onChunk);
+
+    // 递归枚举 dirPath 及其子文件夹，文件名为相对 dirPath 的路径（以 / 分隔），回调可能来自多个线程。
+    // maxDepth 为 0 时只枚举 dirPath 本身；每个文件夹（按设备号和 inode）只进入一次，
+    // 符号链接形成的循环不会无限遍历。directories 不为空时收到进入过的子文件夹（相对路径，不含 dirPath 本身）
+    static bool scanRecursive(const QString &dirPath, int maxDepth, const ChunkCallback &onChunk,
+                              QStringList *directories = nullptr);
+
+    static constexpr int kFirstChunkSize = 256;
+    static constexpr int kChunkSize = 4096;
+    static constexpr int kChunkIntervalMs = 100;
+    static constexpr int kDefaultMaxDepth = 16;
+    static constexpr int kMaxTraversalThreads = 16;
+};
+
+#endif // DIRECTORYSCANNER_H
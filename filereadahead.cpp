@@ -0,0 +1,141 @@
+// filereadahead.cpp
+#include "filereadahead.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QtConcurrent>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+FileReadAhead &FileReadAhead::shared()
+{
+    static FileReadAhead instance;
+    return instance;
+}
+
+FileReadAhead::FileReadAhead()
+    : cache(kDefaultBudget)
+{
+    ioPool.setMaxThreadCount(1);
+}
+
+FileReadAhead::~FileReadAhead()
+{
+    generation.fetchAndAddOrdered(1);
+    ioPool.clear();
+    ioPool.waitForDone();
+}
+
+void FileReadAhead::schedule(const QStringList &filePaths)
+{
+    ioPool.clear();
+    const int request = generation.fetchAndAddOrdered(1) + 1;
+
+    QStringList pending;
+    for (const QString &filePath : filePaths) {
+        if (!contains(filePath)) {
+            pending.append(filePath);
+        }
+    }
+    if (pending.isEmpty()) {
+        return;
+    }
+
+    QtConcurrent::run(&ioPool, [this, request, pending]() {
+        for (const QString &filePath : pending) {
+            // 有了新的计划（翻页）就停止，剩下的由新计划重新安排
+            if (generation.loadAcquire() != request) {
+                return;
+            }
+            readFile(filePath);
+        }
+    });
+}
+
+void FileReadAhead::readFile(const QString &filePath)
+{
+    if (contains(filePath)) {
+        return;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QFileInfo info(filePath);
+    const qint64 size = file.size();
+
+    if (size <= 0 || size > kMaxFileBytes) {
+#ifdef Q_OS_LINUX
+        // 大文件只让内核提前读入页缓存
+        posix_fadvise(file.handle(), 0, 0, POSIX_FADV_WILLNEED);
+#endif
+        return;
+    }
+
+#ifdef Q_OS_LINUX
+    posix_fadvise(file.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    QByteArray bytes = file.readAll();
+    if (bytes.size() != size) {
+        qDebug() << "预读不完整，放弃:" << filePath << bytes.size() << "/" << size;
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    cache.insert(filePath, new Entry{bytes, size, info.lastModified()}, qMax<qint64>(1, size));
+}
+
+QByteArray FileReadAhead::data(const QString &filePath)
+{
+    Entry entry;
+    {
+        QMutexLocker locker(&mutex);
+        Entry *cached = cache.object(filePath);
+        if (!cached) {
+            return QByteArray();
+        }
+        entry = *cached;
+    }
+
+    // 读入之后文件被修改或替换
+    const QFileInfo info(filePath);
+    if (info.size() != entry.size || info.lastModified() != entry.modified) {
+        remove(filePath);
+        return QByteArray();
+    }
+    return entry.bytes;
+}
+
+bool FileReadAhead::contains(const QString &filePath) const
+{
+    QMutexLocker locker(&mutex);
+    return cache.contains(filePath);
+}
+
+void FileReadAhead::remove(const QString &filePath)
+{
+    QMutexLocker locker(&mutex);
+    cache.remove(filePath);
+}
+
+void FileReadAhead::clear()
+{
+    QMutexLocker locker(&mutex);
+    cache.clear();
+}
+
+void FileReadAhead::setBudget(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    cache.setMaxCost(qMax<qint64>(0, bytes));
+}
+
+qint64 FileReadAhead::usedBytes() const
+{
+    QMutexLocker locker(&mutex);
+    return cache.totalCost();
+}
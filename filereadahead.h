@@ -0,0 +1,57 @@
+// filereadahead.h
+#ifndef FILEREADAHEAD_H
+#define FILEREADAHEAD_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QDateTime>
+#include <QCache>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QThreadPool>
+
+// 压缩数据预读层：在单独的 I/O 线程中把即将浏览的文件原始内容读入内存
+// 压缩数据只有解码后的 1/10～1/20，可以覆盖比解码缓存宽得多的窗口；
+// 网络盘或冷 HDD 上翻页时只需等待解码，不再等待 I/O。
+// 按字节数 LRU 淘汰；取用时检查文件大小和修改时间，文件已变化则丢弃。
+class FileReadAhead
+{
+public:
+    static FileReadAhead &shared();
+
+    // 按给定顺序（近的在前）在后台读入，替换之前尚未完成的计划
+    void schedule(const QStringList &filePaths);
+    // 命中时返回文件内容并标记为最近使用，未命中或文件已变化时返回空
+    QByteArray data(const QString &filePath);
+    bool contains(const QString &filePath) const;
+    void remove(const QString &filePath);
+    void clear();
+
+    void setBudget(qint64 bytes);
+    qint64 usedBytes() const;
+
+    static constexpr qint64 kDefaultBudget = 256LL * 1024 * 1024;
+    // 更大的文件（通常走区域解码）只提示内核预读，不复制到内存
+    static constexpr qint64 kMaxFileBytes = 64LL * 1024 * 1024;
+
+private:
+    struct Entry {
+        QByteArray bytes;
+        qint64 size;
+        QDateTime modified;
+    };
+
+    FileReadAhead();
+    ~FileReadAhead();
+    Q_DISABLE_COPY(FileReadAhead)
+
+    void readFile(const QString &filePath);
+
+    mutable QMutex mutex;
+    QCache<QString, Entry> cache;
+    QAtomicInt generation;
+    QThreadPool ioPool;   // 单线程，顺序读取对机械硬盘最友好
+};
+
+#endif // FILEREADAHEAD_H
@@ -0,0 +1,304 @@
+// folderwatcher.cpp
+#include "folderwatcher.h"
+#include "directoryscanner.h"
+#include <QDir>
+#include <QFile>
+#include <QSet>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <QSocketNotifier>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#else
+#include <QFileSystemWatcher>
+#endif
+
+FolderWatcher::FolderWatcher(QObject *parent)
+    : QObject(parent),
+    recursive(false),
+    rescanPending(false),
+#ifdef Q_OS_LINUX
+    inotifyFd(-1),
+    watchDescriptor(-1),
+    notifier(nullptr)
+#else
+    fallbackWatcher(nullptr)
+#endif
+{
+    // 不在每个事件上重新计时：持续写入的采集文件夹也能按固定间隔看到新文件
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(kFlushDelayMs);
+    connect(&flushTimer, &QTimer::timeout, this, &FolderWatcher::flush);
+
+    pollTimer.setInterval(kPollIntervalMs);
+    connect(&pollTimer, &QTimer::timeout, this, [this]() {
+        rescanPending = true;
+        scheduleFlush();
+    });
+}
+
+FolderWatcher::~FolderWatcher()
+{
+    stop();
+}
+
+bool FolderWatcher::watch(const QString &path, bool watchRecursive)
+{
+#ifdef Q_OS_LINUX
+    const bool watching = watchDescriptor >= 0;
+#else
+    const bool watching = fallbackWatcher != nullptr;
+#endif
+    if (watching && path == dirPath && watchRecursive == recursive) {
+        return true;
+    }
+    stop();
+    dirPath = path;
+    recursive = watchRecursive;
+
+#ifdef Q_OS_LINUX
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        qDebug() << "inotify 初始化失败:" << strerror(errno);
+        return false;
+    }
+    watchDescriptor = inotify_add_watch(inotifyFd, QFile::encodeName(path).constData(), watchMask());
+    if (watchDescriptor < 0) {
+        qDebug() << "无法监视文件夹:" << path << strerror(errno);
+        stop();
+        return false;
+    }
+    notifier = new QSocketNotifier(inotifyFd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &FolderWatcher::readEvents);
+#else
+    fallbackWatcher = new QFileSystemWatcher(this);
+    connect(fallbackWatcher, &QFileSystemWatcher::directoryChanged, this, [this]() {
+        rescanPending = true;
+        scheduleFlush();
+    });
+    if (!fallbackWatcher->addPath(path)) {
+        qDebug() << "无法监视文件夹:" << path;
+        stop();
+        return false;
+    }
+#endif
+
+    qDebug() << "开始监视文件夹:" << path << (recursive ? "（含子文件夹）" : "");
+    return true;
+}
+
+void FolderWatcher::setSubdirectories(const QStringList &relativePaths)
+{
+    if (!recursive || dirPath.isEmpty()) {
+        return;
+    }
+    const QDir root(dirPath);
+    const QSet<QString> wanted(relativePaths.cbegin(), relativePaths.cend());
+    bool complete = true;
+
+#ifdef Q_OS_LINUX
+    if (inotifyFd < 0) {
+        return;
+    }
+    for (auto it = subdirectoryWatches.begin(); it != subdirectoryWatches.end();) {
+        if (wanted.contains(it.key())) {
+            ++it;
+            continue;
+        }
+        inotify_rm_watch(inotifyFd, it.value());
+        subdirectoryPrefixes.remove(it.value());
+        it = subdirectoryWatches.erase(it);
+    }
+    for (const QString &relativePath : relativePaths) {
+        if (subdirectoryWatches.contains(relativePath)) {
+            continue;
+        }
+        const int wd = inotify_add_watch(inotifyFd,
+                                         QFile::encodeName(root.absoluteFilePath(relativePath)).constData(),
+                                         watchMask());
+        if (wd < 0) {
+            // 通常是 ENOSPC（fs.inotify.max_user_watches）；已经建立的监视继续有效
+            qDebug() << "无法监视子文件夹:" << relativePath << strerror(errno);
+            complete = false;
+            if (errno == ENOSPC) {
+                break;
+            }
+            continue;
+        }
+        subdirectoryWatches.insert(relativePath, wd);
+        subdirectoryPrefixes.insert(wd, relativePath + QLatin1Char('/'));
+    }
+    qDebug() << "监视子文件夹:" << subdirectoryWatches.size() << "/" << relativePaths.size();
+#else
+    if (!fallbackWatcher) {
+        return;
+    }
+    const QString rootPath = root.absolutePath();
+    QStringList unwanted;
+    for (const QString &watched : fallbackWatcher->directories()) {
+        if (watched != rootPath && !wanted.contains(root.relativeFilePath(watched))) {
+            unwanted.append(watched);
+        }
+    }
+    if (!unwanted.isEmpty()) {
+        fallbackWatcher->removePaths(unwanted);
+    }
+    QStringList added;
+    for (const QString &relativePath : relativePaths) {
+        added.append(root.absoluteFilePath(relativePath));
+    }
+    if (!added.isEmpty() && !fallbackWatcher->addPaths(added).isEmpty()) {
+        qDebug() << "部分子文件夹无法监视:" << dirPath;
+        complete = false;
+    }
+#endif
+
+    if (complete) {
+        pollTimer.stop();
+    } else {
+        startPolling();
+    }
+}
+
+void FolderWatcher::startPolling()
+{
+    if (!pollTimer.isActive()) {
+        qDebug() << "无法监视全部子文件夹，改为每" << kPollIntervalMs / 1000 << "秒重新枚举:" << dirPath;
+        pollTimer.start();
+    }
+}
+
+void FolderWatcher::stop()
+{
+    flushTimer.stop();
+    pollTimer.stop();
+    pending.clear();
+    rescanPending = false;
+    dirPath.clear();
+    recursive = false;
+
+#ifdef Q_OS_LINUX
+    delete notifier;
+    notifier = nullptr;
+    if (inotifyFd >= 0) {
+        ::close(inotifyFd);   // 同时移除监视
+        inotifyFd = -1;
+    }
+    watchDescriptor = -1;
+    subdirectoryPrefixes.clear();
+    subdirectoryWatches.clear();
+#else
+    delete fallbackWatcher;
+    fallbackWatcher = nullptr;
+#endif
+}
+
+void FolderWatcher::readEvents()
+{
+#ifdef Q_OS_LINUX
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    for (;;) {
+        const ssize_t length = ::read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+        for (ssize_t offset = 0; offset < length;) {
+            const auto *event = reinterpret_cast<const struct inotify_event *>(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                qDebug() << "inotify 事件队列溢出，重新枚举:" << dirPath;
+                rescanPending = true;
+                continue;
+            }
+            const bool isRoot = event->wd == watchDescriptor;
+            if (!isRoot && !subdirectoryPrefixes.contains(event->wd)) {
+                continue;   // 已经移除的子文件夹监视
+            }
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                // 文件夹本身不在了，监视随之失效：根文件夹由下次 watch() 重新建立，子文件夹由重新枚举更新
+                if (event->mask & IN_IGNORED) {
+                    if (isRoot) {
+                        watchDescriptor = -1;
+                    } else {
+                        subdirectoryWatches.remove(subdirectoryPrefixes.take(event->wd).chopped(1));
+                    }
+                }
+                rescanPending = true;
+                continue;
+            }
+            if (event->len == 0 || event->name[0] == '.') {
+                continue;
+            }
+            if (event->mask & IN_ISDIR) {
+                // 子文件夹增删或移动：重新枚举，同时更新子文件夹监视
+                if (recursive) {
+                    rescanPending = true;
+                }
+                continue;
+            }
+            if (event->mask & IN_CREATE) {
+                continue;   // 只为发现新的子文件夹而监视
+            }
+            const QString fileName = QFile::decodeName(event->name);
+            if (!DirectoryScanner::isListedFileName(fileName)) {
+                continue;
+            }
+            const QString relativePath = isRoot ? fileName : subdirectoryPrefixes.value(event->wd) + fileName;
+            noteEvent(relativePath, (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0);
+        }
+    }
+    if (rescanPending || !pending.isEmpty()) {
+        scheduleFlush();
+    }
+#endif
+}
+
+#ifdef Q_OS_LINUX
+uint32_t FolderWatcher::watchMask() const
+{
+    // 不监视文件的 IN_CREATE / IN_MODIFY：文件写完才显示，避免读到半个文件。
+    // 递归时需要 IN_CREATE 发现新建的子文件夹
+    uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM |
+                    IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+    if (recursive) {
+        mask |= IN_CREATE;
+    }
+    return mask;
+}
+#endif
+
+void FolderWatcher::noteEvent(const QString &fileName, bool present)
+{
+    pending.insert(fileName, present);
+}
+
+void FolderWatcher::scheduleFlush()
+{
+    if (!flushTimer.isActive()) {
+        flushTimer.start();
+    }
+}
+
+void FolderWatcher::flush()
+{
+    if (rescanPending) {
+        rescanPending = false;
+        pending.clear();
+        emit rescanNeeded();
+        return;
+    }
+
+    QStringList written;
+    QStringList removed;
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+        (it.value() ? written : removed).append(it.key());
+    }
+    pending.clear();
+    if (!written.isEmpty() || !removed.isEmpty()) {
+        emit filesChanged(written, removed);
+    }
+}
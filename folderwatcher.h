@@ -0,0 +1,77 @@
+// folderwatcher.h
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QTimer>
+#include <cstdint>
+
+class QSocketNotifier;
+class QFileSystemWatcher;
+
+// 监视当前文件夹中图片和压缩包的变化
+// Linux 上直接使用 inotify：写入完成（IN_CLOSE_WRITE）和移入算作写入，删除和移出算作删除，
+// 短时间内的事件按文件名合并后一次送出，只有最后一个事件有效（先删后写 = 覆盖）。
+// 事件队列溢出、文件夹本身被删除或移动，以及其他平台（QFileSystemWatcher 只报告“有变化”）
+// 都发出 rescanNeeded，由调用方重新枚举并比较差异。
+// 递归浏览时 inotify 需要对每个子文件夹单独监视：枚举完成后由 setSubdirectories 传入枚举到的
+// 子文件夹，其中的文件以相对路径报告；子文件夹的增删发出 rescanNeeded。监视数量达到系统上限时
+// 退回到定时 rescanNeeded。
+class FolderWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FolderWatcher(QObject *parent = nullptr);
+    ~FolderWatcher() override;
+
+    // 开始监视 dirPath（替换之前的文件夹）；recursive 时之后用 setSubdirectories 加入子文件夹
+    bool watch(const QString &dirPath, bool recursive = false);
+    // 递归浏览时监视的子文件夹（相对 dirPath，以 / 分隔），替换之前的集合
+    void setSubdirectories(const QStringList &relativePaths);
+    void stop();
+    QString folder() const { return dirPath; }
+
+signals:
+    // written：新增或内容被改写的文件；removed：已不存在的文件（都只是文件名）
+    void filesChanged(const QStringList &written, const QStringList &removed);
+    void rescanNeeded();
+
+private slots:
+    void readEvents();
+    void flush();
+
+private:
+    void noteEvent(const QString &fileName, bool present);
+    void scheduleFlush();
+
+    void startPolling();
+#ifdef Q_OS_LINUX
+    uint32_t watchMask() const;
+#endif
+
+    QString dirPath;
+    bool recursive;
+    QHash<QString, bool> pending;   // 文件名 → 最后一个事件后是否存在
+    bool rescanPending;
+    QTimer flushTimer;
+    QTimer pollTimer;               // 无法监视全部子文件夹时定时重新枚举
+
+#ifdef Q_OS_LINUX
+    int inotifyFd;
+    int watchDescriptor;
+    QHash<int, QString> subdirectoryPrefixes;   // 监视描述符 → 相对路径前缀（以 / 结尾）
+    QHash<QString, int> subdirectoryWatches;    // 相对路径 → 监视描述符
+    QSocketNotifier *notifier;
+#else
+    QFileSystemWatcher *fallbackWatcher;
+#endif
+
+    static constexpr int kFlushDelayMs = 200;
+    static constexpr int kPollIntervalMs = 30 * 1000;
+};
+
+#endif // FOLDERWATCHER_H
@@ -0,0 +1,489 @@
+// imagecodecs.cpp
+#include "imagecodecs.h"
+#include "jpegrestartdecoder.h"
+#include "pixelbufferpool.h"
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QTransform>
+#include <QDebug>
+#include <cstring>
+#include <vector>
+
+#ifdef HAVE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+#ifdef HAVE_LIBPNG
+#include <png.h>
+#endif
+
+#ifdef HAVE_LIBWEBP
+#include <webp/decode.h>
+#endif
+
+namespace {
+
+QAtomicInt directBackends(1);
+
+// 后缀 / 格式名统一为 jpeg、png、webp，其他原样返回（小写）
+QByteArray normalizedFormat(const QByteArray &format)
+{
+    const QByteArray lower = format.toLower();
+    if (lower == "jpg" || lower == "jpeg" || lower == "jpe" || lower == "jfif") {
+        return "jpeg";
+    }
+    return lower;
+}
+
+// 与 QImageReader 一样遵守分配上限，超过时交给 Qt 插件报告错误
+bool exceedsAllocationLimit(const QSize &size)
+{
+    const int limitMB = QImageReader::allocationLimit();
+    if (limitMB <= 0) {
+        return false;
+    }
+    return qint64(size.width()) * size.height() * 4 > qint64(limitMB) * 1024 * 1024;
+}
+
+// 按比例放入 targetSize 后的最小输出尺寸（不放大）
+QSize requiredSize(const QSize &fullSize, const QSize &targetSize)
+{
+    if (!targetSize.isValid() || targetSize.isEmpty()) {
+        return fullSize;
+    }
+    return fullSize.scaled(targetSize, Qt::KeepAspectRatio).boundedTo(fullSize).expandedTo(QSize(1, 1));
+}
+
+QImage decodeWithQt(const QByteArray &data, const QByteArray &format)
+{
+    QByteArray bytes = data;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer, format);
+    return reader.read();
+}
+
+// 直接后端不处理 EXIF 方向：由 Qt 插件只解析文件头取得方向，与 Qt 插件默认的自动旋转一致
+QImageIOHandler::Transformations headerTransformation(const QByteArray &data, const QByteArray &format)
+{
+    QByteArray bytes = data;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer, format);
+    return reader.transformation();
+}
+
+#ifdef HAVE_TURBOJPEG
+QImage decodeTurboJpeg(const QByteArray &data, const QSize &targetSize)
+{
+    tjhandle handle = tjInitDecompress();
+    if (!handle) {
+        return QImage();
+    }
+
+    const unsigned char *jpegBuf = reinterpret_cast<const unsigned char *>(data.constData());
+    const unsigned long jpegSize = static_cast<unsigned long>(data.size());
+
+    int width = 0;
+    int height = 0;
+    int subsamp = 0;
+    int colorspace = 0;
+    if (tjDecompressHeader3(handle, jpegBuf, jpegSize, &width, &height, &subsamp, &colorspace) != 0) {
+        tjDestroy(handle);
+        return QImage();
+    }
+    // CMYK / YCCK 不能直接输出 RGB，交给 Qt
+    if (colorspace == TJCS_CMYK || colorspace == TJCS_YCCK) {
+        tjDestroy(handle);
+        return QImage();
+    }
+
+    // 选择输出仍不小于需要尺寸的最小 DCT 缩放比例（1/8 ～ 1）
+    const QSize required = requiredSize(QSize(width, height), targetSize);
+    QSize outputSize(width, height);
+    tjscalingfactor chosen = {1, 1};
+    int factorCount = 0;
+    tjscalingfactor *factors = tjGetScalingFactors(&factorCount);
+    for (int i = 0; factors && i < factorCount; ++i) {
+        const QSize scaled(TJSCALED(width, factors[i]), TJSCALED(height, factors[i]));
+        if (scaled.width() >= required.width() && scaled.height() >= required.height() &&
+            qint64(scaled.width()) * scaled.height() < qint64(outputSize.width()) * outputSize.height()) {
+            outputSize = scaled;
+            chosen = factors[i];
+        }
+    }
+
+    if (exceedsAllocationLimit(outputSize)) {
+        tjDestroy(handle);
+        return QImage();
+    }
+
+    QImage image = PixelBufferPool::shared().createImage(outputSize, QImage::Format_RGB32);
+    if (image.isNull()) {
+        tjDestroy(handle);
+        return QImage();
+    }
+
+    // 带重启标记的大图按段拆分到多个核心，不满足条件时按普通方式单线程解码
+    if (qint64(width) * height >= JpegRestartDecoder::kMinParallelPixels &&
+        JpegRestartDecoder::parallelEnabled()) {
+        JpegRestartDecoder restartDecoder(data);
+        if (restartDecoder.isValid() && restartDecoder.decodeInto(image, chosen.num, chosen.denom)) {
+            tjDestroy(handle);
+            return image;
+        }
+    }
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    const int pixelFormat = TJPF_BGRX;
+#else
+    const int pixelFormat = TJPF_XRGB;
+#endif
+    if (tjDecompress2(handle, jpegBuf, jpegSize, image.bits(), outputSize.width(),
+                      int(image.bytesPerLine()), outputSize.height(), pixelFormat, 0) != 0) {
+        qDebug() << "TurboJPEG 解码失败:" << tjGetErrorStr2(handle);
+        tjDestroy(handle);
+        return QImage();
+    }
+
+    tjDestroy(handle);
+    return image;
+}
+#endif
+
+#ifdef HAVE_LIBPNG
+// 输出图像也放在这里：地址已交给 libpng，longjmp 返回后成员的值仍然可靠
+struct PngMemorySource {
+    const png_byte *data;
+    png_size_t size;
+    png_size_t offset;
+    QImage image;
+    std::vector<png_bytep> rows;
+};
+
+void pngMemoryReadCallback(png_structp png, png_bytep out, png_size_t length)
+{
+    PngMemorySource *source = static_cast<PngMemorySource *>(png_get_io_ptr(png));
+    if (length > source->size - source->offset) {
+        png_error(png, "unexpected end of data");
+    }
+    memcpy(out, source->data + source->offset, length);
+    source->offset += length;
+}
+
+QImage decodeLibPng(const QByteArray &data)
+{
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    if (!png) {
+        return QImage();
+    }
+    png_infop info = png_create_info_struct(png);
+    if (!info) {
+        png_destroy_read_struct(&png, nullptr, nullptr);
+        return QImage();
+    }
+
+    // setjmp 之后不再构造需要析构的对象
+    PngMemorySource source = {reinterpret_cast<const png_byte *>(data.constData()),
+                              static_cast<png_size_t>(data.size()), 0, QImage(), {}};
+
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        return QImage();
+    }
+
+    png_set_read_fn(png, &source, pngMemoryReadCallback);
+    png_read_info(png, info);
+
+    const png_uint_32 width = png_get_image_width(png, info);
+    const png_uint_32 height = png_get_image_height(png, info);
+    const int colorType = png_get_color_type(png, info);
+    const bool hasAlpha = (colorType & PNG_COLOR_MASK_ALPHA) || png_get_valid(png, info, PNG_INFO_tRNS);
+
+    if (width > 0x7fffffff || height > 0x7fffffff ||
+        exceedsAllocationLimit(QSize(int(width), int(height)))) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        return QImage();
+    }
+
+    // 统一展开为每像素 4 字节，字节序与 QImage::Format_(A)RGB32 一致
+    png_set_expand(png);
+    png_set_strip_16(png);
+    if (!(colorType & PNG_COLOR_MASK_COLOR)) {
+        png_set_gray_to_rgb(png);
+    }
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    png_set_bgr(png);
+    png_set_filler(png, 0xff, PNG_FILLER_AFTER);
+#else
+    png_set_filler(png, 0xff, PNG_FILLER_BEFORE);
+    png_set_swap_alpha(png);
+#endif
+    png_set_interlace_handling(png);
+    png_read_update_info(png, info);
+
+    if (png_get_rowbytes(png, info) != png_size_t(width) * 4) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        return QImage();
+    }
+
+    source.image = PixelBufferPool::shared().createImage(int(width), int(height),
+                                                         hasAlpha ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    if (source.image.isNull()) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        return QImage();
+    }
+    source.rows.resize(height);
+    for (png_uint_32 y = 0; y < height; ++y) {
+        source.rows[y] = source.image.scanLine(int(y));
+    }
+
+    png_read_image(png, source.rows.data());
+    png_destroy_read_struct(&png, &info, nullptr);
+    return source.image;
+}
+#endif
+
+#ifdef HAVE_LIBWEBP
+QImage decodeLibWebp(const QByteArray &data, const QSize &targetSize)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.constData());
+    const size_t size = static_cast<size_t>(data.size());
+
+    WebPDecoderConfig config;
+    if (!WebPInitDecoderConfig(&config) || WebPGetFeatures(bytes, size, &config.input) != VP8_STATUS_OK) {
+        return QImage();
+    }
+    // 动画 WebP 由 AnimationPlayer 通过 Qt 插件逐帧解码
+    if (config.input.has_animation) {
+        return QImage();
+    }
+
+    const QSize fullSize(config.input.width, config.input.height);
+    const QSize outputSize = requiredSize(fullSize, targetSize);
+    if (exceedsAllocationLimit(outputSize)) {
+        return QImage();
+    }
+
+    const bool hasAlpha = config.input.has_alpha;
+    QImage image = PixelBufferPool::shared().createImage(
+        outputSize, hasAlpha ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    if (image.isNull()) {
+        return QImage();
+    }
+
+    config.options.use_threads = 1;
+    if (outputSize != fullSize) {
+        config.options.use_scaling = 1;
+        config.options.scaled_width = outputSize.width();
+        config.options.scaled_height = outputSize.height();
+    }
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    config.output.colorspace = hasAlpha ? MODE_bgrA : MODE_BGRA;
+#else
+    config.output.colorspace = hasAlpha ? MODE_Argb : MODE_ARGB;
+#endif
+    config.output.is_external_memory = 1;
+    config.output.u.RGBA.rgba = image.bits();
+    config.output.u.RGBA.stride = int(image.bytesPerLine());
+    config.output.u.RGBA.size = size_t(image.sizeInBytes());
+
+    const VP8StatusCode status = WebPDecode(bytes, size, &config);
+    WebPFreeDecBuffer(&config.output);
+    if (status != VP8_STATUS_OK) {
+        qDebug() << "libwebp 解码失败, 状态:" << int(status);
+        return QImage();
+    }
+    return image;
+}
+#endif
+
+} // namespace
+
+QImage ImageCodecs::decode(const QByteArray &data, const QByteArray &format,
+                           const QSize &targetSize, Backend *used)
+{
+    // 以文件头为准，后缀错误的文件也能选对后端
+    QByteArray actualFormat = detectFormat(data);
+    if (actualFormat.isEmpty()) {
+        actualFormat = normalizedFormat(format);
+    }
+
+    const Backend backend = backendFor(actualFormat);
+    if (backend != QtPlugin) {
+        // 旋转 90° 的图片按旋转前的方向缩放解码
+        const QImageIOHandler::Transformations transformation = headerTransformation(data, actualFormat);
+        const QSize decodeSize = (transformation & QImageIOHandler::TransformationRotate90) ? targetSize.transposed()
+                                                                                           : targetSize;
+        QImage image = decodeWith(backend, data, actualFormat, decodeSize);
+        if (!image.isNull()) {
+            if (used) {
+                *used = backend;
+            }
+            return applyTransformation(image, transformation);
+        }
+    }
+
+    if (used) {
+        *used = QtPlugin;
+    }
+    return decodeWithQt(data, actualFormat);
+}
+
+QImage ImageCodecs::decodeFile(const QString &filePath, const QSize &targetSize, Backend *used)
+{
+    const QByteArray suffix = QFileInfo(filePath).suffix().toLatin1();
+    if (backendFor(normalizedFormat(suffix)) == QtPlugin) {
+        if (used) {
+            *used = QtPlugin;
+        }
+        QImageReader reader(filePath);
+        return reader.read();
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QImage();
+    }
+    return decode(file.readAll(), suffix, targetSize, used);
+}
+
+QImage ImageCodecs::decodeWith(Backend backend, const QByteArray &data, const QByteArray &format,
+                               const QSize &targetSize)
+{
+    if (data.isEmpty()) {
+        return QImage();
+    }
+
+    switch (backend) {
+    case QtPlugin:
+        return decodeWithQt(data, normalizedFormat(format));
+#ifdef HAVE_TURBOJPEG
+    case TurboJpeg:
+        return decodeTurboJpeg(data, targetSize);
+#endif
+#ifdef HAVE_LIBPNG
+    case LibPng:
+        return decodeLibPng(data);
+#endif
+#ifdef HAVE_LIBWEBP
+    case LibWebp:
+        return decodeLibWebp(data, targetSize);
+#endif
+    default:
+        Q_UNUSED(targetSize)
+        return QImage();
+    }
+}
+
+ImageCodecs::Backend ImageCodecs::backendFor(const QByteArray &format)
+{
+    if (!directBackendsEnabled()) {
+        return QtPlugin;
+    }
+
+    const QByteArray normalized = normalizedFormat(format);
+    Backend backend = QtPlugin;
+    if (normalized == "jpeg") {
+        backend = TurboJpeg;
+    } else if (normalized == "png") {
+        backend = LibPng;
+    } else if (normalized == "webp") {
+        backend = LibWebp;
+    }
+    return isBackendAvailable(backend) ? backend : QtPlugin;
+}
+
+QByteArray ImageCodecs::detectFormat(const QByteArray &data)
+{
+    if (data.startsWith("\xff\xd8\xff")) {
+        return "jpeg";
+    }
+    if (data.startsWith("\x89PNG\r\n\x1a\n")) {
+        return "png";
+    }
+    if (data.size() >= 12 && data.startsWith("RIFF") && data.mid(8, 4) == "WEBP") {
+        return "webp";
+    }
+    return QByteArray();
+}
+
+bool ImageCodecs::isBackendAvailable(Backend backend)
+{
+    switch (backend) {
+    case QtPlugin:
+        return true;
+    case TurboJpeg:
+#ifdef HAVE_TURBOJPEG
+        return true;
+#else
+        return false;
+#endif
+    case LibPng:
+#ifdef HAVE_LIBPNG
+        return true;
+#else
+        return false;
+#endif
+    case LibWebp:
+#ifdef HAVE_LIBWEBP
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+QVector<ImageCodecs::Backend> ImageCodecs::availableBackends()
+{
+    QVector<Backend> backends;
+    for (Backend backend : {QtPlugin, TurboJpeg, LibPng, LibWebp}) {
+        if (isBackendAvailable(backend)) {
+            backends.append(backend);
+        }
+    }
+    return backends;
+}
+
+QString ImageCodecs::backendName(Backend backend)
+{
+    switch (backend) {
+    case QtPlugin: return "qt";
+    case TurboJpeg: return "turbojpeg";
+    case LibPng: return "libpng";
+    case LibWebp: return "libwebp";
+    }
+    return "unknown";
+}
+
+void ImageCodecs::setDirectBackendsEnabled(bool enabled)
+{
+    directBackends.storeRelease(enabled ? 1 : 0);
+}
+
+bool ImageCodecs::directBackendsEnabled()
+{
+    return directBackends.loadAcquire() != 0;
+}
+
+QImage ImageCodecs::applyTransformation(const QImage &image, QImageIOHandler::Transformations transformation)
+{
+    if (transformation == QImageIOHandler::TransformationNone || image.isNull()) {
+        return image;
+    }
+    if (transformation == QImageIOHandler::TransformationRotate270) {
+        return image.transformed(QTransform().rotate(270));
+    }
+
+    QImage result = image.mirrored(transformation & QImageIOHandler::TransformationMirror,
+                                   transformation & QImageIOHandler::TransformationFlip);
+    if (transformation & QImageIOHandler::TransformationRotate90) {
+        result = result.transformed(QTransform().rotate(90));
+    }
+    return result;
+}
@@ -0,0 +1,58 @@
+// imagecodecs.h
+#ifndef IMAGECODECS_H
+#define IMAGECODECS_H
+
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QImageIOHandler>
+
+// 直接调用编解码库的解码层，绕过 Qt 图像插件
+// JPEG 用 TurboJPEG（SIMD 色彩转换，按 DCT 比例直接解码缩小图），PNG 用 libpng，
+// WebP 用 libwebp（多线程解码，可直接缩放输出）。直接写入 QImage 的缓冲区，不再转换格式。
+// 按文件格式在运行时选择，编译时未启用的库、不支持的变体（CMYK JPEG、动画 WebP 等）
+// 和其他格式都回退到 Qt 插件。
+class ImageCodecs
+{
+public:
+    enum Backend {
+        QtPlugin,
+        TurboJpeg,
+        LibPng,
+        LibWebp
+    };
+
+    // 解码内存中的文件数据，format 为后缀或格式名（为空时按文件头识别）
+    // targetSize 有效时允许解码器直接输出缩小图：结果不小于按比例放入 targetSize 的尺寸，
+    // 不支持缩放解码的后端忽略此参数。used 返回实际使用的后端。
+    // 和 Qt 插件一样按 EXIF 方向旋转（decodeWith 不旋转）。
+    static QImage decode(const QByteArray &data, const QByteArray &format,
+                         const QSize &targetSize = QSize(), Backend *used = nullptr);
+    // 直接后端支持的格式读入内存后解码，其他格式交给 QImageReader
+    static QImage decodeFile(const QString &filePath, const QSize &targetSize = QSize(),
+                             Backend *used = nullptr);
+
+    // 强制使用指定后端（基准测试用），不可用或解码失败时返回空图，不回退
+    static QImage decodeWith(Backend backend, const QByteArray &data, const QByteArray &format,
+                             const QSize &targetSize = QSize());
+
+    // 按格式选择的后端（已考虑编译时启用的库和运行时开关）
+    static Backend backendFor(const QByteArray &format);
+    // 按文件头识别 jpeg / png / webp，其他返回空
+    static QByteArray detectFormat(const QByteArray &data);
+
+    static bool isBackendAvailable(Backend backend);
+    static QVector<Backend> availableBackends();
+    static QString backendName(Backend backend);
+
+    // 关闭后全部格式走 Qt 插件
+    static void setDirectBackendsEnabled(bool enabled);
+    static bool directBackendsEnabled();
+
+    // 按 QImageReader::transformation() 的约定应用 EXIF 方向（先镜像再顺时针旋转 90°）
+    static QImage applyTransformation(const QImage &image, QImageIOHandler::Transformations transformation);
+};
+
+#endif // IMAGECODECS_H
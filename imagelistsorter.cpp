@@ -0,0 +1,315 @@
+// imagelistsorter.cpp
+#include "imagelistsorter.h"
+#include <QCollator>
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrent>
+#include <QDebug>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+// 数字段补零后的宽度（qint64 最多 19 位），更长的数字段保持原样
+const int kNumberWidth = 20;
+// 每个线程一次计算的排序键数
+const int kKeyBandSize = 4096;
+// 丢弃的键超过该数量且超过总数一半时压缩
+const int kMinStaleKeys = 1024;
+
+struct KeyBand {
+    int from = 0;
+    int to = 0;
+    std::vector<QCollatorSortKey> out;
+};
+
+struct MergeStep {
+    int from;
+    int middle;
+    int to;
+};
+
+} // namespace
+
+ImageListSorter::ImageListSorter(Mode mode)
+    : sortMode(mode)
+{
+}
+
+void ImageListSorter::setFolder(const QString &folder)
+{
+    if (folder == folderPath) {
+        return;
+    }
+    folderPath = folder;
+    keys.clear();
+    keyIndex.clear();
+    staleKeys = 0;
+}
+
+void ImageListSorter::forget(const QStringList &fileNames)
+{
+    for (const QString &fileName : fileNames) {
+        if (keyIndex.remove(fileName)) {
+            ++staleKeys;
+        }
+    }
+    if (staleKeys >= kMinStaleKeys && staleKeys * 2 >= int(keys.size())) {
+        compact();
+    }
+}
+
+// 持续写入的采集文件夹中每次改写都会留下一个旧键，这里移除它们并重新编号
+void ImageListSorter::compact()
+{
+    std::vector<Keys> kept;
+    kept.reserve(keyIndex.size());
+    for (auto it = keyIndex.begin(); it != keyIndex.end(); ++it) {
+        kept.push_back(std::move(keys[it.value()]));
+        it.value() = int(kept.size()) - 1;
+    }
+    keys.swap(kept);
+    staleKeys = 0;
+}
+
+// "IMG_0012.jpg" → "IMG_000…0012.jpg"：等宽数字的字典序即数值顺序，可以直接交给排序键
+QString ImageListSorter::collationText(const QString &fileName)
+{
+    QString text;
+    text.reserve(fileName.size() + kNumberWidth);
+    for (int i = 0; i < fileName.size();) {
+        if (!fileName.at(i).isDigit()) {
+            text.append(fileName.at(i++));
+            continue;
+        }
+        int end = i;
+        while (end < fileName.size() && fileName.at(end).isDigit()) {
+            ++end;
+        }
+        int start = i;
+        while (start < end - 1 && fileName.at(start) == QLatin1Char('0')) {
+            ++start;
+        }
+        const int digits = end - start;
+        if (digits < kNumberWidth) {
+            text.append(QString(kNumberWidth - digits, QLatin1Char('0')));
+        }
+        text.append(QStringView(fileName).mid(start, digits));
+        i = end;
+    }
+    return text;
+}
+
+QVector<int> ImageListSorter::keysFor(const QStringList &fileNames)
+{
+    QVector<int> result(fileNames.size(), -1);
+    QStringList missing;
+    QHash<QString, int> missingIndex;
+    for (int i = 0; i < fileNames.size(); ++i) {
+        auto it = keyIndex.constFind(fileNames.at(i));
+        if (it != keyIndex.constEnd()) {
+            result[i] = *it;
+        } else if (!missingIndex.contains(fileNames.at(i))) {
+            missingIndex.insert(fileNames.at(i), missing.size());
+            missing.append(fileNames.at(i));
+        }
+    }
+
+    if (!missing.isEmpty()) {
+        QVector<KeyBand> bands;
+        for (int from = 0; from < missing.size(); from += kKeyBandSize) {
+            KeyBand band;
+            band.from = from;
+            band.to = qMin(from + kKeyBandSize, int(missing.size()));
+            bands.append(band);
+        }
+        // QCollator 不能在线程间共用，每段使用自己的实例
+        QtConcurrent::blockingMap(bands, [&missing](KeyBand &band) {
+            QCollator collator;
+            collator.setCaseSensitivity(Qt::CaseInsensitive);
+            band.out.reserve(band.to - band.from);
+            for (int i = band.from; i < band.to; ++i) {
+                band.out.push_back(collator.sortKey(collationText(missing.at(i))));
+            }
+        });
+
+        keys.reserve(keys.size() + missing.size());
+        for (const KeyBand &band : bands) {
+            for (int i = band.from; i < band.to; ++i) {
+                keys.emplace_back(missing.at(i), band.out[i - band.from]);
+                keyIndex.insert(missing.at(i), int(keys.size()) - 1);
+            }
+        }
+        for (int i = 0; i < fileNames.size(); ++i) {
+            if (result[i] < 0) {
+                result[i] = keyIndex.value(fileNames.at(i));
+            }
+        }
+    }
+
+    // 修改时间和大小只在需要时读取，网络文件夹上按名称排序不会触发 stat
+    if ((sortMode == ByModified || sortMode == BySize) && !folderPath.isEmpty()) {
+        QVector<int> pendingStat;
+        for (int index : std::as_const(result)) {
+            if (!keys[index].statDone) {
+                keys[index].statDone = true;
+                pendingStat.append(index);
+            }
+        }
+        if (!pendingStat.isEmpty()) {
+            const QDir dir(folderPath);
+            Keys *data = keys.data();
+            QtConcurrent::blockingMap(pendingStat, [data, &dir](int index) {
+                QFileInfo info(dir.absoluteFilePath(data[index].name));
+                data[index].modified = info.lastModified().toMSecsSinceEpoch();
+                data[index].size = info.size();
+            });
+        }
+    }
+    return result;
+}
+
+bool ImageListSorter::lessThan(int a, int b) const
+{
+    const Keys &left = keys[a];
+    const Keys &right = keys[b];
+    switch (sortMode) {
+    case ByName:
+        return left.name < right.name;
+    case ByModified:
+        if (left.modified != right.modified) {
+            return left.modified < right.modified;
+        }
+        break;
+    case BySize:
+        if (left.size != right.size) {
+            return left.size < right.size;
+        }
+        break;
+    case ByNaturalName:
+        break;
+    }
+    const int order = left.collation.compare(right.collation);
+    if (order != 0) {
+        return order < 0;
+    }
+    return left.name < right.name;   // "a01" 与 "a1" 之类补零后相同的名称
+}
+
+// 分段并行排序后逐层两两归并（每层的归并也并行）
+void ImageListSorter::parallelSort(QVector<int> &order) const
+{
+    auto less = [this](int a, int b) { return lessThan(a, b); };
+    const int count = order.size();
+    if (count < kParallelSortSize) {
+        std::sort(order.begin(), order.end(), less);
+        return;
+    }
+
+    int *data = order.data();
+    const int bandCount = qBound(2, QThread::idealThreadCount(), 16);
+    QVector<QPair<int, int>> bands;
+    for (int i = 0; i < bandCount; ++i) {
+        bands.append(qMakePair(count * i / bandCount, count * (i + 1) / bandCount));
+    }
+    QtConcurrent::blockingMap(bands, [data, &less](const QPair<int, int> &band) {
+        std::sort(data + band.first, data + band.second, less);
+    });
+
+    while (bands.size() > 1) {
+        QVector<MergeStep> steps;
+        QVector<QPair<int, int>> merged;
+        for (int i = 0; i + 1 < bands.size(); i += 2) {
+            steps.append(MergeStep{bands[i].first, bands[i].second, bands[i + 1].second});
+            merged.append(qMakePair(bands[i].first, bands[i + 1].second));
+        }
+        if (bands.size() % 2) {
+            merged.append(bands.last());
+        }
+        QtConcurrent::blockingMap(steps, [data, &less](const MergeStep &step) {
+            std::inplace_merge(data + step.from, data + step.middle, data + step.to, less);
+        });
+        bands = merged;
+    }
+}
+
+void ImageListSorter::sort(QStringList &fileNames)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (sortMode == ByName) {
+        std::sort(fileNames.begin(), fileNames.end());
+    } else {
+        QVector<int> order = keysFor(fileNames);
+        parallelSort(order);
+        for (int i = 0; i < order.size(); ++i) {
+            fileNames[i] = keys[order[i]].name;
+        }
+    }
+
+    if (fileNames.size() >= kParallelSortSize) {
+        qDebug() << "排序" << fileNames.size() << "个文件，方式:" << modeName(sortMode)
+                 << "耗时" << timer.elapsed() << "ms";
+    }
+}
+
+QStringList ImageListSorter::merge(const QStringList &sorted, const QStringList &added)
+{
+    QStringList result;
+    result.reserve(sorted.size() + added.size());
+    if (sortMode == ByName) {
+        std::merge(sorted.cbegin(), sorted.cend(), added.cbegin(), added.cend(),
+                   std::back_inserter(result));
+        return result;
+    }
+
+    const QVector<int> left = keysFor(sorted);
+    const QVector<int> right = keysFor(added);
+    QVector<int> order;
+    order.reserve(left.size() + right.size());
+    std::merge(left.cbegin(), left.cend(), right.cbegin(), right.cend(), std::back_inserter(order),
+               [this](int a, int b) { return lessThan(a, b); });
+    for (int index : std::as_const(order)) {
+        result.append(keys[index].name);
+    }
+    return result;
+}
+
+bool ImageListSorter::contains(const QStringList &sorted, const QString &fileName)
+{
+    if (sortMode == ByName) {
+        return std::binary_search(sorted.cbegin(), sorted.cend(), fileName);
+    }
+    // 列表中的文件都已有键，只有被查找的文件可能需要计算
+    const int target = keysFor(QStringList{fileName}).first();
+    auto it = std::lower_bound(sorted.cbegin(), sorted.cend(), target,
+                               [this](const QString &name, int index) {
+                                   return lessThan(keyIndex.value(name), index);
+                               });
+    return it != sorted.cend() && *it == fileName;
+}
+
+QString ImageListSorter::modeName(Mode mode)
+{
+    switch (mode) {
+    case ByName: return QStringLiteral("name");
+    case ByNaturalName: return QStringLiteral("natural");
+    case ByModified: return QStringLiteral("modified");
+    case BySize: return QStringLiteral("size");
+    }
+    return QString();
+}
+
+ImageListSorter::Mode ImageListSorter::modeFromName(const QString &name, Mode fallback)
+{
+    for (Mode mode : {ByName, ByNaturalName, ByModified, BySize}) {
+        if (name.compare(modeName(mode), Qt::CaseInsensitive) == 0) {
+            return mode;
+        }
+    }
+    return fallback;
+}
@@ -0,0 +1,74 @@
+// imagelistsorter.h
+#ifndef IMAGELISTSORTER_H
+#define IMAGELISTSORTER_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QCollatorSortKey>
+#include <vector>
+
+// 图片列表排序
+// 每个文件名只计算一次排序键：自然排序用 QCollator（当前区域、不区分大小写）生成的 QCollatorSortKey，
+// 数字段先补零到固定宽度，"img2" 排在 "img10" 之前且不依赖平台是否支持 numericMode；
+// 修改时间和大小排序首次需要时才 stat。切换排序方式只比较已缓存的键。
+// 键的计算和大列表的排序都在 QtConcurrent 线程池中分段并行。只在一个线程中使用。
+class ImageListSorter
+{
+public:
+    enum Mode {
+        ByName,         // 原来的字典序（区分大小写，按 UTF-16 码位）
+        ByNaturalName,
+        ByModified,     // 旧的在前
+        BySize          // 小的在前
+    };
+
+    explicit ImageListSorter(Mode mode = ByNaturalName);
+
+    void setMode(Mode mode) { sortMode = mode; }
+    Mode mode() const { return sortMode; }
+
+    // 修改时间和大小按 folder 中的文件 stat；切换文件夹时丢弃已缓存的键
+    void setFolder(const QString &folder);
+    // 文件被删除或改写后丢弃它的键（下次重新计算）；丢弃的键累积到一半时压缩存储
+    void forget(const QStringList &fileNames);
+
+    void sort(QStringList &fileNames);
+    // 合并两个已按当前方式排好的列表
+    QStringList merge(const QStringList &sorted, const QStringList &added);
+    // 在已排好的列表中二分查找
+    bool contains(const QStringList &sorted, const QString &fileName);
+
+    static QString modeName(Mode mode);
+    static Mode modeFromName(const QString &name, Mode fallback = ByNaturalName);
+
+    // 超过此长度才分段并行排序
+    static constexpr int kParallelSortSize = 32 * 1024;
+
+private:
+    struct Keys {
+        Keys(const QString &fileName, const QCollatorSortKey &key)
+            : name(fileName), collation(key) {}
+        QString name;
+        QCollatorSortKey collation;
+        qint64 modified = 0;
+        qint64 size = 0;
+        bool statDone = false;
+    };
+
+    // 返回每个文件名的键编号，缺少的键（以及当前方式需要而尚未 stat 的）并行补齐
+    QVector<int> keysFor(const QStringList &fileNames);
+    bool lessThan(int a, int b) const;
+    void parallelSort(QVector<int> &order) const;
+    static QString collationText(const QString &fileName);
+    void compact();
+
+    Mode sortMode;
+    QString folderPath;
+    std::vector<Keys> keys;
+    QHash<QString, int> keyIndex;
+    int staleKeys = 0;   // keys 中已不被 keyIndex 引用的元素数
+};
+
+#endif // IMAGELISTSORTER_H
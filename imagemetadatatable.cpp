@@ -0,0 +1,211 @@
+// imagemetadatatable.cpp
+#include "imagemetadatatable.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QImageReader>
+#include <QImageIOHandler>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QVector>
+#include <QtConcurrent>
+#include <QDebug>
+
+namespace {
+
+const quint32 kTableMagic = 0x5056544d; // "PVTM"
+const quint32 kTableVersion = 1;
+// 保存的一项至少占用的字节数（空文件名和空格式各 4 字节长度），用来检查表头中的条目数
+const qint64 kMinEntryBytes = 4 + 4 + 4 + 4 + 4 + 1 + 8 + 8;
+
+struct ProbeJob {
+    QString fileName;
+    ImageMetadataTable::Entry entry;
+};
+
+} // namespace
+
+QSize ImageMetadataTable::Entry::displaySize() const
+{
+    if (transformation & QImageIOHandler::TransformationRotate90) {
+        return QSize(height, width);
+    }
+    return size();
+}
+
+ImageMetadataTable::ImageMetadataTable(const QString &folderPath)
+    : folderPath(QDir(folderPath).absolutePath())
+{
+}
+
+ImageMetadataTable::Entry ImageMetadataTable::probeFile(const QString &filePath)
+{
+    Entry entry;
+    QFileInfo info(filePath);
+    entry.fileSize = info.size();
+    entry.modified = info.lastModified().toMSecsSinceEpoch();
+
+    // 只读文件头：size()/imageCount()/transformation() 都不会解码像素
+    QImageReader reader(filePath);
+    reader.setAutoTransform(false);
+    const QSize size = reader.size();
+    if (size.isValid()) {
+        entry.width = size.width();
+        entry.height = size.height();
+    }
+    entry.format = reader.format();
+    entry.frameCount = qMax(0, reader.imageCount());
+    entry.transformation = static_cast<quint8>(reader.transformation());
+    return entry;
+}
+
+bool ImageMetadataTable::build(const QStringList &fileNames, QThreadPool *pool,
+                               const std::function<bool()> &cancelled)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const bool loaded = load();
+    const QHash<QString, Entry> previous = entries;
+    const QDir dir(folderPath);
+
+    QVector<ProbeJob> jobs;
+    jobs.reserve(fileNames.size());
+    for (const QString &fileName : fileNames) {
+        jobs.append(ProbeJob{fileName, Entry()});
+    }
+
+    // 每个文件先比较大小和修改时间，没变化的直接沿用保存的结果
+    QAtomicInt probed(0);
+    QtConcurrent::blockingMap(pool, jobs, [&](ProbeJob &job) {
+        if (cancelled && cancelled()) {
+            return;
+        }
+        const QString filePath = dir.absoluteFilePath(job.fileName);
+        auto it = previous.constFind(job.fileName);
+        if (it != previous.constEnd()) {
+            QFileInfo info(filePath);
+            if (it->fileSize == info.size() &&
+                it->modified == info.lastModified().toMSecsSinceEpoch()) {
+                job.entry = *it;
+                return;
+            }
+        }
+        job.entry = probeFile(filePath);
+        probed.fetchAndAddRelaxed(1);
+    });
+
+    if (cancelled && cancelled()) {
+        return false;
+    }
+
+    entries.clear();
+    entries.reserve(jobs.size());
+    for (const ProbeJob &job : jobs) {
+        entries.insert(job.fileName, job.entry);
+    }
+
+    qDebug() << "文件头信息:" << folderPath << entries.size() << "个文件，重新读取"
+             << probed.loadRelaxed() << "个，耗时" << timer.elapsed() << "ms"
+             << (loaded ? "(已加载保存的表)" : "");
+
+    if (probed.loadRelaxed() > 0 || entries.size() != previous.size()) {
+        save();
+    }
+    return true;
+}
+
+QSize ImageMetadataTable::imageSize(const QString &filePath) const
+{
+    // 递归浏览时表中的文件名是相对路径
+    const QString relativePath = QDir(folderPath).relativeFilePath(QFileInfo(filePath).absoluteFilePath());
+    if (relativePath.startsWith(QLatin1String("../")) || QDir::isAbsolutePath(relativePath)) {
+        return QSize();
+    }
+    return entries.value(relativePath).size();
+}
+
+void ImageMetadataTable::remove(const QStringList &fileNames)
+{
+    for (const QString &fileName : fileNames) {
+        entries.remove(fileName);
+    }
+}
+
+QString ImageMetadataTable::tableFilePath() const
+{
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+                       "/folder_metadata";
+    QByteArray hash = QCryptographicHash::hash(folderPath.toUtf8(),
+                                               QCryptographicHash::Sha1).toHex();
+    return cacheDir + "/" + QString::fromLatin1(hash) + ".pvmeta";
+}
+
+bool ImageMetadataTable::load()
+{
+    QFile file(tableFilePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString storedFolder;
+    in >> magic >> version >> storedFolder;
+
+    // 哈希碰撞或格式不匹配时重新读取
+    if (magic != kTableMagic || version != kTableVersion || storedFolder != folderPath) {
+        return false;
+    }
+
+    qint32 entryCount = 0;
+    in >> entryCount;
+    // 损坏或截断的文件不能让条目数决定预留多少内存
+    if (entryCount < 0 || entryCount > file.size() / kMinEntryBytes) {
+        return false;
+    }
+    entries.reserve(entryCount);
+    for (qint32 i = 0; i < entryCount; ++i) {
+        QString fileName;
+        Entry entry;
+        in >> fileName >> entry.width >> entry.height >> entry.format >> entry.frameCount
+           >> entry.transformation >> entry.fileSize >> entry.modified;
+        entries.insert(fileName, entry);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        entries.clear();
+        return false;
+    }
+    return true;
+}
+
+bool ImageMetadataTable::save() const
+{
+    QString path = tableFilePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "无法保存文件头信息:" << path;
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << kTableMagic << kTableVersion << folderPath;
+
+    out << static_cast<qint32>(entries.size());
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        const Entry &entry = it.value();
+        out << it.key() << entry.width << entry.height << entry.format << entry.frameCount
+            << entry.transformation << entry.fileSize << entry.modified;
+    }
+
+    return out.status() == QDataStream::Ok;
+}
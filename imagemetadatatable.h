@@ -0,0 +1,64 @@
+// imagemetadatatable.h
+#ifndef IMAGEMETADATATABLE_H
+#define IMAGEMETADATATABLE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QSize>
+#include <functional>
+
+class QThreadPool;
+
+// 文件夹内图片的文件头信息表（尺寸、格式、帧数、EXIF 方向）
+// 只用 QImageReader 读取文件头，不解码像素；整个文件夹在独立线程池中并行读取。
+// 按文件大小和修改时间判断是否过期，结果保存在缓存目录，下次打开同一文件夹只补读变化的文件。
+// build() 完成后表不再修改，可以在多个线程中只读共享。
+class ImageMetadataTable
+{
+public:
+    struct Entry {
+        qint32 width = 0;
+        qint32 height = 0;
+        QByteArray format;
+        qint32 frameCount = 0;      // 0 表示格式不提供帧数
+        quint8 transformation = 0;  // QImageIOHandler::Transformations
+        qint64 fileSize = -1;
+        qint64 modified = 0;
+
+        bool isValid() const { return width > 0 && height > 0; }
+        QSize size() const { return QSize(width, height); }
+        // 应用 EXIF 方向后的显示尺寸
+        QSize displaySize() const;
+    };
+
+    explicit ImageMetadataTable(const QString &folderPath);
+
+    // 读取单个文件的文件头（任意线程）
+    static Entry probeFile(const QString &filePath);
+
+    // 加载已保存的表，对新增或修改过的文件在 pool 中并行读取文件头，有变化时保存。
+    // cancelled 返回 true 时尽快结束并返回 false（不保存）
+    bool build(const QStringList &fileNames, QThreadPool *pool,
+               const std::function<bool()> &cancelled = std::function<bool()>());
+
+    QString folder() const { return folderPath; }
+    int count() const { return entries.size(); }
+    bool contains(const QString &fileName) const { return entries.contains(fileName); }
+    Entry entry(const QString &fileName) const { return entries.value(fileName); }
+    // 按完整路径查询原始尺寸（包括子文件夹中的文件），不属于本文件夹或未知时返回空尺寸
+    QSize imageSize(const QString &filePath) const;
+    // 删除或改写过的文件不再使用旧信息（共享的表由调用方复制后再修改）
+    void remove(const QStringList &fileNames);
+
+private:
+    bool load();
+    bool save() const;
+    QString tableFilePath() const;
+
+    QString folderPath;
+    QHash<QString, Entry> entries;
+};
+
+#endif // IMAGEMETADATATABLE_H
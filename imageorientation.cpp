@@ -0,0 +1,283 @@
+// imageorientation.cpp
+#include "imageorientation.h"
+#include "pixelbufferpool.h"
+#include <QtConcurrent>
+#include <QThread>
+#include <QDebug>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ORIENTATION_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ORIENTATION_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// 转置时按 64x64 像素分块（16KB），源和目标的当前块都能留在 L1 中
+const int kBlock = 64;
+const qint64 kParallelPixels = 1024 * 1024;
+
+// 任意方向都可以写成：可选转置，再可选地翻转输出的 x / y
+// out(x, y) = T(mirrorX ? W-1-x : x, mirrorY ? H-1-y : y)，其中 T(u, v) = 转置 ? src(v, u) : src(u, v)
+struct Plan {
+    bool transpose;
+    bool mirrorX;
+    bool mirrorY;
+};
+
+struct Bitmap {
+    const uchar *sourceBits;
+    qsizetype sourceStride;
+    uchar *targetBits;
+    qsizetype targetStride;
+    int outWidth;
+    int outHeight;
+};
+
+inline const quint32 *sourceLine(const Bitmap &bitmap, int y)
+{
+    return reinterpret_cast<const quint32 *>(bitmap.sourceBits + y * bitmap.sourceStride);
+}
+
+inline quint32 *targetLine(const Bitmap &bitmap, int y)
+{
+    return reinterpret_cast<quint32 *>(bitmap.targetBits + y * bitmap.targetStride);
+}
+
+// 不转置：垂直翻转只是换行顺序，水平翻转为整行倒序
+void flipRows(const Bitmap &bitmap, const Plan &plan, int from, int to)
+{
+    const int width = bitmap.outWidth;
+    for (int y = from; y < to; ++y) {
+        const quint32 *src = sourceLine(bitmap, plan.mirrorY ? bitmap.outHeight - 1 - y : y);
+        quint32 *dst = targetLine(bitmap, y);
+        if (!plan.mirrorX) {
+            std::memcpy(dst, src, width * sizeof(quint32));
+            continue;
+        }
+
+        int x = 0;
+#if defined(ORIENTATION_SSE2)
+        for (; x + 4 <= width; x += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + width - x - 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_shuffle_epi32(v, 0x1B));
+        }
+#elif defined(ORIENTATION_NEON)
+        for (; x + 4 <= width; x += 4) {
+            uint32x4_t v = vrev64q_u32(vld1q_u32(src + width - x - 4));
+            vst1q_u32(dst + x, vcombine_u32(vget_high_u32(v), vget_low_u32(v)));
+        }
+#endif
+        for (; x < width; ++x) {
+            dst[x] = src[width - 1 - x];
+        }
+    }
+}
+
+// 转置的一个 4x4 块：读 4 个源行（对应输出的 4 列）各 4 个连续像素，转置后写成 4 个输出行
+// rows[k] 是输出第 x0+k 列对应的源行，column 是这 4 行中最左侧的源列
+inline void transposeQuad(const Bitmap &bitmap, const Plan &plan, int x0, int y0,
+                          const quint32 *const rows[4], int column)
+{
+#if defined(ORIENTATION_SSE2)
+    __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[0] + column));
+    __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[1] + column));
+    __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[2] + column));
+    __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[3] + column));
+    __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+    __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+    __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+    __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+    const __m128i out[4] = {
+        _mm_unpacklo_epi64(t0, t1),
+        _mm_unpackhi_epi64(t0, t1),
+        _mm_unpacklo_epi64(t2, t3),
+        _mm_unpackhi_epi64(t2, t3),
+    };
+    for (int j = 0; j < 4; ++j) {
+        int y = plan.mirrorY ? y0 + 3 - j : y0 + j;
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(targetLine(bitmap, y) + x0), out[j]);
+    }
+#elif defined(ORIENTATION_NEON)
+    uint32x4x2_t a = vtrnq_u32(vld1q_u32(rows[0] + column), vld1q_u32(rows[1] + column));
+    uint32x4x2_t b = vtrnq_u32(vld1q_u32(rows[2] + column), vld1q_u32(rows[3] + column));
+    const uint32x4_t out[4] = {
+        vcombine_u32(vget_low_u32(a.val[0]), vget_low_u32(b.val[0])),
+        vcombine_u32(vget_low_u32(a.val[1]), vget_low_u32(b.val[1])),
+        vcombine_u32(vget_high_u32(a.val[0]), vget_high_u32(b.val[0])),
+        vcombine_u32(vget_high_u32(a.val[1]), vget_high_u32(b.val[1])),
+    };
+    for (int j = 0; j < 4; ++j) {
+        int y = plan.mirrorY ? y0 + 3 - j : y0 + j;
+        vst1q_u32(targetLine(bitmap, y) + x0, out[j]);
+    }
+#else
+    for (int j = 0; j < 4; ++j) {
+        int y = plan.mirrorY ? y0 + 3 - j : y0 + j;
+        quint32 *dst = targetLine(bitmap, y) + x0;
+        for (int k = 0; k < 4; ++k) {
+            dst[k] = rows[k][column + j];
+        }
+    }
+#endif
+}
+
+// 转置：输出行 y 读取源列 v(y)，输出列 x 读取源行 u(x)
+void transposeRows(const Bitmap &bitmap, const Plan &plan, int from, int to)
+{
+    auto sourceRow = [&](int x) {
+        return sourceLine(bitmap, plan.mirrorX ? bitmap.outWidth - 1 - x : x);
+    };
+    auto sourceColumn = [&](int y) {
+        return plan.mirrorY ? bitmap.outHeight - 1 - y : y;
+    };
+
+    for (int blockY = from; blockY < to; blockY += kBlock) {
+        const int blockBottom = qMin(blockY + kBlock, to);
+        for (int blockX = 0; blockX < bitmap.outWidth; blockX += kBlock) {
+            const int blockRight = qMin(blockX + kBlock, bitmap.outWidth);
+
+            int y = blockY;
+            for (; y + 4 <= blockBottom; y += 4) {
+                // 4 个输出行对应的源列连续，取其中最小的一列作为读取起点
+                const int column = plan.mirrorY ? sourceColumn(y + 3) : sourceColumn(y);
+                int x = blockX;
+                for (; x + 4 <= blockRight; x += 4) {
+                    const quint32 *const rows[4] = {
+                        sourceRow(x), sourceRow(x + 1), sourceRow(x + 2), sourceRow(x + 3)
+                    };
+                    transposeQuad(bitmap, plan, x, y, rows, column);
+                }
+                for (; x < blockRight; ++x) {
+                    const quint32 *src = sourceRow(x);
+                    for (int j = 0; j < 4; ++j) {
+                        targetLine(bitmap, y + j)[x] = src[sourceColumn(y + j)];
+                    }
+                }
+            }
+            for (; y < blockBottom; ++y) {
+                quint32 *dst = targetLine(bitmap, y);
+                const int column = sourceColumn(y);
+                for (int x = blockX; x < blockRight; ++x) {
+                    dst[x] = sourceRow(x)[column];
+                }
+            }
+        }
+    }
+}
+
+// 按输出行分成若干个块对齐的行带并行处理
+template <typename Fn>
+void forEachBand(int rows, qint64 pixels, Fn fn)
+{
+    const int threads = QThread::idealThreadCount();
+    const int blocks = (rows + kBlock - 1) / kBlock;
+    if (pixels < kParallelPixels || threads <= 1 || blocks < 2) {
+        fn(0, rows);
+        return;
+    }
+
+    const int bandCount = qMin(threads * 2, blocks);
+    QVector<QPair<int, int>> bands;
+    for (int i = 0; i < bandCount; ++i) {
+        int from = blocks * i / bandCount * kBlock;
+        int to = qMin(rows, blocks * (i + 1) / bandCount * kBlock);
+        bands.append(qMakePair(from, to));
+    }
+    QtConcurrent::blockingMap(bands, [&fn](const QPair<int, int> &band) {
+        fn(band.first, band.second);
+    });
+}
+
+} // namespace
+
+ImageOrientation::ImageOrientation(int rotation, bool mirrorHorizontal, bool mirrorVertical)
+    : rotation(((rotation % 360) + 360) % 360 / 90 * 90),
+      mirrorHorizontal(mirrorHorizontal),
+      mirrorVertical(mirrorVertical)
+{
+}
+
+bool ImageOrientation::isIdentity() const
+{
+    return rotation == 0 && !mirrorHorizontal && !mirrorVertical;
+}
+
+bool ImageOrientation::swapsDimensions() const
+{
+    return rotation == 90 || rotation == 270;
+}
+
+QSize ImageOrientation::mapSize(const QSize &size) const
+{
+    return swapsDimensions() ? size.transposed() : size;
+}
+
+QSizeF ImageOrientation::mapSize(const QSizeF &size) const
+{
+    return swapsDimensions() ? size.transposed() : size;
+}
+
+QTransform ImageOrientation::transform(const QSizeF &size) const
+{
+    const QSizeF mapped = mapSize(size);
+
+    // 绕中心旋转，再沿显示方向镜像（QTransform 按调用的逆序作用于坐标）
+    QTransform transform;
+    transform.translate(mapped.width() / 2.0, mapped.height() / 2.0);
+    transform.scale(mirrorHorizontal ? -1.0 : 1.0, mirrorVertical ? -1.0 : 1.0);
+    transform.rotate(rotation);
+    transform.translate(-size.width() / 2.0, -size.height() / 2.0);
+    return transform;
+}
+
+QImage ImageOrientation::apply(const QImage &image) const
+{
+    if (image.isNull() || isIdentity()) {
+        return image;
+    }
+
+    if (image.depth() != 32) {
+        // 90° 整数倍的最近邻变换是精确的像素重排
+        return image.transformed(transform(QSizeF(image.size())), Qt::FastTransformation);
+    }
+
+    Plan plan;
+    plan.transpose = swapsDimensions();
+    plan.mirrorX = (rotation == 90 || rotation == 180) != mirrorHorizontal;
+    plan.mirrorY = (rotation == 180 || rotation == 270) != mirrorVertical;
+
+    const QSize outSize = mapSize(image.size());
+    QImage result = PixelBufferPool::shared().createImage(outSize, image.format());
+    if (result.isNull()) {
+        qWarning() << "ImageOrientation: 无法分配" << outSize << "的图像";
+        return QImage();
+    }
+    result.setColorSpace(image.colorSpace());
+    result.setDotsPerMeterX(plan.transpose ? image.dotsPerMeterY() : image.dotsPerMeterX());
+    result.setDotsPerMeterY(plan.transpose ? image.dotsPerMeterX() : image.dotsPerMeterY());
+
+    // 并行时不能调用会分离数据的 scanLine，直接使用原始指针
+    Bitmap bitmap;
+    bitmap.sourceBits = image.constBits();
+    bitmap.sourceStride = image.bytesPerLine();
+    bitmap.targetBits = result.bits();
+    bitmap.targetStride = result.bytesPerLine();
+    bitmap.outWidth = outSize.width();
+    bitmap.outHeight = outSize.height();
+
+    const qint64 pixels = static_cast<qint64>(outSize.width()) * outSize.height();
+    forEachBand(outSize.height(), pixels, [&](int from, int to) {
+        if (plan.transpose) {
+            transposeRows(bitmap, plan, from, to);
+        } else {
+            flipRows(bitmap, plan, from, to);
+        }
+    });
+    return result;
+}
@@ -0,0 +1,37 @@
+// imageorientation.h
+#ifndef IMAGEORIENTATION_H
+#define IMAGEORIENTATION_H
+
+#include <QImage>
+#include <QSize>
+#include <QSizeF>
+#include <QTransform>
+
+// 图片方向：先旋转 90° 的整数倍，再沿屏幕方向水平/垂直镜像
+// 显示时只作为绘制变换交给 QPainter，不生成新图；
+// 保存、复制等确实需要像素时，才用分块转置/翻转生成实际图像。
+class ImageOrientation
+{
+public:
+    ImageOrientation() = default;
+    ImageOrientation(int rotation, bool mirrorHorizontal, bool mirrorVertical);
+
+    bool isIdentity() const;
+    // 旋转 90° / 270° 时宽高互换
+    bool swapsDimensions() const;
+    QSize mapSize(const QSize &size) const;
+    QSizeF mapSize(const QSizeF &size) const;
+
+    // 把 (0, 0, size) 的原图坐标映射到 (0, 0, mapSize(size)) 的显示坐标
+    QTransform transform(const QSizeF &size) const;
+
+    // 生成变换后的图像；32 位格式走分块 SIMD 转置，其余格式交给 QImage::transformed
+    QImage apply(const QImage &image) const;
+
+private:
+    int rotation = 0;
+    bool mirrorHorizontal = false;
+    bool mirrorVertical = false;
+};
+
+#endif // IMAGEORIENTATION_H
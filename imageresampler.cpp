@@ -0,0 +1,714 @@
+// imageresampler.cpp
+#include "imageresampler.h"
+#include "pixelbufferpool.h"
+#include <QtConcurrent>
+#include <QAtomicInt>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RESAMPLER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RESAMPLER_NEON
+#include <arm_neon.h>
+#endif
+
+// GCC/Clang 需要按函数开启指令集，MSVC 可以直接使用内建函数
+#if defined(RESAMPLER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RESAMPLER_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define RESAMPLER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RESAMPLER_TARGET_SSE41
+#define RESAMPLER_TARGET_AVX2
+#endif
+
+namespace {
+
+const int kWeightBits = 14;
+const int kWeightOne = 1 << kWeightBits;
+const int kRounding = 1 << (kWeightBits - 1);
+const double kPi = 3.14159265358979323846;
+
+// 每个输出像素的输入范围与定点权重
+struct Contributions {
+    int taps = 0;                   // 每个输出像素占用的权重槽数
+    std::vector<int> start;         // 第一个输入像素
+    std::vector<int> count;         // 输入像素数
+    std::vector<int16_t> weights;   // weights[out * taps + k]，总和为 kWeightOne
+};
+
+double lanczos3(double x)
+{
+    x = std::fabs(x);
+    if (x < 1e-8) {
+        return 1.0;
+    }
+    if (x >= 3.0) {
+        return 0.0;
+    }
+    const double pix = kPi * x;
+    return 3.0 * std::sin(pix) * std::sin(pix / 3.0) / (pix * pix);
+}
+
+Contributions computeContributions(int inSize, int outSize, bool area)
+{
+    Contributions result;
+    const double scale = static_cast<double>(inSize) / outSize;
+    const double filterScale = std::max(scale, 1.0);
+    const double support = area ? scale * 0.5 : 3.0 * filterScale;
+
+    result.taps = static_cast<int>(std::ceil(support * 2.0)) + 2;
+    result.start.resize(outSize);
+    result.count.resize(outSize);
+    result.weights.assign(static_cast<size_t>(outSize) * result.taps, 0);
+
+    std::vector<double> raw(result.taps);
+    for (int out = 0; out < outSize; ++out) {
+        const double center = (out + 0.5) * scale;
+        int first = std::max(0, static_cast<int>(std::floor(center - support)));
+        int last = std::min(inSize, static_cast<int>(std::ceil(center + support)));
+        last = std::min(last, first + result.taps);
+
+        double total = 0.0;
+        int n = 0;
+        for (int i = first; i < last; ++i, ++n) {
+            double w;
+            if (area) {
+                // 输入像素 [i, i+1) 与输出像素覆盖区间的重叠长度
+                const double left = std::max<double>(i, center - support);
+                const double right = std::min<double>(i + 1, center + support);
+                w = std::max(0.0, right - left);
+            } else {
+                w = lanczos3((i + 0.5 - center) / filterScale);
+            }
+            raw[n] = w;
+            total += w;
+        }
+
+        // 去掉两端权重为 0 的像素
+        int skip = 0;
+        while (skip < n - 1 && raw[skip] == 0.0) {
+            ++skip;
+        }
+        while (n - 1 > skip && raw[n - 1] == 0.0) {
+            --n;
+        }
+
+        int16_t *weights = &result.weights[static_cast<size_t>(out) * result.taps];
+        int sum = 0;
+        int largest = skip;
+        for (int k = skip; k < n; ++k) {
+            int w = static_cast<int>(std::lround(raw[k] / (total != 0.0 ? total : 1.0) * kWeightOne));
+            weights[k - skip] = static_cast<int16_t>(w);
+            sum += w;
+            if (std::fabs(raw[k]) > std::fabs(raw[largest])) {
+                largest = k;
+            }
+        }
+        // 舍入误差补到最大的权重上，保证总和精确为 1（纯色输入时输出不变）
+        weights[largest - skip] = static_cast<int16_t>(weights[largest - skip] + (kWeightOne - sum));
+
+        result.start[out] = first + skip;
+        result.count[out] = n - skip;
+    }
+    return result;
+}
+
+inline unsigned char clampToByte(int value)
+{
+    return static_cast<unsigned char>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+inline int32_t weightPair(int16_t w0, int16_t w1)
+{
+    return static_cast<int32_t>(static_cast<uint32_t>(static_cast<uint16_t>(w0)) |
+                                (static_cast<uint32_t>(static_cast<uint16_t>(w1)) << 16));
+}
+
+typedef void (*HorizontalFn)(const unsigned char *src, unsigned char *dst, int outWidth,
+                             const Contributions &c);
+typedef void (*VerticalFn)(const unsigned char *src, ptrdiff_t stride, unsigned char *dst,
+                           int widthBytes, int start, int count, const int16_t *weights);
+
+// ---- 标量实现 ----
+
+void horizontalScalar(const unsigned char *src, unsigned char *dst, int outWidth, const Contributions &c)
+{
+    for (int x = 0; x < outWidth; ++x) {
+        const int16_t *w = &c.weights[static_cast<size_t>(x) * c.taps];
+        const unsigned char *p = src + static_cast<ptrdiff_t>(c.start[x]) * 4;
+        int acc0 = kRounding, acc1 = kRounding, acc2 = kRounding, acc3 = kRounding;
+        for (int k = 0; k < c.count[x]; ++k, p += 4) {
+            acc0 += p[0] * w[k];
+            acc1 += p[1] * w[k];
+            acc2 += p[2] * w[k];
+            acc3 += p[3] * w[k];
+        }
+        unsigned char *out = dst + x * 4;
+        out[0] = clampToByte(acc0 >> kWeightBits);
+        out[1] = clampToByte(acc1 >> kWeightBits);
+        out[2] = clampToByte(acc2 >> kWeightBits);
+        out[3] = clampToByte(acc3 >> kWeightBits);
+    }
+}
+
+void verticalScalarRange(const unsigned char *src, ptrdiff_t stride, unsigned char *dst,
+                         int fromByte, int toByte, int start, int count, const int16_t *weights)
+{
+    for (int b = fromByte; b < toByte; ++b) {
+        int acc = kRounding;
+        const unsigned char *p = src + static_cast<ptrdiff_t>(start) * stride + b;
+        for (int k = 0; k < count; ++k, p += stride) {
+            acc += *p * weights[k];
+        }
+        dst[b] = clampToByte(acc >> kWeightBits);
+    }
+}
+
+void verticalScalar(const unsigned char *src, ptrdiff_t stride, unsigned char *dst,
+                    int widthBytes, int start, int count, const int16_t *weights)
+{
+    verticalScalarRange(src, stride, dst, 0, widthBytes, start, count, weights);
+}
+
+#ifdef RESAMPLER_X86
+
+// ---- SSE4.1 ----
+// 水平：一次取两个相邻像素，按通道交错成 (p0, p1) 的 16 位对，与 (w0, w1) 做 madd
+
+RESAMPLER_TARGET_SSE41
+inline __m128i horizontalTailSse41(const unsigned char *p, const int16_t *w, int k, int count, __m128i acc)
+{
+    const __m128i mask = _mm_setr_epi8(0, -1, 4, -1, 1, -1, 5, -1, 2, -1, 6, -1, 3, -1, 7, -1);
+    for (; k + 1 < count; k += 2) {
+        __m128i pixels = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + k * 4));
+        __m128i weights = _mm_set1_epi32(weightPair(w[k], w[k + 1]));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_shuffle_epi8(pixels, mask), weights));
+    }
+    if (k < count) {
+        int32_t pixel;
+        std::memcpy(&pixel, p + k * 4, 4);
+        __m128i weights = _mm_set1_epi32(weightPair(w[k], 0));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_shuffle_epi8(_mm_cvtsi32_si128(pixel), mask), weights));
+    }
+    return acc;
+}
+
+RESAMPLER_TARGET_SSE41
+inline void storePixelSse41(unsigned char *dst, __m128i acc)
+{
+    acc = _mm_srai_epi32(acc, kWeightBits);
+    __m128i packed = _mm_packus_epi16(_mm_packs_epi32(acc, acc), _mm_setzero_si128());
+    int32_t pixel = _mm_cvtsi128_si32(packed);
+    std::memcpy(dst, &pixel, 4);
+}
+
+RESAMPLER_TARGET_SSE41
+void horizontalSse41(const unsigned char *src, unsigned char *dst, int outWidth, const Contributions &c)
+{
+    const __m128i rounding = _mm_set1_epi32(kRounding);
+    for (int x = 0; x < outWidth; ++x) {
+        const int16_t *w = &c.weights[static_cast<size_t>(x) * c.taps];
+        const unsigned char *p = src + static_cast<ptrdiff_t>(c.start[x]) * 4;
+        __m128i acc = horizontalTailSse41(p, w, 0, c.count[x], rounding);
+        storePixelSse41(dst + x * 4, acc);
+    }
+}
+
+// 垂直：两行对应字节交错成 16 位对，一次处理两个像素（8 字节）
+RESAMPLER_TARGET_SSE41
+int verticalBlocksSse41(const unsigned char *src, ptrdiff_t stride, unsigned char *dst,
+                        int fromByte, int widthBytes, int start, int count, const int16_t *weights)
+{
+    const __m128i rounding = _mm_set1_epi32(kRounding);
+    const __m128i zero = _mm_setzero_si128();
+    int b = fromByte;
+    for (; b + 8 <= widthBytes; b += 8) {
+        __m128i acc0 = rounding;
+        __m128i acc1 = rounding;
+        const unsigned char *row = src + static_cast<ptrdiff_t>(start) * stride + b;
+        int k = 0;
+        for (; k + 1 < count; k += 2, row += 2 * stride) {
+            __m128i r0 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(row));
+            __m128i r1 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + stride));
+            __m128i interleaved = _mm_unpacklo_epi8(r0, r1);
+            __m128i w = _mm_set1_epi32(weightPair(weights[k], weights[k + 1]));
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi8(interleaved, zero), w));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi8(interleaved, zero), w));
+        }
+        if (k < count) {
+            __m128i r0 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(row));
+            __m128i interleaved = _mm_unpacklo_epi8(r0, zero);
+            __m128i w = _mm_set1_epi32(weightPair(weights[k], 0));
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi8(interleaved, zero), w));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi8(interleaved, zero), w));
+        }
+        acc0 = _mm_srai_epi32(acc0, kWeightBits);
+        acc1 = _mm_srai_epi32(acc1, kWeightBits);
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(acc0, acc1), zero);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + b), packed);
+    }
+    return b;
+}
+
+RESAMPLER_TARGET_SSE41
+void verticalSse41(const unsigned char *src, ptrdiff_t stride, unsigned char *dst,
+                   int widthBytes, int start, int count, const int16_t *weights)
+{
+    int b = verticalBlocksSse41(src, stride, dst, 0, widthBytes, start, count, weights);
+    verticalScalarRange(src, stride, dst, b, widthBytes, start, count, weights);
+}
+
+// ---- AVX2 ----
+// 水平：一次取四个像素，低 128 位处理前两个、高 128 位处理后两个
+
+RESAMPLER_TARGET_AVX2
+void horizontalAvx2(const unsigned char *src, unsigned char *dst, int outWidth, const Contributions &c)
+{
+    const __m256i mask = _mm256_setr_epi8(0, -1, 4, -1, 1, -1, 5, -1, 2, -1, 6, -1, 3, -1, 7, -1,
+                                          8, -1, 12, -1, 9, -1, 13, -1, 10, -1, 14, -1, 11, -1, 15, -1);
+    const __m128i pairMask = _mm_setr_epi8(0, -1, 4, -1, 1, -1, 5, -1, 2, -1, 6, -1, 3, -1, 7, -1);
+    const __m128i rounding = _mm_set1_epi32(kRounding);
+
+    for (int x = 0; x < outWidth; ++x) {
+        const int16_t *w = &c.weights[static_cast<size_t>(x) * c.taps];
+        const unsigned char *p = src + static_cast<ptrdiff_t>(c.start[x]) * 4;
+        const int count = c.count[x];
+
+        __m256i acc256 = _mm256_setzero_si256();
+        int k = 0;
+        for (; k + 3 < count; k += 4) {
+            __m128i four = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + k * 4));
+            __m256i pixels = _mm256_broadcastsi128_si256(four);
+            __m256i weights = _mm256_setr_epi32(weightPair(w[k], w[k + 1]), weightPair(w[k], w[k + 1]),
+                                                weightPair(w[k], w[k + 1]), weightPair(w[k], w[k + 1]),
+                                                weightPair(w[k + 2], w[k + 3]), weightPair(w[k + 2], w[k + 3]),
+                                                weightPair(w[k + 2], w[k + 3]), weightPair(w[k + 2], w[k + 3]));
+            acc256 = _mm256_add_epi32(acc256, _mm256_madd_epi16(_mm256_shuffle_epi8(pixels, mask), weights));
+        }
+
+        __m128i acc = _mm_add_epi32(_mm_add_epi32(_mm256_castsi256_si128(acc256),
+                                                  _mm256_extracti128_si256(acc256, 1)),
+                                    rounding);
+        for (; k + 1 < count; k += 2) {
+            __m128i pixels = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + k * 4));
+            __m128i weights = _mm_set1_epi32(weightPair(w[k], w[k + 1]));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_shuffle_epi8(pixels, pairMask), weights));
+        }
+        if (k < count) {
+            int32_t pixel;
+            std::memcpy(&pixel, p + k * 4, 4);
+            __m128i weights = _mm_set1_epi32(weightPair(w[k], 0));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_shuffle_epi8(_mm_cvtsi32_si128(pixel), pairMask), weights));
+        }
+
+        acc = _mm_srai_epi32(acc, kWeightBits);
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(acc, acc), _mm_setzero_si128());
+        int32_t pixel = _mm_cvtsi128_si32(packed);
+        std::memcpy(dst + x * 4, &pixel, 4);
+    }
+}
+
+// 垂直：一次处理四个像素（16 字节）
+RESAMPLER_TARGET_AVX2
+void verticalAvx2(const unsigned char *src, ptrdiff_t stride, unsigned char *dst,
+                  int widthBytes, int start, int count, const int16_t *weights)
+{
+    const __m256i rounding = _mm256_set1_epi32(kRounding);
+    const __m128i zero = _mm_setzero_si128();
+    int b = 0;
+    for (; b + 16 <= widthBytes; b += 16) {
+        __m256i acc0 = rounding;
+        __m256i acc1 = rounding;
+        const unsigned char *row = src + static_cast<ptrdiff_t>(start) * stride + b;
+        int k = 0;
+        for (; k + 1 < count; k += 2, row += 2 * stride) {
+            __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row));
+            __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + stride));
+            __m256i w = _mm256_set1_epi32(weightPair(weights[k], weights[k + 1]));
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(r0, r1)), w));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm_unpackhi_epi8(r0, r1)), w));
+        }
+        if (k < count) {
+            __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row));
+            __m256i w = _mm256_set1_epi32(weightPair(weights[k], 0));
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(r0, zero)), w));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm_unpackhi_epi8(r0, zero)), w));
+        }
+        acc0 = _mm256_srai_epi32(acc0, kWeightBits);
+        acc1 = _mm256_srai_epi32(acc1, kWeightBits);
+        // packs 按 128 位通道交错，重排 64 位块恢复字节顺序
+        __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(acc0, acc1), 0xD8);
+        __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + b), packed);
+    }
+    b = verticalBlocksSse41(src, stride, dst, b, widthBytes, start, count, weights);
+    verticalScalarRange(src, stride, dst, b, widthBytes, start, count, weights);
+}
+
+bool cpuHasSse41()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#else
+    return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+bool cpuHasAvx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // RESAMPLER_X86
+
+#ifdef RESAMPLER_NEON
+
+// ---- NEON ----
+
+void horizontalNeon(const unsigned char *src, unsigned char *dst, int outWidth, const Contributions &c)
+{
+    for (int x = 0; x < outWidth; ++x) {
+        const int16_t *w = &c.weights[static_cast<size_t>(x) * c.taps];
+        const unsigned char *p = src + static_cast<ptrdiff_t>(c.start[x]) * 4;
+        const int count = c.count[x];
+
+        int32x4_t acc = vdupq_n_s32(kRounding);
+        int k = 0;
+        for (; k + 1 < count; k += 2) {
+            int16x8_t pixels = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p + k * 4)));
+            acc = vmlal_n_s16(acc, vget_low_s16(pixels), w[k]);
+            acc = vmlal_n_s16(acc, vget_high_s16(pixels), w[k + 1]);
+        }
+        if (k < count) {
+            uint32_t pixel;
+            std::memcpy(&pixel, p + k * 4, 4);
+            int16x8_t pixels = vreinterpretq_s16_u16(vmovl_u8(vcreate_u8(pixel)));
+            acc = vmlal_n_s16(acc, vget_low_s16(pixels), w[k]);
+        }
+
+        uint16x4_t words = vqmovun_s32(vshrq_n_s32(acc, kWeightBits));
+        uint8x8_t bytes = vqmovn_u16(vcombine_u16(words, words));
+        vst1_lane_u32(reinterpret_cast<uint32_t *>(dst + x * 4), vreinterpret_u32_u8(bytes), 0);
+    }
+}
+
+void verticalNeon(const unsigned char *src, ptrdiff_t stride, unsigned char *dst,
+                  int widthBytes, int start, int count, const int16_t *weights)
+{
+    int b = 0;
+    for (; b + 8 <= widthBytes; b += 8) {
+        int32x4_t accLow = vdupq_n_s32(kRounding);
+        int32x4_t accHigh = vdupq_n_s32(kRounding);
+        const unsigned char *row = src + static_cast<ptrdiff_t>(start) * stride + b;
+        for (int k = 0; k < count; ++k, row += stride) {
+            int16x8_t pixels = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(row)));
+            accLow = vmlal_n_s16(accLow, vget_low_s16(pixels), weights[k]);
+            accHigh = vmlal_n_s16(accHigh, vget_high_s16(pixels), weights[k]);
+        }
+        uint16x8_t words = vcombine_u16(vqmovun_s32(vshrq_n_s32(accLow, kWeightBits)),
+                                        vqmovun_s32(vshrq_n_s32(accHigh, kWeightBits)));
+        vst1_u8(dst + b, vqmovn_u16(words));
+    }
+    verticalScalarRange(src, stride, dst, b, widthBytes, start, count, weights);
+}
+
+#endif // RESAMPLER_NEON
+
+} // namespace
+
+namespace {
+
+struct KernelSet {
+    HorizontalFn horizontal;
+    VerticalFn vertical;
+};
+
+QAtomicInt kernelOverride(ImageResampler::AutoKernel);
+
+ImageResampler::Kernel detectBestKernel()
+{
+#ifdef RESAMPLER_X86
+    if (cpuHasAvx2()) {
+        return ImageResampler::Avx2Kernel;
+    }
+    if (cpuHasSse41()) {
+        return ImageResampler::Sse41Kernel;
+    }
+#endif
+#ifdef RESAMPLER_NEON
+    return ImageResampler::NeonKernel;
+#endif
+    return ImageResampler::ScalarKernel;
+}
+
+KernelSet kernelSet(ImageResampler::Kernel kernel)
+{
+    switch (kernel) {
+#ifdef RESAMPLER_X86
+    case ImageResampler::Avx2Kernel:
+        return {horizontalAvx2, verticalAvx2};
+    case ImageResampler::Sse41Kernel:
+        return {horizontalSse41, verticalSse41};
+#endif
+#ifdef RESAMPLER_NEON
+    case ImageResampler::NeonKernel:
+        return {horizontalNeon, verticalNeon};
+#endif
+    default:
+        return {horizontalScalar, verticalScalar};
+    }
+}
+
+// 每种像素格式在卷积之后的收尾处理
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+const int kAlphaByte = 3;
+#else
+const int kAlphaByte = 0;
+#endif
+
+template <QImage::Format F>
+struct PixelTraits;
+
+// RGB32：alpha 恒为 0xff，权重总和精确为 1，卷积后仍为 0xff，无需处理
+template <>
+struct PixelTraits<QImage::Format_RGB32> {
+    static void finishRow(unsigned char *, int, bool) {}
+};
+
+// 预乘 ARGB32：Lanczos 的负瓣可能让颜色分量超过 alpha，需要截断
+template <>
+struct PixelTraits<QImage::Format_ARGB32_Premultiplied> {
+    static void finishRow(unsigned char *row, int width, bool ringing)
+    {
+        if (!ringing) {
+            return;
+        }
+        for (int x = 0; x < width; ++x, row += 4) {
+            const unsigned char alpha = row[kAlphaByte];
+            for (int channel = 0; channel < 4; ++channel) {
+                row[channel] = std::min(row[channel], alpha);
+            }
+        }
+    }
+};
+
+// 按行带并行，工作量较小时直接在当前线程执行
+const qint64 kParallelWork = 1024 * 1024;
+
+template <typename Fn>
+void forEachBand(int rows, qint64 work, Fn fn)
+{
+    const int threads = QThread::idealThreadCount();
+    if (work < kParallelWork || threads <= 1 || rows < 32) {
+        fn(0, rows);
+        return;
+    }
+
+    const int bandCount = std::min(threads * 2, rows / 16);
+    QVector<QPair<int, int>> bands;
+    for (int i = 0; i < bandCount; ++i) {
+        bands.append(qMakePair(rows * i / bandCount, rows * (i + 1) / bandCount));
+    }
+    QtConcurrent::blockingMap(bands, [&fn](const QPair<int, int> &band) {
+        fn(band.first, band.second);
+    });
+}
+
+template <QImage::Format F>
+QImage resampleImpl(const QImage &source, const QSize &size, ImageResampler::Filter filter,
+                    const KernelSet &kernels)
+{
+    const bool area = (filter == ImageResampler::Area);
+    const int inWidth = source.width();
+    const int inHeight = source.height();
+    const int outWidth = size.width();
+    const int outHeight = size.height();
+
+    // 水平方向：inWidth x inHeight -> outWidth x inHeight
+    QImage horizontal;
+    if (outWidth == inWidth) {
+        horizontal = source;
+    } else {
+        horizontal = PixelBufferPool::shared().createImage(outWidth, inHeight, F);
+        if (horizontal.isNull()) {
+            return QImage();
+        }
+        // 并行前取出数据指针，避免多个线程同时调用会 detach 的 scanLine()
+        const Contributions contributions = computeContributions(inWidth, outWidth, area);
+        const unsigned char *sourceBits = source.constBits();
+        const ptrdiff_t sourceStride = source.bytesPerLine();
+        unsigned char *targetBits = horizontal.bits();
+        const ptrdiff_t targetStride = horizontal.bytesPerLine();
+        const qint64 work = static_cast<qint64>(outWidth) * inHeight * contributions.taps;
+        forEachBand(inHeight, work, [&](int from, int to) {
+            for (int y = from; y < to; ++y) {
+                kernels.horizontal(sourceBits + y * sourceStride, targetBits + y * targetStride,
+                                   outWidth, contributions);
+            }
+        });
+    }
+
+    // 只缩放宽度
+    if (outHeight == inHeight) {
+        if (!area) {
+            for (int y = 0; y < outHeight; ++y) {
+                PixelTraits<F>::finishRow(horizontal.scanLine(y), outWidth, true);
+            }
+        }
+        return horizontal;
+    }
+
+    // 垂直方向：outWidth x inHeight -> outWidth x outHeight
+    QImage result = PixelBufferPool::shared().createImage(outWidth, outHeight, F);
+    if (result.isNull()) {
+        return QImage();
+    }
+    const Contributions contributions = computeContributions(inHeight, outHeight, area);
+    const unsigned char *base = horizontal.constBits();
+    const ptrdiff_t stride = horizontal.bytesPerLine();
+    unsigned char *resultBits = result.bits();
+    const ptrdiff_t resultStride = result.bytesPerLine();
+    const qint64 work = static_cast<qint64>(outWidth) * outHeight * contributions.taps;
+    forEachBand(outHeight, work, [&](int from, int to) {
+        for (int y = from; y < to; ++y) {
+            unsigned char *row = resultBits + y * resultStride;
+            kernels.vertical(base, stride, row, outWidth * 4, contributions.start[y],
+                             contributions.count[y],
+                             &contributions.weights[static_cast<size_t>(y) * contributions.taps]);
+            PixelTraits<F>::finishRow(row, outWidth, !area);
+        }
+    });
+    return result;
+}
+
+} // namespace
+
+QImage ImageResampler::scaled(const QImage &image, const QSize &size, Filter filter)
+{
+    if (image.isNull() || size.isEmpty()) {
+        return QImage();
+    }
+    if (image.size() == size) {
+        return image;
+    }
+
+    const KernelSet kernels = kernelSet(activeKernel());
+
+    switch (image.format()) {
+    case QImage::Format_RGB32:
+        return resampleImpl<QImage::Format_RGB32>(image, size, filter, kernels);
+    case QImage::Format_ARGB32_Premultiplied:
+        return resampleImpl<QImage::Format_ARGB32_Premultiplied>(image, size, filter, kernels);
+    case QImage::Format_ARGB32: {
+        // 在预乘空间滤波，避免透明像素的颜色渗到边缘
+        QImage premultiplied = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        return resampleImpl<QImage::Format_ARGB32_Premultiplied>(premultiplied, size, filter, kernels)
+            .convertToFormat(QImage::Format_ARGB32);
+    }
+    default:
+        if (image.hasAlphaChannel()) {
+            return resampleImpl<QImage::Format_ARGB32_Premultiplied>(
+                image.convertToFormat(QImage::Format_ARGB32_Premultiplied), size, filter, kernels);
+        }
+        return resampleImpl<QImage::Format_RGB32>(image.convertToFormat(QImage::Format_RGB32),
+                                                  size, filter, kernels);
+    }
+}
+
+QImage ImageResampler::scaled(const QImage &image, const QSize &size, Qt::AspectRatioMode mode,
+                              Filter filter)
+{
+    if (image.isNull()) {
+        return QImage();
+    }
+    QSize target = image.size().scaled(size, mode);
+    return scaled(image, target.expandedTo(QSize(1, 1)), filter);
+}
+
+ImageResampler::Filter ImageResampler::defaultFilter(const QSize &from, const QSize &to)
+{
+    return (to.width() < from.width() || to.height() < from.height()) ? Area : Lanczos3;
+}
+
+bool ImageResampler::isKernelSupported(Kernel kernel)
+{
+    switch (kernel) {
+    case AutoKernel:
+    case ScalarKernel:
+        return true;
+#ifdef RESAMPLER_X86
+    case Sse41Kernel:
+        return cpuHasSse41();
+    case Avx2Kernel:
+        return cpuHasAvx2();
+#endif
+#ifdef RESAMPLER_NEON
+    case NeonKernel:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+bool ImageResampler::setKernel(Kernel kernel)
+{
+    if (!isKernelSupported(kernel)) {
+        return false;
+    }
+    kernelOverride.storeRelaxed(kernel);
+    return true;
+}
+
+ImageResampler::Kernel ImageResampler::activeKernel()
+{
+    static const Kernel best = detectBestKernel();
+    const Kernel forced = static_cast<Kernel>(kernelOverride.loadRelaxed());
+    return forced == AutoKernel ? best : forced;
+}
+
+QString ImageResampler::kernelName(Kernel kernel)
+{
+    switch (kernel) {
+    case ScalarKernel:
+        return QStringLiteral("scalar");
+    case Sse41Kernel:
+        return QStringLiteral("SSE4.1");
+    case Avx2Kernel:
+        return QStringLiteral("AVX2");
+    case NeonKernel:
+        return QStringLiteral("NEON");
+    default:
+        return QStringLiteral("auto");
+    }
+}
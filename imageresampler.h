@@ -0,0 +1,44 @@
+// imageresampler.h
+#ifndef IMAGERESAMPLER_H
+#define IMAGERESAMPLER_H
+
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+// 可分离的图像重采样（先水平后垂直），代替 QImage::scaled(..., Qt::SmoothTransformation)
+// 面积平均滤波在大比例缩小时不会产生混叠，Lanczos3 用于放大和需要锐度的场合。
+// 卷积核按 CPU 在运行时选择 AVX2 / SSE4.1 / NEON / 标量实现，权重为 14 位定点数；
+// 输出较大时按行带分给 QtConcurrent 线程池并行处理。
+class ImageResampler
+{
+public:
+    enum Filter {
+        Area,       // 面积平均（盒式滤波，按覆盖比例加权）
+        Lanczos3
+    };
+
+    enum Kernel {
+        AutoKernel,
+        ScalarKernel,
+        Sse41Kernel,
+        Avx2Kernel,
+        NeonKernel
+    };
+
+    // 支持 RGB32 / ARGB32 / ARGB32_Premultiplied，其他格式先转换为其中之一
+    static QImage scaled(const QImage &image, const QSize &size, Filter filter = Area);
+    static QImage scaled(const QImage &image, const QSize &size, Qt::AspectRatioMode mode,
+                         Filter filter = Area);
+
+    // 缩小用面积平均，放大用 Lanczos3
+    static Filter defaultFilter(const QSize &from, const QSize &to);
+
+    static bool isKernelSupported(Kernel kernel);
+    // 强制使用指定实现（基准测试用），AutoKernel 恢复自动选择；不支持时返回 false
+    static bool setKernel(Kernel kernel);
+    static Kernel activeKernel();
+    static QString kernelName(Kernel kernel);
+};
+
+#endif // IMAGERESAMPLER_H
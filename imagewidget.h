@@ -11,11 +11,21 @@
 #include <QMap>
 #include <QtConcurrent>
 #include <QMutex>
+#include <QThreadPool>
+#include <QAtomicInt>
 
 #include "configmanager.h"  // 添加配置管理器头文件
 #include "canvascontrolpanel.h"  // 添加控制面板头文件
 
 #include "archivehandler.h"
+#include "tiledimagerenderer.h"
+#include "regionimagesource.h"
+#include "imageorientation.h"
+#include "animationplayer.h"
+#include "decodedimagecache.h"
+#include "imagemetadatatable.h"
+#include "folderwatcher.h"
+#include "imagelistsorter.h"
 
 class ImageWidget : public QWidget
 {
@@ -74,6 +84,9 @@ protected:
 private slots:
     void onThumbnailClicked(int index);
     void onEnsureRectVisible(const QRect &rect);
+    void onSmoothRenderIdle();
+    void onSmoothTilesReady();
+    void onAnimationFrame(const QImage &frame);
 
 private:
     void navigateThumbnails(int key);
@@ -88,6 +101,18 @@ private:
 
     QPixmap pixmap;
     double scaleFactor;
+
+    // 分块渲染器，rendererSourceKey 为当前载入渲染器的 pixmap.cacheKey()；旋转/镜像不改变 pixmap
+    TiledImageRenderer imageRenderer;
+    qint64 rendererSourceKey;
+
+    // 拖动/滚轮缩放期间使用快速渲染，重绘按显示帧合并；停止操作后在后台补齐平滑瓦片
+    bool interactiveRendering;
+    QTimer *renderFrameTimer;
+    QTimer *smoothRenderTimer;
+    void scheduleInteractiveFrame();
+    QRectF displayedImageRect() const;
+    QTransform imageToWidgetTransform() const;  // 未旋转的缩放图坐标 -> 控件坐标
     QPointF panOffset;
     bool isDraggingWindow;
     QPoint dragStartPosition;
@@ -102,8 +127,6 @@ private:
     int slideshowInterval;
     QTimer *slideshowTimer;
 
-    QMap<QString, QPixmap> imageCache;
-
     ViewMode currentViewMode;
     QSize thumbnailSize;
     int thumbnailSpacing;
@@ -120,11 +143,6 @@ private:
     // 配置管理器
     ConfigManager *configManager;
 
-    //多线程互斥体
-private:
-    QMutex cacheMutex; // 用于保护 imageCache 的访问
-
-    //
 public:
     void setCurrentDir(const QDir &dir);
 public:
@@ -169,6 +187,7 @@ public slots:
     void permanentlyDeleteSelectedThumbnail(); // 需要实现这个方法的缩略图版本
 private:
     bool moveFileToRecycleBin(const QString &filePath);
+    void deleteImageFile(const QString &filePath, int index, bool permanent);
 
 
 private:
@@ -257,24 +276,107 @@ private:
     int rotationAngle;           // 旋转角度 (0, 90, 180, 270)
     bool isHorizontallyFlipped;  // 水平镜像
     bool isVerticallyFlipped;    // 垂直镜像
-    QPixmap originalPixmap;      // 存储原始图片，用于重置变换
+    QPixmap originalPixmap;      // 原始图片，与 pixmap 共享数据（旋转和镜像只在绘制时应用）
+    ImageOrientation currentOrientation() const;
+    QImage orientedImage() const;  // 保存/复制时生成应用了方向的实际图像
+    // 区域模式下 pixmap 只是预览图：按区域解码拼出原分辨率图像，太大或格式不支持时提示并返回空图像
+    QImage fullResolutionImage();
+
+    // 区域解码模式：originalPixmap 只是预览图，原分辨率细节由渲染器按视口解码
+    QSharedPointer<RegionImageSource> regionSource;
+    qint64 regionPixmapKey;      // 预览图的 cacheKey，pixmap 仍是它时才按区域渲染
+    bool isRegionRenderingActive() const;
+    QSize displayImageSize() const;
+
+    // 动画播放：pixmap 保持为第一帧，之后的帧（可能已缩小到显示尺寸）放在 animationFrame 中直接绘制，
+    // 不经过瓦片渲染器；显示尺寸按动画原始尺寸计算
+    AnimationPlayer *animationPlayer;
+    QImage animationFrame;
+    bool isAnimationActive() const;
+
+    // 异步加载：解码在后台线程完成（只用 QImage），界面线程只转换并显示最新请求的结果
+    // knownSize 来自文件头信息表，已知不需要区域解码时跳过区域解码探测
+    static DecodedImage decodeImageFile(const QString &filePath, const QSize &knownSize = QSize());
+    bool showDecodedImage(const DecodedImage &decoded);
+    void requestImageLoad(int index, const QString &imagePath);
+    void onImageDecoded(const DecodedImage &decoded, int request);
+    void cancelPendingImageLoad();
+    int navigationIndex() const;
+    void onImageIndexShown();
+    QAtomicInt loadGeneration;   // 每次请求（含同步加载）递增
+    int pendingImageIndex;       // 正在后台解码的索引，没有时为 -1
+    QThreadPool imageLoadPool;   // 单线程，同一时间只解码一张
+
+    // 导航预取：在当前图片前后的窗口内后台解码，结果放入 DecodedImageCache 的原图命名空间，
+    // loadImageByIndex 先查缓存，命中时不再等待解码
+    int prefetchAhead;           // 沿最近浏览方向预取的张数
+    int prefetchBehind;          // 反方向预取的张数
+    int readAheadWindow;         // 只读入压缩数据的窗口（FileReadAhead），远大于解码窗口
+    int navigationDirection;     // 最近的浏览方向：1 向后，-1 向前
+    QAtomicInt prefetchGeneration;
+    QThreadPool prefetchPool;
+    void updateNavigationDirection(int index);
+    QVector<int> prefetchIndices(int ahead, int behind) const;
+    void schedulePrefetch();
+    void setPrefetchWindow(int ahead, int behind, int readAhead);
+
+    // 文件头信息：打开文件夹后在后台并行读取全部文件头，完成后交给缩略图占位符和解码路径使用
+    QSharedPointer<const ImageMetadataTable> metadataTable;
+    QAtomicInt metadataGeneration;
+    QThreadPool metadataPool;
+    void startMetadataProbe();
+    void onMetadataReady(const QSharedPointer<const ImageMetadataTable> &table, int generation);
+
+    // 文件夹枚举：后台分批送回。打开新文件夹时边枚举边合并进有序的 imageList，
+    // 刷新同一文件夹时先收集完整列表，有变化才整体替换
+    QAtomicInt scanGeneration;
+    QThreadPool scanPool;
+    QString listedDirPath;        // imageList 对应的文件夹
+    bool listedRecursive;         // imageList 是否包含子文件夹（文件名为相对路径）
+    bool scanStreaming;
+    QStringList scanCollected;
+    void onDirectoryChunk(const QStringList &fileNames, int generation);
+    void onDirectoryScanFinished(int generation, bool complete, const QStringList &directories);
+    void mergeIntoImageList(QStringList fileNames);
+    void removeFromImageList(const QStringList &fileNames);
+
+    // 递归浏览：把 currentDir 下所有子文件夹中的图片平铺在一个列表中
+    bool recursiveListing;
+    int recursiveMaxDepth;
+    void setRecursiveListing(bool enabled);
+    // filePath 在当前列表中的名称（递归浏览时为相对路径），不属于当前文件夹时为空
+    QString listEntryName(const QString &filePath) const;
+
+    // 排序方式（自然排序 / 修改时间 / 大小），排序键按文件缓存，切换方式时只重排
+    ImageListSorter imageSorter;
+    void setSortMode(ImageListSorter::Mode mode);
+
+    // 文件夹监视：新增、删除和改写的文件增量更新列表和缓存，不重建缩略图
+    FolderWatcher *folderWatcher;
+    void onFolderFilesChanged(const QStringList &written, const QStringList &removed);
+    void onFolderRescanNeeded();
 
     // 压缩包处理
     // 压缩包处理
     ArchiveHandler archiveHandler;
     bool isArchiveMode;
     QString currentArchivePath;
-    QMap<QString, QPixmap> archiveImageCache;  // 压缩包图片缓存
+    int archiveLookahead;         // 固实压缩包顺序读取时顺便保存的后续条目数
 
     // 压缩包相关方法
     bool openArchive(const QString &filePath);
     void closeArchive();
     void loadArchiveImageList();
     bool loadImageFromArchive(const QString &filePath);
+    QStringList upcomingArchiveEntries(int index) const;
+    void setArchiveReadAhead(int lookahead, int spillCacheMB);
 
 public:
     QPixmap getArchiveThumbnail(const QString &archivePath);
 
+    // 合并预取一批压缩包条目（路径格式：压缩包路径|内部文件路径），可在工作线程调用
+    void prefetchArchiveEntries(const QStringList &archivePaths);
+
 public slots:
     // 返回上级目录（退出压缩包模式）
     void exitArchiveMode();
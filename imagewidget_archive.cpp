@@ -8,6 +8,7 @@
 
 #include <QImageReader>
 #include <QBuffer>
+#include "imageresampler.h"
 
 bool ImageWidget::openArchive(const QString &filePath)
 {
@@ -24,7 +25,6 @@ bool ImageWidget::openArchive(const QString &filePath)
 
     isArchiveMode = true;
     currentArchivePath = filePath;
-    archiveImageCache.clear(); // 清空缓存
 
     // 加载压缩包中的图片列表
     loadArchiveImageList();
@@ -53,6 +53,12 @@ void ImageWidget::exitArchiveMode()
 
     // 重新加载图片列表
     thumbnailWidget->setImageList(imageList, currentDir);
+    startMetadataProbe();
+
+    // 进入压缩包时文件夹还没有枚举完，重新枚举
+    if (listedDirPath != currentDir.absolutePath()) {
+        loadImageList();
+    }
 
     // 恢复之前的视图模式
     if (previousViewMode == ThumbnailView) {
@@ -85,8 +91,11 @@ void ImageWidget::loadArchiveImageList()
 
     qDebug() << "=== 加载压缩包图片列表 ===";
 
+    // 压缩包条目没有独立的修改时间和大小，这两种方式下按自然排序
     QStringList archiveImageList = archiveHandler.getImageFiles();
-    archiveImageList.sort();
+    ImageListSorter archiveSorter(imageSorter.mode() == ImageListSorter::ByName ? ImageListSorter::ByName
+                                                                                 : ImageListSorter::ByNaturalName);
+    archiveSorter.sort(archiveImageList);
 
     qDebug() << "排序后的图片列表:";
     for (int i = 0; i < archiveImageList.size(); ++i) {
@@ -128,6 +137,9 @@ bool ImageWidget::loadImageFromArchive(const QString &filePath)
     // 保存原始图片并重置变换状态
     originalPixmap = loadedPixmap;
     pixmap = loadedPixmap;
+    regionSource.reset();
+    animationPlayer->stop();
+    animationFrame = QImage();
 
     // 重置变换状态
     rotationAngle = 0;
@@ -163,12 +175,11 @@ QPixmap ImageWidget::getArchiveThumbnail(const QString &archivePath)
     qDebug() << "=== getArchiveThumbnail 详细调试 ===";
     qDebug() << "输入路径:" << archivePath;
 
-    // 使用完整路径作为缓存键
-    if (archiveImageCache.contains(archivePath)) {
-        qDebug() << "从缓存获取缩略图:" << archivePath;
-        QPixmap cached = archiveImageCache.value(archivePath);
-        qDebug() << "缓存图片是否为空:" << cached.isNull() << "尺寸:" << cached.size();
-        return cached;
+    // 使用完整路径作为缓存键（缩略图命名空间，与原图分开计费）
+    QImage cached = DecodedImageCache::shared().lookupImage(DecodedImageCache::Thumbnails, archivePath);
+    if (!cached.isNull()) {
+        qDebug() << "从缓存获取缩略图:" << archivePath << "尺寸:" << cached.size();
+        return QPixmap::fromImage(cached);
     }
 
     // 解析路径格式：压缩包路径|内部文件路径
@@ -217,11 +228,8 @@ QPixmap ImageWidget::getArchiveThumbnail(const QString &archivePath)
         painter.drawText(errorImage.rect(), Qt::AlignCenter, "提取失败\n数据为空");
         painter.end();
 
-        QPixmap errorThumb = QPixmap::fromImage(errorImage);
-
-        QMutexLocker locker(&cacheMutex);
-        archiveImageCache.insert(archivePath, errorThumb);
-        return errorThumb;
+        DecodedImageCache::shared().insertImage(DecodedImageCache::Thumbnails, archivePath, errorImage);
+        return QPixmap::fromImage(errorImage);
     }
 
     // 检查数据前几个字节（图片文件签名）
@@ -237,14 +245,13 @@ QPixmap ImageWidget::getArchiveThumbnail(const QString &archivePath)
         qDebug() << "  - 深度:" << image.depth();
 
         // 缩放到缩略图大小
-        QImage scaledImage = image.scaled(thumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        QImage scaledImage = ImageResampler::scaled(image, thumbnailSize, Qt::KeepAspectRatio);
         QPixmap thumbnail = QPixmap::fromImage(scaledImage);
 
         qDebug() << "  - 缩略图尺寸:" << thumbnail.size();
 
         // 缓存并返回
-        QMutexLocker locker(&cacheMutex);
-        archiveImageCache.insert(archivePath, thumbnail);
+        DecodedImageCache::shared().insertImage(DecodedImageCache::Thumbnails, archivePath, scaledImage);
         return thumbnail;
     } else {
         qDebug() << "❌ QImage加载失败";
@@ -256,12 +263,11 @@ QPixmap ImageWidget::getArchiveThumbnail(const QString &archivePath)
         qDebug() << "✅ QPixmap加载成功:";
         qDebug() << "  - 原始尺寸:" << pixmap.size();
 
-        QPixmap thumbnail = pixmap.scaled(thumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        qDebug() << "  - 缩略图尺寸:" << thumbnail.size();
+        QImage scaledImage = ImageResampler::scaled(pixmap.toImage(), thumbnailSize, Qt::KeepAspectRatio);
+        qDebug() << "  - 缩略图尺寸:" << scaledImage.size();
 
-        QMutexLocker locker(&cacheMutex);
-        archiveImageCache.insert(archivePath, thumbnail);
-        return thumbnail;
+        DecodedImageCache::shared().insertImage(DecodedImageCache::Thumbnails, archivePath, scaledImage);
+        return QPixmap::fromImage(scaledImage);
     } else {
         qDebug() << "❌ QPixmap加载也失败";
     }
@@ -281,11 +287,46 @@ QPixmap ImageWidget::getArchiveThumbnail(const QString &archivePath)
                          .arg(imageData.size()));
     painter.end();
 
-    QPixmap failedThumb = QPixmap::fromImage(failedImage);
+    DecodedImageCache::shared().insertImage(DecodedImageCache::Thumbnails, archivePath, failedImage);
+    return QPixmap::fromImage(failedImage);
+}
 
-    QMutexLocker locker(&cacheMutex);
-    archiveImageCache.insert(archivePath, failedThumb);
-    return failedThumb;
+// 缩略图/幻灯预取：一批条目合并为一次顺序读取，结果放入暂存缓存
+void ImageWidget::prefetchArchiveEntries(const QStringList &archivePaths)
+{
+    QStringList entries;
+    for (const QString &path : archivePaths) {
+        int separator = path.indexOf('|');
+        entries.append(separator >= 0 ? path.mid(separator + 1) : path);
+    }
+
+    if (!entries.isEmpty()) {
+        archiveHandler.prefetchFiles(entries);
+    }
+}
+
+// 指定图片之后即将浏览的几个条目：固实压缩包回头重读代价很高，经过时多保存几张；
+// 非固实压缩包可以随时定位，和普通文件一样只预取 prefetchAhead 张
+QStringList ImageWidget::upcomingArchiveEntries(int index) const
+{
+    QStringList upcoming;
+    if (imageList.isEmpty() || index < 0) {
+        return upcoming;
+    }
+
+    const int count = archiveHandler.isSolid() ? archiveLookahead : prefetchAhead;
+    for (int i = 1; i <= count && i < imageList.size(); ++i) {
+        upcoming.append(imageList.at((index + i) % imageList.size()));
+    }
+    return upcoming;
+}
+
+void ImageWidget::setArchiveReadAhead(int lookahead, int spillCacheMB)
+{
+    archiveLookahead = qBound(0, lookahead, 64);
+    archiveHandler.setSpillCacheLimit(qBound(16, spillCacheMB, 4096));
+    qDebug() << "压缩包: 顺序读取时保存后续" << archiveLookahead << "张，暂存缓存上限"
+             << qBound(16, spillCacheMB, 4096) << "MB";
 }
 
 // 创建默认的压缩包缩略图
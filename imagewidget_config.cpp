@@ -1,5 +1,6 @@
 // imagewidget_config.cpp
 #include "imagewidget.h"
+#include "imagecodecs.h"
 #include <QCloseEvent>
 
 void ImageWidget::closeEvent(QCloseEvent *event)
@@ -28,12 +29,30 @@ void ImageWidget::saveConfiguration()
     config.transparentBackground = this->testAttribute(Qt::WA_TranslucentBackground);
     config.titleBarVisible = !(this->windowFlags() & Qt::FramelessWindowHint);
     config.lastOpenPath = currentConfig.lastOpenPath;
+    config.prefetchAhead = prefetchAhead;
+    config.prefetchBehind = prefetchBehind;
+    config.readAheadWindow = readAheadWindow;
+    config.directCodecs = ImageCodecs::directBackendsEnabled();
+    config.archiveLookahead = archiveLookahead;
+    config.archiveSpillCacheMB = int(archiveHandler.spillCacheLimit() / (1024 * 1024));
+    config.thumbnailCacheMB = int(DecodedImageCache::shared().budget(DecodedImageCache::Thumbnails) / (1024 * 1024));
+    config.sortMode = ImageListSorter::modeName(imageSorter.mode());
+    config.recursiveListing = recursiveListing;
+    config.recursiveMaxDepth = recursiveMaxDepth;
 
     configManager->saveConfig(config);
 }
 
 void ImageWidget::applyConfiguration(const ConfigManager::Config &config)
 {
+    setPrefetchWindow(config.prefetchAhead, config.prefetchBehind, config.readAheadWindow);
+    ImageCodecs::setDirectBackendsEnabled(config.directCodecs);
+    setArchiveReadAhead(config.archiveLookahead, config.archiveSpillCacheMB);
+    thumbnailWidget->setCacheSize(qBound(16, config.thumbnailCacheMB, 4096));
+    setSortMode(ImageListSorter::modeFromName(config.sortMode));
+    recursiveMaxDepth = qBound(0, config.recursiveMaxDepth, 64);
+    setRecursiveListing(config.recursiveListing);
+
     // 保存当前窗口状态
     bool wasMaximized = isMaximized();
     QRect normalGeometry;
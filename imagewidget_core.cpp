@@ -1,5 +1,6 @@
 // imagewidget_core.cpp
 #include "imagewidget.h"
+#include "directoryscanner.h"
 #include <QVBoxLayout>
 #include <QApplication>
 #include <QDebug>
@@ -10,6 +11,8 @@
 
 ImageWidget::ImageWidget(QWidget *parent) : QWidget(parent),
     scaleFactor(1.0),
+    rendererSourceKey(0),
+    interactiveRendering(false),
     panOffset(0, 0),
     isDraggingWindow(false),
     isPanningImage(false),
@@ -35,7 +38,19 @@ ImageWidget::ImageWidget(QWidget *parent) : QWidget(parent),
     rotationAngle(0),
     isHorizontallyFlipped(false),
     isVerticallyFlipped(false),
-    isArchiveMode(false)
+    regionPixmapKey(0),
+    animationPlayer(nullptr),
+    pendingImageIndex(-1),
+    listedRecursive(false),
+    scanStreaming(false),
+    recursiveListing(false),
+    recursiveMaxDepth(DirectoryScanner::kDefaultMaxDepth),
+    prefetchAhead(3),
+    prefetchBehind(1),
+    readAheadWindow(20),
+    navigationDirection(1),
+    isArchiveMode(false),
+    archiveLookahead(8)
 {
 
     // 创建缩略图部件 - 使用统一的构造函数
@@ -90,6 +105,30 @@ ImageWidget::ImageWidget(QWidget *parent) : QWidget(parent),
     slideshowTimer = new QTimer(this);
     connect(slideshowTimer, &QTimer::timeout, this, &ImageWidget::slideshowNext);
 
+    // 交互渲染定时器：帧合并 + 空闲后平滑重绘
+    renderFrameTimer = new QTimer(this);
+    renderFrameTimer->setSingleShot(true);
+    connect(renderFrameTimer, &QTimer::timeout, this, QOverload<>::of(&ImageWidget::update));
+
+    smoothRenderTimer = new QTimer(this);
+    smoothRenderTimer->setSingleShot(true);
+    smoothRenderTimer->setInterval(150);
+    connect(smoothRenderTimer, &QTimer::timeout, this, &ImageWidget::onSmoothRenderIdle);
+    connect(&imageRenderer, &TiledImageRenderer::tilesReady, this, &ImageWidget::onSmoothTilesReady);
+
+    // 动画帧由后台解码，按帧延迟送到界面线程
+    animationPlayer = new AnimationPlayer(this);
+    connect(animationPlayer, &AnimationPlayer::frameChanged, this, &ImageWidget::onAnimationFrame);
+
+    folderWatcher = new FolderWatcher(this);
+    connect(folderWatcher, &FolderWatcher::filesChanged, this, &ImageWidget::onFolderFilesChanged);
+    connect(folderWatcher, &FolderWatcher::rescanNeeded, this, &ImageWidget::onFolderRescanNeeded);
+
+    imageLoadPool.setMaxThreadCount(1);
+    scanPool.setMaxThreadCount(1);
+    metadataPool.setMaxThreadCount(4);   // 只读文件头，主要等待磁盘
+    setPrefetchWindow(prefetchAhead, prefetchBehind, readAheadWindow);
+
     setMouseTracking(true);
 
     // 初始重绘以确保无残影
@@ -98,6 +137,20 @@ ImageWidget::ImageWidget(QWidget *parent) : QWidget(parent),
 
 ImageWidget::~ImageWidget()
 {
+    // 排队中的加载任务不再执行，等待正在解码的一张结束
+    cancelPendingImageLoad();
+    imageLoadPool.clear();
+    imageLoadPool.waitForDone();
+    prefetchGeneration.fetchAndAddOrdered(1);
+    prefetchPool.clear();
+    prefetchPool.waitForDone();
+    metadataGeneration.fetchAndAddOrdered(1);
+    metadataPool.clear();
+    metadataPool.waitForDone();
+    scanGeneration.fetchAndAddOrdered(1);
+    scanPool.clear();
+    scanPool.waitForDone();
+
     // 确保销毁控制面板
     destroyControlPanel();
 
@@ -101,7 +101,12 @@ void ImageWidget::saveImage()
         QStandardPaths::writableLocation(QStandardPaths::PicturesLocation),
         "Images (*.png *.jpg *.bmp *.jpeg *.webp)");
     if (!fileName.isEmpty()) {
-        if (pixmap.save(fileName)) {
+        // 旋转和镜像只在显示时应用，保存前生成实际图像（区域模式下按原分辨率重新解码）
+        const QImage image = fullResolutionImage();
+        if (image.isNull()) {
+            return;
+        }
+        if (image.save(fileName)) {
             // 保存成功
         } else {
             // 保存失败
@@ -112,8 +117,12 @@ void ImageWidget::saveImage()
 void ImageWidget::copyImageToClipboard()
 {
     if (!pixmap.isNull()) {
+        const QImage image = fullResolutionImage();
+        if (image.isNull()) {
+            return;
+        }
         QClipboard *clipboard = QApplication::clipboard();
-        clipboard->setPixmap(pixmap);
+        clipboard->setImage(image);
     }
 }
 
@@ -126,6 +135,14 @@ void ImageWidget::pasteImageFromClipboard()
         QImage image = clipboard->image();
         if (!image.isNull()) {
             pixmap = QPixmap::fromImage(image);
+            originalPixmap = pixmap;
+            regionSource.reset();
+            animationPlayer->stop();
+            animationFrame = QImage();
+            cancelPendingImageLoad();
+            rotationAngle = 0;
+            isHorizontallyFlipped = false;
+            isVerticallyFlipped = false;
             scaleFactor = 1.0;
             panOffset = QPointF(0, 0);
             currentImagePath.clear();
@@ -154,13 +171,12 @@ QImage ImageWidget::loadImageSafely(const QString &filePath)
 {
     QMutexLocker locker(&imageLoadMutex);
 
-    QFileInfo fileInfo(filePath);
-    qint64 fileSize = fileInfo.size();
-
-    // 检查文件大小，避免加载过大的文件
-    if (fileSize > 500 * 1024 * 1024) { // 500MB
-        qWarning() << "File too large:" << filePath << "Size:" << fileSize / (1024 * 1024) << "MB";
-        return QImage();
+    // 超大图片返回区域解码的预览图，不再整张解码
+    QSharedPointer<RegionImageSource> region = RegionImageSource::open(filePath);
+    if (region) {
+        qDebug() << "Large image detected:" << region->size() << "using overview"
+                 << region->overviewSize() << "via" << region->backendName();
+        return region->overview();
     }
 
     QImageReader reader(filePath);
@@ -168,15 +184,6 @@ QImage ImageWidget::loadImageSafely(const QString &filePath)
     // 设置图像读取选项
     reader.setAutoTransform(true);
 
-    // 检查图像尺寸，对于超大图像进行缩放
-    QSize imageSize = reader.size();
-    if (imageSize.isValid() && (imageSize.width() > 8000 || imageSize.height() > 8000)) {
-        qDebug() << "Large image detected:" << imageSize << "scaling down...";
-        // 保持宽高比缩放
-        imageSize.scale(4000, 4000, Qt::KeepAspectRatio);
-        reader.setScaledSize(imageSize);
-    }
-
     // 检查格式支持
     if (!reader.canRead()) {
         qWarning() << "Cannot read image format:" << filePath;
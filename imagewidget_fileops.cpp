@@ -7,6 +7,13 @@
 #include <QDropEvent>
 #include <QMimeData>
 #include <QUrl>
+#include <QPointer>
+#include <QSet>
+#include "filereadahead.h"
+#include "imagecodecs.h"
+#include "pixelbufferpool.h"
+#include "mappedimagefile.h"
+#include "directoryscanner.h"
 #include <platform_compat.h>
 
 #ifdef _WIN32
@@ -30,9 +37,8 @@ bool ImageWidget::loadImage(const QString &filePath, bool fromCache)
     qDebug() << "=== loadImage 开始 ===";
     qDebug() << "文件路径:" << filePath;
 
-    // 设置更高的内存分配限制（512MB）
-    QImageReader::setAllocationLimit(512);
-    qDebug() << "设置内存分配限制为 512MB";
+    // 同步加载优先，尚未完成的异步加载结果作废
+    cancelPendingImageLoad();
 
     // 检查文件是否存在
     QFileInfo fileInfo(filePath);
@@ -60,31 +66,83 @@ bool ImageWidget::loadImage(const QString &filePath, bool fromCache)
     qDebug() << "文件大小:" << fileInfo.size();
     qDebug() << "文件权限:" << fileInfo.permissions();
 
-    if (!fileInfo.exists()) {
-        qDebug() << "错误: 文件不存在";
-        return false;
-    }
-
     // 直接加载，绕过缓存进行测试
-    QPixmap loadedPixmap;
     qDebug() << "开始加载图片...";
+    DecodedImage decoded = decodeImageFile(filePath, metadataTable ? metadataTable->imageSize(filePath) : QSize());
+    if (decoded.image.isNull()) {
+        return false;
+    }
+    return showDecodedImage(decoded);
+}
 
-    if (!loadedPixmap.load(filePath)) {
-        qDebug() << "错误: 直接加载失败";
+// 可以在任意线程调用：只使用 QImage，QPixmap 在界面线程转换
+ImageWidget::DecodedImage ImageWidget::decodeImageFile(const QString &filePath, const QSize &knownSize)
+{
+    DecodedImage decoded;
+    decoded.filePath = filePath;
+
+    // 超大图片只解码预览图，原分辨率细节按视口区域解码；
+    // 文件头信息表已确认尺寸较小时不再打开文件探测
+    QSharedPointer<RegionImageSource> region;
+    if (!knownSize.isValid() ||
+        static_cast<qint64>(knownSize.width()) * knownSize.height() >= RegionImageSource::kRegionModePixels) {
+        region = RegionImageSource::open(filePath);
+    }
+    if (region) {
+        QImage overview = region->overview();
+        if (!overview.isNull()) {
+            decoded.image = overview;
+            decoded.region = region;
+            qDebug() << "区域解码模式，原图尺寸:" << region->size() << "预览尺寸:" << overview.size();
+            return decoded;
+        }
+    }
 
-        // 尝试使用 QImage 加载
-        QImage image;
-        if (image.load(filePath)) {
-            qDebug() << "使用 QImage 加载成功";
-            loadedPixmap = QPixmap::fromImage(image);
-        } else {
-            qDebug() << "错误: QImage 加载也失败";
-            return false;
+    // 未压缩格式直接从文件映射取像素，不经过解码器
+    if (QSharedPointer<MappedImageFile> mapped = MappedImageFile::open(filePath)) {
+        decoded.image = mapped->image();
+        if (!decoded.image.isNull()) {
+            // 映射区的页面第一次访问时才从磁盘读入：在这里（工作线程）转换为显示用的原生格式，
+            // 界面线程的 QPixmap::fromImage 不再逐像素转换，也不会在界面线程等待磁盘
+            const QImage::Format nativeFormat = decoded.image.hasAlphaChannel()
+                                                    ? QImage::Format_ARGB32_Premultiplied
+                                                    : QImage::Format_RGB32;
+            if (decoded.image.format() != nativeFormat) {
+                decoded.image = decoded.image.convertToFormat(nativeFormat);
+            } else if (mapped->isZeroCopy()) {
+                decoded.image = decoded.image.copy();
+            }
+            qDebug() << "加载成功 (内存映射)，图片尺寸:" << decoded.image.size()
+                     << (mapped->isZeroCopy() ? "直接读取映射区" : "逐行转换");
+            return decoded;
         }
+    }
+
+    // 预读层已读入原始数据时直接从内存解码，不再等待磁盘
+    ImageCodecs::Backend backend = ImageCodecs::QtPlugin;
+    const QByteArray bytes = FileReadAhead::shared().data(filePath);
+    if (!bytes.isEmpty()) {
+        decoded.image = ImageCodecs::decode(bytes, QFileInfo(filePath).suffix().toLatin1(), QSize(), &backend);
     } else {
-        qDebug() << "直接加载成功，图片尺寸:" << loadedPixmap.size();
+        decoded.image = ImageCodecs::decodeFile(filePath, QSize(), &backend);
     }
 
+    if (decoded.image.isNull() && !decoded.image.load(filePath)) {
+        qDebug() << "错误: 图片加载失败:" << filePath;
+        return decoded;
+    }
+    qDebug() << "加载成功，图片尺寸:" << decoded.image.size() << "解码器:" << ImageCodecs::backendName(backend);
+
+    decoded.animated = AnimationPlayer::isAnimated(filePath);
+    return decoded;
+}
+
+bool ImageWidget::showDecodedImage(const DecodedImage &decoded)
+{
+    const QString &filePath = decoded.filePath;
+    QFileInfo fileInfo(filePath);
+
+    QPixmap loadedPixmap = QPixmap::fromImage(decoded.image);
     if (loadedPixmap.isNull()) {
         qDebug() << "错误: 加载后的 pixmap 为空";
         return false;
@@ -93,8 +151,17 @@ bool ImageWidget::loadImage(const QString &filePath, bool fromCache)
     // 继续原有逻辑...
     originalPixmap = loadedPixmap;
     pixmap = loadedPixmap;
+    regionSource = decoded.region;
+    regionPixmapKey = decoded.region ? loadedPixmap.cacheKey() : 0;
     qDebug() << "图片设置完成";
 
+    // 多帧动画：第一帧已经显示，后续帧由 AnimationPlayer 在后台解码
+    animationPlayer->stop();
+    animationFrame = QImage();
+    if (decoded.animated) {
+        animationPlayer->start(filePath, size() * devicePixelRatioF());
+    }
+
     // 重置变换状态
     rotationAngle = 0;
     isHorizontallyFlipped = false;
@@ -116,15 +183,16 @@ bool ImageWidget::loadImage(const QString &filePath, bool fromCache)
     currentImagePath = filePath;
     qDebug() << "当前图片路径设置为:" << currentImagePath;
 
-    // 检查目录是否改变
-    bool dirChanged = (currentDir != fileInfo.absoluteDir());
-    if (dirChanged) {
+    // 检查目录是否改变（递归浏览时子文件夹中的图片仍属于当前列表）
+    QString entryName = listEntryName(filePath);
+    if (entryName.isEmpty()) {
         currentDir = fileInfo.absoluteDir();
         loadImageList();
+        entryName = fileInfo.fileName();
     }
 
     // 确保当前图片索引正确设置
-    currentImageIndex = imageList.indexOf(fileInfo.fileName());
+    currentImageIndex = imageList.indexOf(entryName);
     qDebug() << "当前图片索引:" << currentImageIndex;
 
     update();
@@ -134,45 +202,320 @@ bool ImageWidget::loadImage(const QString &filePath, bool fromCache)
     return true;
 }
 
+// 在后台枚举 currentDir，结果分批回到界面线程；大文件夹不阻塞界面，首屏随第一批出现
 void ImageWidget::loadImageList()
 {
-    QStringList newImageList;
-
-    QFileInfoList fileList = currentDir.entryInfoList(QDir::Files);
-    QStringList imageFilters = {"*.png",  "*.jpg", "*.bmp",  "*.jpeg",
-                                "*.webp", "*.gif", "*.tiff", "*.tif"};
-    QStringList archiveFilters = {"*.zip", "*.rar", "*.7z", "*.tar",
-                                  "*.gz",  "*.bz2"}; // 添加压缩包过滤器
-
-    foreach (const QFileInfo &fileInfo, fileList) {
-        bool isImage = false;
-        foreach (const QString &filter, imageFilters) {
-            if (fileInfo.fileName().endsWith(filter.mid(1), Qt::CaseInsensitive)) {
-                newImageList.append(fileInfo.fileName());
-                isImage = true;
-                break;
+    const int generation = scanGeneration.fetchAndAddOrdered(1) + 1;
+    const QString dirPath = currentDir.absolutePath();
+
+    scanCollected.clear();
+    scanStreaming = dirPath != listedDirPath || recursiveListing != listedRecursive;
+    if (scanStreaming) {
+        listedDirPath = dirPath;
+        listedRecursive = recursiveListing;
+        imageSorter.setFolder(dirPath);
+        imageList.clear();
+        thumbnailWidget->setImageList(imageList, currentDir);
+        startMetadataProbe();
+    }
+    // 枚举前开始监视，枚举期间写入的文件不会漏掉（重复的由 mergeIntoImageList 去掉）。
+    // 递归时子文件夹的监视在枚举完成后按枚举到的子文件夹建立
+    folderWatcher->watch(dirPath, recursiveListing);
+
+    QPointer<ImageWidget> guard(this);
+    QAtomicInt *currentGeneration = &scanGeneration;
+    const bool recursive = recursiveListing;
+    const int maxDepth = recursiveMaxDepth;
+    QtConcurrent::run(&scanPool, [guard, currentGeneration, generation, dirPath, recursive, maxDepth]() {
+        // 递归枚举时回调来自多个遍历线程，这里只做原子读取和投递
+        const DirectoryScanner::ChunkCallback onChunk = [&](const QStringList &fileNames) {
+            if (currentGeneration->loadAcquire() != generation || !guard) {
+                return false;
             }
+            QMetaObject::invokeMethod(guard, [guard, fileNames, generation]() {
+                if (guard) {
+                    guard->onDirectoryChunk(fileNames, generation);
+                }
+            }, Qt::QueuedConnection);
+            return true;
+        };
+        QStringList directories;
+        const bool complete = recursive ? DirectoryScanner::scanRecursive(dirPath, maxDepth, onChunk, &directories)
+                                        : DirectoryScanner::scan(dirPath, onChunk);
+        if (!guard) {
+            return;
         }
+        QMetaObject::invokeMethod(guard, [guard, generation, complete, directories]() {
+            if (guard) {
+                guard->onDirectoryScanFinished(generation, complete, directories);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
 
-        // 如果不是图片，检查是否是压缩包
-        if (!isImage) {
-            foreach (const QString &filter, archiveFilters) {
-                if (fileInfo.fileName().endsWith(filter.mid(1),
-                                                 Qt::CaseInsensitive)) {
-                    newImageList.append(fileInfo.fileName());
-                    break;
-                }
+void ImageWidget::onDirectoryChunk(const QStringList &fileNames, int generation)
+{
+    if (generation != scanGeneration.loadAcquire()) {
+        return;
+    }
+    if (!scanStreaming) {
+        scanCollected.append(fileNames);
+        return;
+    }
+    if (isArchiveMode) {
+        // 浏览压缩包期间不改动列表；退出后重新枚举
+        listedDirPath.clear();
+        return;
+    }
+    mergeIntoImageList(fileNames);
+}
+
+void ImageWidget::onDirectoryScanFinished(int generation, bool complete, const QStringList &directories)
+{
+    if (generation != scanGeneration.loadAcquire() || isArchiveMode) {
+        return;
+    }
+    if (complete && listedRecursive) {
+        folderWatcher->setSubdirectories(directories);
+    }
+
+    if (!scanStreaming) {
+        if (!complete) {
+            return;
+        }
+        // 只有当文件列表实际发生变化时才更新：只增删差异部分，已加载的缩略图保留
+        const QSet<QString> found(scanCollected.cbegin(), scanCollected.cend());
+        const QSet<QString> listed(imageList.cbegin(), imageList.cend());
+        QStringList added;
+        QStringList removed;
+        for (const QString &fileName : scanCollected) {
+            if (!listed.contains(fileName)) {
+                added.append(fileName);
+            }
+        }
+        for (const QString &fileName : imageList) {
+            if (!found.contains(fileName)) {
+                removed.append(fileName);
             }
         }
+        scanCollected.clear();
+        if (!added.isEmpty() || !removed.isEmpty()) {
+            removeFromImageList(removed);
+            mergeIntoImageList(added);
+            qDebug() << "找到文件:" << imageList.size() << "个（包含图片和压缩包），新增" << added.size()
+                     << "删除" << removed.size();
+            startMetadataProbe();
+        }
+        return;
+    }
+
+    qDebug() << "找到文件:" << imageList.size() << "个（包含图片和压缩包）";
+    if (currentViewMode == ThumbnailView && currentImageIndex < 0 && !imageList.isEmpty() &&
+        thumbnailWidget->getSelectedIndex() < 0) {
+        currentImageIndex = 0;
+        thumbnailWidget->setSelectedIndex(0);
+    }
+    startMetadataProbe();
+    updateWindowTitle();
+}
+
+// 把一批新文件合并进有序列表；插入会移动后面的索引，当前图片和正在解码的图片按文件名重新定位
+void ImageWidget::mergeIntoImageList(QStringList fileNames)
+{
+    // 监视和枚举可能送来同一个文件
+    fileNames.removeDuplicates();
+    fileNames.removeIf([this](const QString &fileName) {
+        return imageSorter.contains(imageList, fileName);
+    });
+    if (fileNames.isEmpty()) {
+        return;
     }
 
-    newImageList.sort();
+    const QString pendingName = pendingImageIndex >= 0 ? imageList.value(pendingImageIndex) : QString();
+    imageSorter.sort(fileNames);
+    imageList = imageSorter.merge(imageList, fileNames);
+    if (fileNames.size() == 1) {
+        thumbnailWidget->insertImageAt(imageList.indexOf(fileNames.first()), fileNames.first());
+    } else {
+        thumbnailWidget->addImages(imageList, fileNames);
+    }
 
-    // 只有当文件列表实际发生变化时才更新和输出日志
-    if (newImageList != imageList) {
-        imageList = newImageList;
-        thumbnailWidget->setImageList(imageList, currentDir);
-        qDebug() << "找到文件:" << imageList.size() << "个（包含图片和压缩包）";
+    const QString currentName = currentImagePath.isEmpty() ? QString() : listEntryName(currentImagePath);
+    if (!currentName.isEmpty()) {
+        currentImageIndex = imageList.indexOf(currentName);
+    }
+    if (!pendingName.isEmpty()) {
+        pendingImageIndex = imageList.indexOf(pendingName);
+    }
+}
+
+// 从列表删除一批文件；当前图片被删时索引停在原位置（即下一个文件）
+void ImageWidget::removeFromImageList(const QStringList &fileNames)
+{
+    if (fileNames.isEmpty()) {
+        return;
+    }
+    // 同名文件之后再出现时重新计算排序键（修改时间和大小可能已经不同）
+    imageSorter.forget(fileNames);
+    const QSet<QString> removed(fileNames.cbegin(), fileNames.cend());
+    const QString pendingName = pendingImageIndex >= 0 ? imageList.value(pendingImageIndex) : QString();
+
+    QStringList kept;
+    kept.reserve(imageList.size());
+    int removedBeforeCurrent = 0;
+    for (int i = 0; i < imageList.size(); ++i) {
+        if (removed.contains(imageList.at(i))) {
+            if (i < currentImageIndex) {
+                ++removedBeforeCurrent;
+            }
+        } else {
+            kept.append(imageList.at(i));
+        }
+    }
+    if (kept.size() == imageList.size()) {
+        return;
+    }
+
+    imageList = kept;
+    thumbnailWidget->removeImages(imageList, fileNames);
+
+    if (currentImageIndex >= 0) {
+        currentImageIndex = imageList.isEmpty() ? -1
+                                                : qMin(currentImageIndex - removedBeforeCurrent, imageList.size() - 1);
+    }
+    if (!pendingName.isEmpty()) {
+        pendingImageIndex = imageList.indexOf(pendingName);
+    }
+}
+
+QString ImageWidget::listEntryName(const QString &filePath) const
+{
+    QFileInfo fileInfo(filePath);
+    if (fileInfo.absoluteDir() == currentDir) {
+        return fileInfo.fileName();
+    }
+    if (listedRecursive) {
+        const QString relativePath = currentDir.relativeFilePath(fileInfo.absoluteFilePath());
+        if (!relativePath.startsWith(QLatin1String("../")) && !QDir::isAbsolutePath(relativePath)) {
+            return relativePath;
+        }
+    }
+    return QString();
+}
+
+void ImageWidget::setRecursiveListing(bool enabled)
+{
+    if (enabled == recursiveListing) {
+        return;
+    }
+    recursiveListing = enabled;
+    qDebug() << "递归浏览子文件夹:" << enabled << "最大深度:" << recursiveMaxDepth;
+    if (!isArchiveMode && !listedDirPath.isEmpty() && currentDir.exists()) {
+        loadImageList();
+    }
+}
+
+// 切换排序方式：只重排已有列表，缩略图缓存和加载队列保留，当前图片和选中项跟随文件名
+void ImageWidget::setSortMode(ImageListSorter::Mode mode)
+{
+    if (mode == imageSorter.mode()) {
+        return;
+    }
+    imageSorter.setMode(mode);
+    qDebug() << "排序方式:" << ImageListSorter::modeName(mode);
+
+    if (isArchiveMode) {
+        const QString currentName = imageList.value(currentImageIndex);
+        loadArchiveImageList();
+        if (!currentName.isEmpty()) {
+            currentImageIndex = imageList.indexOf(currentName);
+            thumbnailWidget->setSelectedIndex(currentImageIndex);
+        }
+        return;
+    }
+    if (imageList.isEmpty()) {
+        return;
+    }
+
+    const QString currentName = imageList.value(currentImageIndex);
+    const QString pendingName = imageList.value(pendingImageIndex);
+    imageSorter.sort(imageList);
+    thumbnailWidget->reorderImages(imageList);
+    if (!currentName.isEmpty()) {
+        currentImageIndex = imageList.indexOf(currentName);
+    }
+    if (!pendingName.isEmpty()) {
+        pendingImageIndex = imageList.indexOf(pendingName);
+    }
+    schedulePrefetch();
+    updateWindowTitle();
+}
+
+void ImageWidget::onFolderFilesChanged(const QStringList &written, const QStringList &removed)
+{
+    if (isArchiveMode) {
+        // 退出压缩包时重新枚举
+        listedDirPath.clear();
+        return;
+    }
+    if (folderWatcher->folder() != listedDirPath) {
+        return;
+    }
+
+    QStringList added;
+    QStringList modified;
+    for (const QString &fileName : written) {
+        (imageSorter.contains(imageList, fileName) ? modified : added).append(fileName);
+    }
+
+    // 删除和改写的文件：丢弃所有缓存中的旧内容
+    const QStringList changed = removed + modified;
+    for (const QString &fileName : changed) {
+        const QString filePath = currentDir.absoluteFilePath(fileName);
+        DecodedImageCache::shared().remove(filePath);
+        FileReadAhead::shared().remove(filePath);
+    }
+    // 文件头信息表也去掉它们：改写后尺寸可能不同，解码时重新探测是否需要区域解码
+    if (metadataTable && metadataTable->folder() == listedDirPath && !changed.isEmpty()) {
+        QSharedPointer<ImageMetadataTable> table = QSharedPointer<ImageMetadataTable>::create(*metadataTable);
+        table->remove(changed);
+        metadataTable = table;
+        thumbnailWidget->setMetadataTable(metadataTable);
+    }
+
+    removeFromImageList(removed);
+    mergeIntoImageList(added);
+    if (!modified.isEmpty()) {
+        // 按修改时间或大小排序时改写会改变位置：重新计算键后移到新位置（缩略图随之重新加载）
+        if (imageSorter.mode() == ImageListSorter::ByModified || imageSorter.mode() == ImageListSorter::BySize) {
+            removeFromImageList(modified);
+            mergeIntoImageList(modified);
+        } else {
+            // 位置不变，但之后切换到按修改时间或大小排序时要用新的键
+            imageSorter.forget(modified);
+            thumbnailWidget->invalidateImages(modified);
+        }
+    }
+    qDebug() << "文件夹变化: 新增" << added.size() << "删除" << removed.size() << "改写" << modified.size();
+
+    // 正在查看的图片被改写时重新加载
+    if (currentViewMode == SingleView && currentImageIndex >= 0 &&
+        modified.contains(imageList.value(currentImageIndex)) &&
+        currentImagePath == currentDir.absoluteFilePath(imageList.at(currentImageIndex))) {
+        loadImageByIndex(currentImageIndex, false);
+    }
+    updateWindowTitle();
+}
+
+void ImageWidget::onFolderRescanNeeded()
+{
+    if (isArchiveMode) {
+        listedDirPath.clear();
+        return;
+    }
+    if (folderWatcher->folder() == listedDirPath && currentDir.absolutePath() == listedDirPath &&
+        currentDir.exists()) {
+        loadImageList();
     }
 }
 
@@ -183,10 +526,15 @@ bool ImageWidget::loadImageByIndex(int index, bool fromCache)
     }
 
     bool result = false;
+    updateNavigationDirection(index);
 
     if (isArchiveMode) {
         // 压缩包模式：使用内部文件名
         QString imagePath = imageList.at(index);
+        cancelPendingImageLoad();
+
+        // 固实压缩包：告知即将浏览的条目，顺序读取经过时一并保存
+        archiveHandler.setUpcomingFiles(upcomingArchiveEntries(index));
         result = loadImageFromArchive(imagePath);
 
         // 更新当前图片路径为压缩包路径 + 内部文件路径
@@ -196,59 +544,113 @@ bool ImageWidget::loadImageByIndex(int index, bool fromCache)
     } else {
         // 普通文件模式：构建完整文件路径
         QString imagePath = currentDir.absoluteFilePath(imageList.at(index));
-        result = loadImage(imagePath, fromCache);
+        DecodedImage cached;
+        if (ArchiveHandler::isSupportedArchive(imagePath)) {
+            result = loadImage(imagePath, fromCache);
+        } else if (fromCache && DecodedImageCache::shared().lookup(DecodedImageCache::FullImages, imagePath, &cached)) {
+            // 预取命中：只需在界面线程转换为 QPixmap
+            qDebug() << "预取缓存命中:" << imagePath;
+            cancelPendingImageLoad();
+            result = showDecodedImage(cached);
+        } else {
+            // 在后台解码，完成后由 onImageDecoded 显示
+            requestImageLoad(index, imagePath);
+            return true;
+        }
     }
 
     // 更新当前索引
     if (result) {
         currentImageIndex = index;
+        onImageIndexShown();
+    }
 
-        // 如果当前是缩略图模式，更新选中项
-        if (currentViewMode == ThumbnailView) {
-            thumbnailWidget->setSelectedIndex(currentImageIndex);
-        }
+    return result;
+}
 
-        // 预加载下一张图片（用于幻灯片）
-        if (isSlideshowActive) {
-            int nextIndex = (currentImageIndex + 1) % imageList.size();
-
-            if (isArchiveMode) {
-                // 压缩包模式预加载
-                QString nextPath = imageList.at(nextIndex);
-                if (!archiveImageCache.contains(nextPath)) {
-                    QtConcurrent::run([this, nextIndex]() {
-                        QString nextPath = imageList.at(nextIndex);
-                        QByteArray imageData = archiveHandler.extractFile(nextPath);
-                        if (!imageData.isEmpty()) {
-                            QPixmap tempPixmap;
-                            if (tempPixmap.loadFromData(imageData)) {
-                                QMutexLocker locker(&cacheMutex);
-                                archiveImageCache.insert(nextPath, tempPixmap);
-                                qDebug() << "预加载压缩包图片:" << nextPath;
-                            }
-                        }
-                    });
-                }
-            } else {
-                // 普通文件模式预加载
-                QString nextPath =
-                    currentDir.absoluteFilePath(imageList.at(nextIndex));
-                if (!imageCache.contains(nextPath)) {
-                    QtConcurrent::run([this, nextIndex]() {
-                        QString nextPath =
-                            currentDir.absoluteFilePath(imageList.at(nextIndex));
-                        QPixmap tempPixmap;
-                        if (tempPixmap.load(nextPath)) {
-                            QMutexLocker locker(&cacheMutex);
-                            imageCache.insert(nextPath, tempPixmap);
-                        }
-                    });
-                }
-            }
+// 异步加载：每次请求递增 loadGeneration，排队中的过期请求不再解码，
+// 解码完成时已有更新请求的结果直接丢弃，界面始终显示最新一次请求的图片
+void ImageWidget::requestImageLoad(int index, const QString &imagePath)
+{
+    const int request = loadGeneration.fetchAndAddOrdered(1) + 1;
+    pendingImageIndex = index;
+    qDebug() << "请求异步加载:" << index << imagePath << "请求号:" << request;
+
+    QPointer<ImageWidget> guard(this);
+    QAtomicInt *generation = &loadGeneration;
+    const QSize knownSize = metadataTable ? metadataTable->imageSize(imagePath) : QSize();
+    QtConcurrent::run(&imageLoadPool, [guard, generation, imagePath, request, knownSize]() {
+        if (generation->loadAcquire() != request) {
+            return;
+        }
+        DecodedImage decoded = decodeImageFile(imagePath, knownSize);
+        if (!guard) {
+            return;
         }
+        QMetaObject::invokeMethod(guard, [guard, decoded, request]() {
+            if (guard) {
+                guard->onImageDecoded(decoded, request);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ImageWidget::onImageDecoded(const DecodedImage &decoded, int request)
+{
+    if (loadGeneration.loadAcquire() != request) {
+        qDebug() << "丢弃过期的加载结果:" << decoded.filePath;
+        return;
     }
+    pendingImageIndex = -1;
 
-    return result;
+    if (decoded.image.isNull() || !showDecodedImage(decoded)) {
+        qDebug() << "异步加载失败:" << decoded.filePath;
+        return;
+    }
+    DecodedImageCache::shared().insert(DecodedImageCache::FullImages, decoded);
+    onImageIndexShown();
+}
+
+void ImageWidget::cancelPendingImageLoad()
+{
+    loadGeneration.fetchAndAddOrdered(1);
+    pendingImageIndex = -1;
+}
+
+// 单张模式下导航的起点：有尚未完成的请求时从请求的位置继续，按住方向键不会停在原地
+int ImageWidget::navigationIndex() const
+{
+    return pendingImageIndex >= 0 ? pendingImageIndex : currentImageIndex;
+}
+
+// 显示了新的一张图片后：同步缩略图选中项并预取前后的图片
+void ImageWidget::onImageIndexShown()
+{
+    if (currentImageIndex < 0 || imageList.isEmpty()) {
+        return;
+    }
+
+    // 如果当前是缩略图模式，更新选中项
+    if (currentViewMode == ThumbnailView) {
+        thumbnailWidget->setSelectedIndex(currentImageIndex);
+    }
+
+    const PixelBufferPool::Stats poolStats = PixelBufferPool::shared().stats();
+    qDebug() << "像素缓冲池: 命中" << poolStats.hits << "新分配" << poolStats.misses
+             << "复用" << poolStats.bytesRecycled / (1024 * 1024) << "MB"
+             << "空闲" << poolStats.idleBytes / (1024 * 1024) << "MB";
+
+    if (!isArchiveMode) {
+        // 普通文件模式：按浏览方向预取窗口内的图片
+        schedulePrefetch();
+    } else if (isSlideshowActive) {
+        // 压缩包模式预加载：沿当前的顺序读取继续，结果放入暂存缓存
+        QStringList upcoming = upcomingArchiveEntries(currentImageIndex);
+        QtConcurrent::run([this, upcoming]() {
+            archiveHandler.prefetchFiles(upcoming);
+            qDebug() << "预加载压缩包图片:" << upcoming;
+        });
+    }
 }
 
 void ImageWidget::loadNextImage()
@@ -262,7 +664,7 @@ void ImageWidget::loadNextImage()
         return;
     }
 
-    int nextIndex = (currentImageIndex + 1) % imageList.size();
+    int nextIndex = ((currentViewMode == SingleView ? navigationIndex() : currentImageIndex) + 1) % imageList.size();
     qDebug() << "计算出的下一个索引:" << nextIndex;
 
     if (currentViewMode == SingleView) {
@@ -293,7 +695,8 @@ void ImageWidget::loadPreviousImage()
         return;
     }
 
-    int prevIndex = (currentImageIndex - 1 + imageList.size()) % imageList.size();
+    int baseIndex = currentViewMode == SingleView ? navigationIndex() : currentImageIndex;
+    int prevIndex = (baseIndex - 1 + imageList.size()) % imageList.size();
     qDebug() << "计算出的上一个索引:" << prevIndex;
 
     if (currentViewMode == SingleView) {
@@ -375,73 +778,7 @@ void ImageWidget::dropEvent(QDropEvent *event)
 
 void ImageWidget::deleteCurrentImage()
 {
-    if (currentImagePath.isEmpty() || !QFile::exists(currentImagePath)) {
-        QMessageBox::warning(this, tr("警告"), tr("没有可删除的图片"));
-        return;
-    }
-
-    // 确认对话框
-    QMessageBox::StandardButton reply;
-    reply = QMessageBox::question(this, tr("确认删除"),
-                                  tr("确定要将图片 '") +
-                                      QFileInfo(currentImagePath).fileName() +
-                                      tr("' 移动到回收站吗？"),
-                                  QMessageBox::Yes | QMessageBox::No);
-
-    if (reply != QMessageBox::Yes) {
-        return;
-    }
-
-    QString imageToDelete = currentImagePath;
-    int indexToDelete = currentImageIndex;
-
-    // 移动到回收站而不是直接删除
-    if (moveFileToRecycleBin(imageToDelete)) {
-        // 从缓存中移除
-        imageCache.remove(imageToDelete);
-
-        // 从缩略图缓存中移除
-        ThumbnailWidget::clearThumbnailCacheForImage(imageToDelete);
-
-        // 从图片列表中移除
-        if (indexToDelete >= 0 && indexToDelete < imageList.size()) {
-            imageList.removeAt(indexToDelete);
-
-            // 更新缩略图
-            thumbnailWidget->setImageList(imageList, currentDir);
-
-            // 确定下一张要显示的图片
-            if (imageList.isEmpty()) {
-                // 如果没有图片了
-                pixmap = QPixmap();
-                currentImagePath.clear();
-                currentImageIndex = -1;
-                if (currentViewMode == SingleView) {
-                    switchToThumbnailView();
-                }
-            } else {
-                // 计算新的索引
-                int newIndex = indexToDelete;
-                if (newIndex >= imageList.size()) {
-                    newIndex = imageList.size() - 1;
-                }
-
-                if (currentViewMode == SingleView) {
-                    // 单张视图模式下加载新图片
-                    loadImageByIndex(newIndex);
-                } else {
-                    // 缩略图模式下更新选中项
-                    currentImageIndex = newIndex;
-                    thumbnailWidget->setSelectedIndex(newIndex);
-                }
-            }
-
-            update();
-            updateWindowTitle();
-        }
-    } else {
-        QMessageBox::critical(this, tr("错误"), tr("移动图片到回收站失败"));
-    }
+    deleteImageFile(currentImagePath, currentImageIndex, false);
 }
 
 void ImageWidget::deleteSelectedThumbnail()
@@ -449,94 +786,121 @@ void ImageWidget::deleteSelectedThumbnail()
     if (currentViewMode == ThumbnailView) {
         int selectedIndex = thumbnailWidget->getSelectedIndex();
         if (selectedIndex >= 0 && selectedIndex < imageList.size()) {
-            // 临时切换到要删除的图片，然后调用删除函数
+            // 直接按选中项删除，不必先解码整张图片
             QString imagePath =
                 currentDir.absoluteFilePath(imageList.at(selectedIndex));
-            loadImage(imagePath);
-            currentImageIndex = selectedIndex;
-            deleteCurrentImage();
+            deleteImageFile(imagePath, selectedIndex, false);
         } else {
             QMessageBox::warning(this, tr("警告"), tr("请先选择要删除的图片"));
         }
     }
 }
 
+void ImageWidget::permanentlyDeleteCurrentImage()
+{
+    deleteImageFile(currentImagePath, currentImageIndex, true);
+}
 
+void ImageWidget::permanentlyDeleteSelectedThumbnail()
+{
+    if (currentViewMode == ThumbnailView) {
+        int selectedIndex = thumbnailWidget->getSelectedIndex();
+        if (selectedIndex >= 0 && selectedIndex < imageList.size()) {
+            QString imagePath =
+                currentDir.absoluteFilePath(imageList.at(selectedIndex));
+            deleteImageFile(imagePath, selectedIndex, true);
+        } else {
+            QMessageBox::warning(this, tr("警告"), tr("请先选择要删除的图片"));
+        }
+    }
+}
 
-void ImageWidget::permanentlyDeleteCurrentImage()
+// 删除 filePath（index 为它在列表中的位置，不在列表中时为 -1）。
+// 列表和缩略图只移除这一项，其余缩略图缓存、加载队列和进度保持不变
+void ImageWidget::deleteImageFile(const QString &filePath, int index, bool permanent)
 {
-    if (currentImagePath.isEmpty() || !QFile::exists(currentImagePath)) {
+    if (filePath.isEmpty() || !QFile::exists(filePath)) {
         QMessageBox::warning(this, tr("警告"), tr("没有可删除的图片"));
         return;
     }
 
-    // 警告对话框
+    // 确认对话框
     QMessageBox::StandardButton reply;
-    reply = QMessageBox::warning(
-        this, tr("永久删除警告"),
-        tr("确定要永久删除图片 '") + QFileInfo(currentImagePath).fileName() +
-            "' 吗？\n"
-            "此操作无法撤销，文件将无法恢复！",
-        QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel);
+    if (permanent) {
+        reply = QMessageBox::warning(
+            this, tr("永久删除警告"),
+            tr("确定要永久删除图片 '") + QFileInfo(filePath).fileName() +
+                "' 吗？\n"
+                "此操作无法撤销，文件将无法恢复！",
+            QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel);
+    } else {
+        reply = QMessageBox::question(this, tr("确认删除"),
+                                      tr("确定要将图片 '") +
+                                          QFileInfo(filePath).fileName() +
+                                          tr("' 移动到回收站吗？"),
+                                      QMessageBox::Yes | QMessageBox::No);
+    }
 
     if (reply != QMessageBox::Yes) {
         return;
     }
 
-    QString imageToDelete = currentImagePath;
-    int indexToDelete = currentImageIndex;
-
-    // 直接删除文件
-    if (QFile::remove(imageToDelete)) {
-        // 其余代码与 deleteCurrentImage 相同
-        imageCache.remove(imageToDelete);
-        ThumbnailWidget::clearThumbnailCacheForImage(imageToDelete);
+    // 移动到回收站，或直接删除文件
+    const bool deleted = permanent ? QFile::remove(filePath) : moveFileToRecycleBin(filePath);
+    if (!deleted) {
+        if (permanent) {
+            QMessageBox::critical(this, tr("错误"), tr("删除图片失败，可能没有权限或文件被占用"));
+        } else {
+            QMessageBox::critical(this, tr("错误"), tr("移动图片到回收站失败"));
+        }
+        return;
+    }
 
-        if (indexToDelete >= 0 && indexToDelete < imageList.size()) {
-            imageList.removeAt(indexToDelete);
-            thumbnailWidget->setImageList(imageList, currentDir);
+    // 从缓存中移除
+    DecodedImageCache::shared().remove(filePath);
+    FileReadAhead::shared().remove(filePath);
+    ThumbnailWidget::clearThumbnailCacheForImage(filePath);
 
-            if (imageList.isEmpty()) {
-                pixmap = QPixmap();
-                currentImagePath.clear();
-                currentImageIndex = -1;
-                if (currentViewMode == SingleView) {
-                    switchToThumbnailView();
-                }
-            } else {
-                int newIndex = indexToDelete;
-                if (newIndex >= imageList.size()) {
-                    newIndex = imageList.size() - 1;
-                }
+    if (index < 0 || index >= imageList.size()) {
+        return;
+    }
 
-                if (currentViewMode == SingleView) {
-                    loadImageByIndex(newIndex);
-                } else {
-                    currentImageIndex = newIndex;
-                    thumbnailWidget->setSelectedIndex(newIndex);
-                }
-            }
+    // 从图片列表和缩略图中移除这一项；之后文件夹监视报告的删除找不到它，不会重复处理
+    imageSorter.forget(QStringList{imageList.at(index)});
+    imageList.removeAt(index);
+    thumbnailWidget->removeImageAt(index);
+    if (pendingImageIndex == index) {
+        cancelPendingImageLoad();
+    } else if (pendingImageIndex > index) {
+        --pendingImageIndex;
+    }
 
-            update();
-            updateWindowTitle();
+    // 确定下一张要显示的图片
+    if (imageList.isEmpty()) {
+        // 如果没有图片了
+        pixmap = QPixmap();
+        animationPlayer->stop();
+        animationFrame = QImage();
+        cancelPendingImageLoad();
+        currentImagePath.clear();
+        currentImageIndex = -1;
+        if (currentViewMode == SingleView) {
+            switchToThumbnailView();
         }
     } else {
-        QMessageBox::critical(this, tr("错误"), tr("删除图片失败，可能没有权限或文件被占用"));
-    }
-}
+        // 停在原位置，即原来的下一张
+        int newIndex = qMin(index, int(imageList.size()) - 1);
 
-void ImageWidget::permanentlyDeleteSelectedThumbnail()
-{
-    if (currentViewMode == ThumbnailView) {
-        int selectedIndex = thumbnailWidget->getSelectedIndex();
-        if (selectedIndex >= 0 && selectedIndex < imageList.size()) {
-            QString imagePath =
-                currentDir.absoluteFilePath(imageList.at(selectedIndex));
-            loadImage(imagePath);
-            currentImageIndex = selectedIndex;
-            permanentlyDeleteCurrentImage();
+        if (currentViewMode == SingleView) {
+            // 单张视图模式下加载新图片
+            loadImageByIndex(newIndex);
         } else {
-            QMessageBox::warning(this, tr("警告"), tr("请先选择要删除的图片"));
+            // 缩略图模式下更新选中项
+            currentImageIndex = newIndex;
+            thumbnailWidget->setSelectedIndex(newIndex);
         }
     }
+
+    update();
+    updateWindowTitle();
 }
@@ -109,6 +109,14 @@ void ImageWidget::showContextMenu(const QPoint &globalPos)
     connect(openpicshowAction, &QAction::triggered, this,
             &ImageWidget::openImage);
 
+    QAction *recursiveAction = openfileshowMenu->addAction(tr("包含子文件夹"));
+    recursiveAction->setCheckable(true);
+    recursiveAction->setChecked(recursiveListing);
+    connect(recursiveAction, &QAction::triggered, [this](bool checked) {
+        setRecursiveListing(checked);
+        saveConfiguration();
+    });
+
     if (currentViewMode == SingleView) {
         QAction *showAction1 =
             openfileshowMenu->addAction(tr("保存图片 (Ctrl+S)"));
@@ -125,6 +133,25 @@ void ImageWidget::showContextMenu(const QPoint &globalPos)
                 &ImageWidget::pasteImageFromClipboard);
     }
 
+    // 排序方式
+    QMenu *sortMenu = contextMenu.addMenu(tr("排序"));
+    const QList<QPair<ImageListSorter::Mode, QString>> sortModes = {
+        {ImageListSorter::ByNaturalName, tr("名称（自然顺序）")},
+        {ImageListSorter::ByName, tr("名称（字符顺序）")},
+        {ImageListSorter::ByModified, tr("修改时间")},
+        {ImageListSorter::BySize, tr("文件大小")},
+    };
+    for (const auto &sortMode : sortModes) {
+        QAction *sortAction = sortMenu->addAction(sortMode.second);
+        sortAction->setCheckable(true);
+        sortAction->setChecked(imageSorter.mode() == sortMode.first);
+        const ImageListSorter::Mode mode = sortMode.first;
+        connect(sortAction, &QAction::triggered, [this, mode]() {
+            setSortMode(mode);
+            saveConfiguration();
+        });
+    }
+
     // 窗口控制菜单
     QMenu *windowshowMenu = contextMenu.addMenu(tr("窗口"));
     QAction *windowshowAction1 = windowshowMenu->addAction(
@@ -38,7 +38,7 @@ void ImageWidget::mousePressEvent(QMouseEvent *event)
         } else if (event->button() == Qt::LeftButton) {
             // 检查是否在图片区域内
             if (!pixmap.isNull()) {
-                QSize scaledSize = pixmap.size() * scaleFactor;
+                QSize scaledSize = displayImageSize() * scaleFactor;
                 QPointF offset((width() - scaledSize.width()) / 2 + panOffset.x(),
                                (height() - scaledSize.height()) / 2 + panOffset.y());
                 QRectF imageRect(offset, scaledSize);
@@ -84,7 +84,7 @@ void ImageWidget::mouseMoveEvent(QMouseEvent *event)
         QPointF delta = event->pos() - panStartPosition;
         panOffset += delta;
         panStartPosition = event->pos();
-        update();
+        scheduleInteractiveFrame();
     }
 }
 
@@ -106,7 +106,7 @@ void ImageWidget::mouseDoubleClickEvent(QMouseEvent *event)
         } else if (currentViewMode == SingleView) {
             // 检查是否在图片区域内，并且不在切换区域
             if (!pixmap.isNull()) {
-                QSize scaledSize = pixmap.size() * scaleFactor;
+                QSize scaledSize = displayImageSize() * scaleFactor;
                 QPointF offset((width() - scaledSize.width()) / 2 + panOffset.x(),
                                (height() - scaledSize.height()) / 2 + panOffset.y());
                 QRectF imageRect(offset, scaledSize);
@@ -0,0 +1,162 @@
+// imagewidget_prefetch.cpp
+#include "imagewidget.h"
+#include "filereadahead.h"
+#include <QPointer>
+#include <QDebug>
+
+namespace {
+
+const int kMaxPrefetchWindow = 16;
+const int kMaxReadAheadWindow = 100;
+const int kPrefetchThreads = 2;
+
+} // namespace
+
+// 只根据相邻的前后翻页更新方向，跳转（Home/End、点击缩略图）不改变
+void ImageWidget::updateNavigationDirection(int index)
+{
+    const int count = imageList.size();
+    const int from = navigationIndex();
+    if (count < 2 || from < 0 || index == from) {
+        return;
+    }
+    if (index == (from + 1) % count) {
+        navigationDirection = 1;
+    } else if (index == (from - 1 + count) % count) {
+        navigationDirection = -1;
+    }
+}
+
+// 预取顺序：近的优先，同一距离先沿浏览方向，再反方向
+QVector<int> ImageWidget::prefetchIndices(int ahead, int behind) const
+{
+    QVector<int> indices;
+    const int count = imageList.size();
+    if (count < 2 || currentImageIndex < 0) {
+        return indices;
+    }
+
+    const int window = qMax(ahead, behind);
+    for (int distance = 1; distance <= window; ++distance) {
+        if (distance <= ahead) {
+            int index = ((currentImageIndex + navigationDirection * distance) % count + count) % count;
+            if (index != currentImageIndex && !indices.contains(index)) {
+                indices.append(index);
+            }
+        }
+        if (distance <= behind) {
+            int index = ((currentImageIndex - navigationDirection * distance) % count + count) % count;
+            if (index != currentImageIndex && !indices.contains(index)) {
+                indices.append(index);
+            }
+        }
+    }
+    return indices;
+}
+
+// 每次显示新图片后调用：排队中尚未开始的旧预取全部放弃，按新位置重新排队
+void ImageWidget::schedulePrefetch()
+{
+    prefetchPool.clear();
+    const int generation = prefetchGeneration.fetchAndAddOrdered(1) + 1;
+
+    if (isArchiveMode || currentViewMode != SingleView) {
+        return;
+    }
+
+    // 第一层：更宽的窗口只读入压缩数据（沿浏览方向多读一些）
+    if (readAheadWindow > 0) {
+        QStringList readAheadPaths;
+        for (int index : prefetchIndices(readAheadWindow, qMax(1, readAheadWindow / 2))) {
+            const QString filePath = currentDir.absoluteFilePath(imageList.at(index));
+            if (!ArchiveHandler::isSupportedArchive(filePath)) {
+                readAheadPaths.append(filePath);
+            }
+        }
+        FileReadAhead::shared().schedule(readAheadPaths);
+    }
+
+    // 第二层：窄窗口完整解码
+    for (int index : prefetchIndices(prefetchAhead, prefetchBehind)) {
+        const QString filePath = currentDir.absoluteFilePath(imageList.at(index));
+        if (ArchiveHandler::isSupportedArchive(filePath) ||
+            DecodedImageCache::shared().contains(DecodedImageCache::FullImages, filePath)) {
+            continue;
+        }
+
+        QAtomicInt *currentGeneration = &prefetchGeneration;
+        const QSize knownSize = metadataTable ? metadataTable->imageSize(filePath) : QSize();
+        QtConcurrent::run(&prefetchPool, [currentGeneration, generation, filePath, knownSize]() {
+            DecodedImageCache &cache = DecodedImageCache::shared();
+            if (currentGeneration->loadAcquire() != generation ||
+                cache.contains(DecodedImageCache::FullImages, filePath)) {
+                return;
+            }
+            DecodedImage decoded = decodeImageFile(filePath, knownSize);
+            if (!decoded.image.isNull()) {
+                cache.insert(DecodedImageCache::FullImages, decoded);
+                qDebug() << "预取完成:" << filePath << "缓存占用:"
+                         << cache.usedBytes(DecodedImageCache::FullImages) / (1024 * 1024) << "MB";
+            }
+        });
+    }
+}
+
+void ImageWidget::setPrefetchWindow(int ahead, int behind, int readAhead)
+{
+    prefetchAhead = qBound(0, ahead, kMaxPrefetchWindow);
+    prefetchBehind = qBound(0, behind, kMaxPrefetchWindow);
+    readAheadWindow = qBound(0, readAhead, kMaxReadAheadWindow);
+    prefetchPool.setMaxThreadCount(kPrefetchThreads);
+    qDebug() << "预取窗口: 前" << prefetchAhead << "张，后" << prefetchBehind << "张，预读"
+             << readAheadWindow << "张";
+}
+
+// 打开文件夹后读取全部文件头；切换文件夹或进入压缩包后旧的任务尽快结束，结果丢弃
+void ImageWidget::startMetadataProbe()
+{
+    const int generation = metadataGeneration.fetchAndAddOrdered(1) + 1;
+    metadataTable.reset();
+    thumbnailWidget->setMetadataTable(metadataTable);
+
+    if (isArchiveMode || imageList.isEmpty()) {
+        return;
+    }
+
+    QStringList fileNames;
+    for (const QString &fileName : imageList) {
+        if (!ArchiveHandler::isSupportedArchive(fileName)) {
+            fileNames.append(fileName);
+        }
+    }
+
+    QPointer<ImageWidget> guard(this);
+    QAtomicInt *currentGeneration = &metadataGeneration;
+    QThreadPool *pool = &metadataPool;
+    const QString folder = currentDir.absolutePath();
+    QtConcurrent::run(pool, [guard, currentGeneration, generation, pool, folder, fileNames]() {
+        QSharedPointer<ImageMetadataTable> table(new ImageMetadataTable(folder));
+        const bool complete = table->build(fileNames, pool, [currentGeneration, generation]() {
+            return currentGeneration->loadAcquire() != generation;
+        });
+        if (!complete || !guard) {
+            return;
+        }
+        QSharedPointer<const ImageMetadataTable> result = table;
+        QMetaObject::invokeMethod(guard, [guard, result, generation]() {
+            if (guard) {
+                guard->onMetadataReady(result, generation);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ImageWidget::onMetadataReady(const QSharedPointer<const ImageMetadataTable> &table, int generation)
+{
+    if (generation != metadataGeneration.loadAcquire() || isArchiveMode ||
+        table->folder() != currentDir.absolutePath()) {
+        return;
+    }
+    metadataTable = table;
+    thumbnailWidget->setMetadataTable(metadataTable);
+}
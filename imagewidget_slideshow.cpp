@@ -45,43 +45,61 @@ void ImageWidget::slideshowNext()
 
     int nextIndex = (currentImageIndex + 1) % imageList.size();
 
-    // 预加载下一张图片（如果不在缓存中）
-    if (!imageCache.contains(currentDir.absoluteFilePath(imageList.at(nextIndex)))) {
-        QtConcurrent::run([this, nextIndex]() {
-            QString nextPath = currentDir.absoluteFilePath(imageList.at(nextIndex));
-            QPixmap tempPixmap;
-            if (tempPixmap.load(nextPath)) {
-                QMutexLocker locker(&cacheMutex);
-                imageCache.insert(nextPath, tempPixmap);
-            }
-        });
-    }
-
-    // 加载当前图片
+    // 下一张已由导航预取窗口在后台解码
     loadImageByIndex(nextIndex, true);
 }
 
+// 从当前位置向后在后台解码，放入原图缓存；解码量达到缓存预算即停止，
+// 不再把整个文件夹的原图都留在内存中。之后的导航预取优先，会取消尚未完成的预加载。
 void ImageWidget::preloadAllImages()
 {
-    imageCache.clear();
+    if (isArchiveMode || imageList.isEmpty()) {
+        return;
+    }
 
-    int loadedCount = 0;
-    for (const QString &fileName : imageList) {
-        QString filePath = currentDir.absoluteFilePath(fileName);
-        QPixmap tempPixmap;
-        if (tempPixmap.load(filePath)) {
-            imageCache.insert(filePath, tempPixmap);
-            loadedCount++;
-            // 移除单条日志消息，减少干扰
-        }
+    QStringList filePaths;
+    const int start = qMax(0, currentImageIndex);
+    for (int i = 0; i < imageList.size(); ++i) {
+        filePaths.append(currentDir.absoluteFilePath(imageList.at((start + i) % imageList.size())));
     }
 
+    prefetchPool.clear();
+    const int generation = prefetchGeneration.fetchAndAddOrdered(1) + 1;
+    QAtomicInt *currentGeneration = &prefetchGeneration;
+    const QSharedPointer<const ImageMetadataTable> table = metadataTable;
+    QtConcurrent::run(&prefetchPool, [currentGeneration, generation, filePaths, table]() {
+        DecodedImageCache &cache = DecodedImageCache::shared();
+        const qint64 budget = cache.budget(DecodedImageCache::FullImages);
+        qint64 loadedBytes = 0;
+        int loadedCount = 0;
+        for (const QString &filePath : filePaths) {
+            if (currentGeneration->loadAcquire() != generation || loadedBytes >= budget) {
+                break;
+            }
+            if (ArchiveHandler::isSupportedArchive(filePath) ||
+                cache.contains(DecodedImageCache::FullImages, filePath)) {
+                continue;
+            }
+            DecodedImage decoded = decodeImageFile(filePath, table ? table->imageSize(filePath) : QSize());
+            if (decoded.image.isNull()) {
+                continue;
+            }
+            if (loadedBytes + decoded.image.sizeInBytes() > budget) {
+                break;
+            }
+            if (cache.insert(DecodedImageCache::FullImages, decoded)) {
+                loadedBytes += decoded.image.sizeInBytes();
+                loadedCount++;
+            }
+        }
+        qDebug() << "预加载完成:" << loadedCount << "张，" << loadedBytes / (1024 * 1024) << "MB";
+    });
+
     updateWindowTitle();
 }
 
 void ImageWidget::clearImageCache()
 {
-    int cacheSize = imageCache.size();
-    imageCache.clear();
+    DecodedImageCache::shared().clear(DecodedImageCache::FullImages);
     updateWindowTitle();
 }
@@ -1,6 +1,20 @@
 // imagewidget_transform.cpp
 #include "imagewidget.h"
 #include <QTransform>
+#include <QMessageBox>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+// 保存/复制原分辨率图像的上限（约 1GB ARGB32），超过时拒绝而不是静默写出预览图
+const qint64 kMaxExportPixels = 256LL * 1024 * 1024;
+// 每个区域解码任务的行数上限（按字节计）
+const qint64 kExportBandBytes = 64LL * 1024 * 1024;
+
+} // namespace
 
 void ImageWidget::mirrorHorizontal()
 {
@@ -48,35 +62,10 @@ void ImageWidget::applyTransformations()
 {
     if (originalPixmap.isNull()) return;
 
-    QTransform transform;
-
-    // 应用镜像变换
-    if (isHorizontallyFlipped || isVerticallyFlipped) {
-        qreal scaleX = isHorizontallyFlipped ? -1.0 : 1.0;
-        qreal scaleY = isVerticallyFlipped ? -1.0 : 1.0;
-        transform.scale(scaleX, scaleY);
-
-        // 调整位置，确保镜像后图片仍然可见
-        if (isHorizontallyFlipped) {
-            transform.translate(-originalPixmap.width(), 0);
-        }
-        if (isVerticallyFlipped) {
-            transform.translate(0, -originalPixmap.height());
-        }
-    }
-
-    // 应用旋转变换
-    if (rotationAngle != 0) {
-        // 移动到中心点旋转
-        transform.translate(originalPixmap.width() / 2.0,
-                            originalPixmap.height() / 2.0);
-        transform.rotate(rotationAngle);
-        transform.translate(-originalPixmap.width() / 2.0,
-                            -originalPixmap.height() / 2.0);
-    }
-
-    // 应用变换
-    pixmap = originalPixmap.transformed(transform, Qt::SmoothTransformation);
+    // 旋转和镜像只是视图状态，由 paintEvent 作为绘制变换应用，不复制像素；
+    // 渲染器的瓦片缓存按未旋转的坐标保存，变换后可以直接复用
+    qDebug() << "应用变换: 旋转" << rotationAngle << "水平镜像" << isHorizontallyFlipped
+             << "垂直镜像" << isVerticallyFlipped;
 
     // 重置平移偏移
     panOffset = QPointF(0, 0);
@@ -103,3 +92,86 @@ bool ImageWidget::isTransformed() const
 {
     return rotationAngle != 0 || isHorizontallyFlipped || isVerticallyFlipped;
 }
+
+ImageOrientation ImageWidget::currentOrientation() const
+{
+    return ImageOrientation(rotationAngle, isHorizontallyFlipped, isVerticallyFlipped);
+}
+
+QImage ImageWidget::orientedImage() const
+{
+    return currentOrientation().apply(pixmap.toImage());
+}
+
+QImage ImageWidget::fullResolutionImage()
+{
+    if (!regionSource) {
+        return orientedImage();
+    }
+
+    const QSize size = regionSource->size();
+    if (!regionSource->supportsRegions()) {
+        QMessageBox::warning(this, tr("警告"),
+                             tr("该图片（%1×%2）只能逐行缩小显示，无法按原分辨率保存或复制")
+                                 .arg(size.width()).arg(size.height()));
+        return QImage();
+    }
+    if (qint64(size.width()) * size.height() > kMaxExportPixels) {
+        QMessageBox::warning(this, tr("警告"),
+                             tr("图片太大（%1×%2），无法按原分辨率保存或复制")
+                                 .arg(size.width()).arg(size.height()));
+        return QImage();
+    }
+
+    const QImage::Format format = regionSource->overview().hasAlphaChannel() ? QImage::Format_ARGB32
+                                                                            : QImage::Format_RGB32;
+    QImage result(size, format);
+    if (result.isNull()) {
+        QMessageBox::warning(this, tr("警告"), tr("内存不足，无法按原分辨率保存或复制"));
+        return QImage();
+    }
+
+    // 按整行分段并行解码，每段写入结果中互不重叠的行
+    const int bandRows = qMax<qint64>(1, kExportBandBytes / result.bytesPerLine());
+    QVector<QRect> bands;
+    for (int y = 0; y < size.height(); y += bandRows) {
+        bands.append(QRect(0, y, size.width(), qMin(bandRows, size.height() - y)));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QAtomicInt failed;
+    const QSharedPointer<RegionImageSource> source = regionSource;
+    QtConcurrent::blockingMap(bands, [&](const QRect &band) {
+        QImage decoded = source->decodeRegion(band, band.size());
+        if (decoded.size() != band.size()) {
+            failed.storeRelaxed(1);
+            return;
+        }
+        decoded = decoded.convertToFormat(format);
+        for (int row = 0; row < band.height(); ++row) {
+            std::memcpy(result.scanLine(band.top() + row), decoded.constScanLine(row),
+                        size_t(band.width()) * 4);
+        }
+    });
+    if (failed.loadRelaxed()) {
+        QMessageBox::warning(this, tr("警告"), tr("按原分辨率解码图片失败"));
+        return QImage();
+    }
+
+    qDebug() << "原分辨率图像:" << size << "分段:" << bands.size() << "耗时" << timer.elapsed() << "ms";
+    return currentOrientation().apply(result);
+}
+
+// 渲染器在未旋转的坐标系中绘制 (0, 0, 缩放后尺寸)，这里把它放到控件上显示的位置
+QTransform ImageWidget::imageToWidgetTransform() const
+{
+    QRectF displayed = displayedImageRect();
+    ImageOrientation orientation = currentOrientation();
+    QSizeF unrotatedSize = orientation.mapSize(displayed.size());
+
+    // 左上角取整，与渲染器的瓦片取整方式一致，避免 90° 旋转后出现半像素采样
+    QTransform transform = orientation.transform(unrotatedSize);
+    transform *= QTransform::fromTranslate(qRound(displayed.left()), qRound(displayed.top()));
+    return transform;
+}
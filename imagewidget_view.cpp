@@ -9,7 +9,6 @@
 void ImageWidget::paintEvent(QPaintEvent *event)
 {
     if (currentViewMode == SingleView) {
-        Q_UNUSED(event);
         QPainter painter(this);
 
         // 如果启用了透明背景，使用透明颜色填充
@@ -32,7 +31,7 @@ void ImageWidget::paintEvent(QPaintEvent *event)
             scaleFactor = 1.0;
         }
 
-        QSize scaledSize = pixmap.size() * scaleFactor;
+        QSize scaledSize = displayImageSize() * scaleFactor;
 
         // 安全检查：确保缩放后的尺寸有效
         if (scaledSize.width() <= 0 || scaledSize.height() <= 0) {
@@ -41,21 +40,43 @@ void ImageWidget::paintEvent(QPaintEvent *event)
             return;
         }
 
-        qDebug() << "绘制图片 - 原始尺寸:" << pixmap.size() << "缩放后:" << scaledSize;
+        // 动画帧已在解码线程中缩小到显示尺寸，每帧只需一次绘制，不重建渲染器
+        const bool drawAnimationFrame = isAnimationActive() && !animationFrame.isNull();
 
-        QPixmap scaledPixmap = pixmap.scaled(scaledSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-        // 安全检查：确保缩放后的pixmap有效
-        if (scaledPixmap.isNull()) {
-            painter.setPen(Qt::white);
-            painter.drawText(rect(), Qt::AlignCenter, tr("图片缩放失败"));
-            return;
+        // 图片（含变换）改变时才重建渲染器，缩放和平移只重绘可见瓦片
+        if (!drawAnimationFrame && rendererSourceKey != pixmap.cacheKey()) {
+            if (isRegionRenderingActive()) {
+                imageRenderer.setRegionSource(regionSource, pixmap.toImage());
+            } else {
+                imageRenderer.setImage(pixmap.toImage());
+            }
+            rendererSourceKey = pixmap.cacheKey();
         }
 
-        QPointF offset((width() - scaledPixmap.width()) / 2 + panOffset.x(),
-                       (height() - scaledPixmap.height()) / 2 + panOffset.y());
+        QRectF targetRect = displayedImageRect();
+        QPointF offset = targetRect.topLeft();
+
+        // 渲染器在未旋转的坐标系中绘制，旋转和镜像由绘制变换在输出时完成
+        QTransform imageTransform = imageToWidgetTransform();
+        QRectF imageRect(QPointF(0, 0), currentOrientation().mapSize(targetRect.size()));
+        QRect imageViewport = imageTransform.inverted().mapRect(QRectF(event->rect())).toAlignedRect();
 
-        painter.drawPixmap(offset, scaledPixmap);
+        // 大于显示尺寸的动画帧在解码线程中缩小
+        if (isAnimationActive()) {
+            animationPlayer->setTargetSize((imageRect.size() * devicePixelRatioF()).toSize());
+        }
+
+        painter.save();
+        painter.setTransform(imageTransform);
+        if (drawAnimationFrame) {
+            painter.setRenderHint(QPainter::SmoothPixmapTransform, !interactiveRendering);
+            painter.drawImage(imageRect, animationFrame);
+        } else {
+            imageRenderer.paint(painter, imageRect, imageViewport,
+                                interactiveRendering ? TiledImageRenderer::Interactive
+                                                     : TiledImageRenderer::Smooth);
+        }
+        painter.restore();
 
         // 添加变换状态提示
         if (isTransformed()) {
@@ -112,6 +133,82 @@ void ImageWidget::drawNavigationArrows(QPainter &painter, const QPointF &offset,
     painter.setOpacity(1.0); // 恢复不透明
 }
 
+bool ImageWidget::isRegionRenderingActive() const
+{
+    return regionSource && !pixmap.isNull() && pixmap.cacheKey() == regionPixmapKey;
+}
+
+// 区域解码模式下 pixmap 是预览图，显示尺寸按原图计算；旋转 90°/270° 时宽高互换
+QSize ImageWidget::displayImageSize() const
+{
+    QSize size = pixmap.size();
+    if (isRegionRenderingActive()) {
+        size = regionSource->size();
+    } else if (isAnimationActive() && animationPlayer->frameSize().isValid()) {
+        size = animationPlayer->frameSize();
+    }
+    return currentOrientation().mapSize(size);
+}
+
+// 播放结束后仍保持为动画状态（最后一帧可能是缩小过的），直到切换图片
+bool ImageWidget::isAnimationActive() const
+{
+    return animationPlayer && !animationPlayer->filePath().isEmpty();
+}
+
+// 只替换当前帧并重绘图片所在区域；pixmap 不变，渲染器的金字塔和瓦片缓存保留
+void ImageWidget::onAnimationFrame(const QImage &frame)
+{
+    animationFrame = frame;
+    if (currentViewMode == SingleView && isVisible()) {
+        update(displayedImageRect().toAlignedRect().adjusted(-1, -1, 1, 1) & rect());
+    }
+}
+
+QRectF ImageWidget::displayedImageRect() const
+{
+    QSize scaledSize = displayImageSize() * scaleFactor;
+    QPointF offset((width() - scaledSize.width()) / 2 + panOffset.x(),
+                   (height() - scaledSize.height()) / 2 + panOffset.y());
+    return QRectF(offset, QSizeF(scaledSize));
+}
+
+// 拖动/滚轮期间：切换到快速渲染，重绘合并到下一显示帧，并推迟平滑重绘
+void ImageWidget::scheduleInteractiveFrame()
+{
+    interactiveRendering = true;
+    smoothRenderTimer->start();
+
+    if (!renderFrameTimer->isActive()) {
+        qreal refreshRate = screen() ? screen()->refreshRate() : 60.0;
+        int frameInterval = qMax(1, qRound(1000.0 / qMax<qreal>(1.0, refreshRate)));
+        renderFrameTimer->start(frameInterval);
+    }
+}
+
+// 停止操作约 150ms 后，在后台生成当前视口的平滑瓦片
+void ImageWidget::onSmoothRenderIdle()
+{
+    if (currentViewMode != SingleView || pixmap.isNull()) {
+        interactiveRendering = false;
+        return;
+    }
+    QTransform imageTransform = imageToWidgetTransform();
+    QRectF imageRect(QPointF(0, 0), currentOrientation().mapSize(displayedImageRect().size()));
+    imageRenderer.requestSmoothTiles(imageRect,
+                                     imageTransform.inverted().mapRect(QRectF(rect())).toAlignedRect());
+}
+
+void ImageWidget::onSmoothTilesReady()
+{
+    // 等待期间又开始拖动或缩放时保持快速渲染，等下一次空闲
+    if (smoothRenderTimer->isActive()) {
+        return;
+    }
+    interactiveRendering = false;
+    update();
+}
+
 bool ImageWidget::shouldShowNavigationArrows(const QSize &scaledSize)
 {
     return scaledSize.width() > 600 && scaledSize.height() > 600;
@@ -128,7 +225,7 @@ void ImageWidget::fitToWindow()
         windowSize = desktopRect.size();
     }
 
-    QSize imageSize = pixmap.size();
+    QSize imageSize = displayImageSize();
     double widthRatio = static_cast<double>(windowSize.width()) / imageSize.width();
     double heightRatio = static_cast<double>(windowSize.height()) / imageSize.height();
 
@@ -165,7 +262,14 @@ void ImageWidget::wheelEvent(QWheelEvent *event)
             scaleFactor /= zoomFactor;
         }
 
-        scaleFactor = qBound(0.03, scaleFactor, 8.0);
+        // 超大图片适应窗口时的比例可能低于 0.03，下限不高于该比例
+        double minScale = 0.03;
+        QSize imageSize = displayImageSize();
+        if (!imageSize.isEmpty()) {
+            minScale = qMin(minScale, qMin(static_cast<double>(width()) / imageSize.width(),
+                                           static_cast<double>(height()) / imageSize.height()));
+        }
+        scaleFactor = qBound(minScale, scaleFactor, 8.0);
 
         QPointF mousePos = event->position();
         QPointF imagePos =
@@ -174,7 +278,7 @@ void ImageWidget::wheelEvent(QWheelEvent *event)
         panOffset = mousePos - QPointF(width() / 2, height() / 2) -
                     imagePos * scaleFactor;
 
-        update();
+        scheduleInteractiveFrame();
     }
 }
 
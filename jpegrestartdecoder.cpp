@@ -0,0 +1,351 @@
+// jpegrestartdecoder.cpp
+#include "jpegrestartdecoder.h"
+#include <QtConcurrent>
+#include <QAtomicInt>
+#include <QThread>
+#include <QDebug>
+#include <climits>
+#include <cstring>
+#include <vector>
+
+#ifdef HAVE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+namespace {
+
+QAtomicInt parallelDecode(1);
+
+inline int readBigEndian16(const uchar *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+} // namespace
+
+JpegRestartDecoder::JpegRestartDecoder(const QByteArray &data)
+    : data(data),
+      valid(false),
+      interval(0),
+      heightOffset(0),
+      headerLength(0),
+      mcuWidth(8),
+      mcuHeight(8)
+{
+    valid = parse();
+}
+
+bool JpegRestartDecoder::parse()
+{
+    if (data.size() < 4 || data.size() > INT_MAX) {
+        return false;
+    }
+    const uchar *p = reinterpret_cast<const uchar *>(data.constData());
+    const int n = int(data.size());
+    if (p[0] != 0xFF || p[1] != 0xD8) {
+        return false;
+    }
+
+    // 文件头：找到 SOF、DRI 和 SOS
+    int components = 0;
+    int hMax = 1;
+    int vMax = 1;
+    bool haveFrame = false;
+    int pos = 2;
+    while (headerLength == 0) {
+        if (pos >= n || p[pos] != 0xFF) {
+            return false;
+        }
+        while (pos < n && p[pos] == 0xFF) {
+            ++pos;   // 标记前允许填充 0xFF
+        }
+        if (pos >= n) {
+            return false;
+        }
+        const uchar marker = p[pos++];
+        if (marker == 0xD8 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            continue;   // 没有长度字段的标记
+        }
+        if (marker == 0xD9 || pos + 2 > n) {
+            return false;
+        }
+        const int length = readBigEndian16(p + pos);
+        if (length < 2 || pos + length > n) {
+            return false;
+        }
+        const uchar *payload = p + pos + 2;
+        const int payloadLength = length - 2;
+
+        switch (marker) {
+        case 0xC0:   // 基线
+        case 0xC1:   // 扩展哈夫曼
+            if (payloadLength < 6 || payload[0] != 8) {
+                return false;
+            }
+            heightOffset = pos + 3;
+            imageSize = QSize(readBigEndian16(payload + 3), readBigEndian16(payload + 1));
+            components = payload[5];
+            if ((components != 1 && components != 3) || payloadLength < 6 + 3 * components) {
+                return false;
+            }
+            for (int i = 0; i < components; ++i) {
+                const uchar sampling = payload[6 + 3 * i + 1];
+                hMax = qMax(hMax, sampling >> 4);
+                vMax = qMax(vMax, sampling & 0x0F);
+            }
+            haveFrame = true;
+            break;
+        case 0xC2: case 0xC3:
+        case 0xC5: case 0xC6: case 0xC7:
+        case 0xC9: case 0xCA: case 0xCB:
+        case 0xCD: case 0xCE: case 0xCF:
+            return false;   // 渐进式、无损、分层、算术编码
+        case 0xDD:
+            if (payloadLength < 2) {
+                return false;
+            }
+            interval = readBigEndian16(payload);
+            break;
+        case 0xDA:
+            // 只处理包含全部分量的单次扫描
+            if (!haveFrame || payloadLength < 1 || payload[0] != components) {
+                return false;
+            }
+            headerLength = pos + length;
+            break;
+        default:
+            break;
+        }
+        pos += length;
+    }
+
+    // 高度为 0 表示使用 DNL，无法拆分
+    if (imageSize.isEmpty() || interval <= 0) {
+        return false;
+    }
+    if (components > 1) {
+        mcuWidth = 8 * hMax;
+        mcuHeight = 8 * vMax;
+    }
+
+    // 熵编码数据：按 RSTn 切段，遇到 EOI 结束
+    int start = headerLength;
+    int i = start;
+    bool foundEnd = false;
+    while (i < n && !foundEnd) {
+        if (p[i] != 0xFF) {
+            ++i;
+            continue;
+        }
+        int j = i + 1;
+        while (j < n && p[j] == 0xFF) {
+            ++j;
+        }
+        if (j >= n) {
+            return false;
+        }
+        const uchar marker = p[j];
+        if (marker == 0x00) {
+            i = j + 1;   // 填充字节
+        } else if (marker >= 0xD0 && marker <= 0xD7) {
+            segments.append({start, i - start});
+            start = j + 1;
+            i = start;
+        } else if (marker == 0xD9) {
+            segments.append({start, i - start});
+            foundEnd = true;
+        } else {
+            return false;   // 后续还有扫描或 DNL
+        }
+    }
+    if (!foundEnd) {
+        return false;
+    }
+
+    const qint64 mcusPerRow = (imageSize.width() + mcuWidth - 1) / mcuWidth;
+    const qint64 mcuRows = (imageSize.height() + mcuHeight - 1) / mcuHeight;
+    const qint64 expectedSegments = (mcusPerRow * mcuRows + interval - 1) / interval;
+    if (segments.size() != expectedSegments) {
+        qDebug() << "JPEG 重启段数量不符:" << segments.size() << "预期" << expectedSegments;
+        return false;
+    }
+    return segments.size() > 1;
+}
+
+// 每个带从位于 MCU 行首的段开始，尽量平均分配行数
+QVector<JpegRestartDecoder::Band> JpegRestartDecoder::planBands(int bandCount) const
+{
+    QVector<Band> bands;
+    const qint64 mcusPerRow = (imageSize.width() + mcuWidth - 1) / mcuWidth;
+    const int mcuRows = (imageSize.height() + mcuHeight - 1) / mcuHeight;
+    const int count = int(segments.size());
+
+    int bandSegment = 0;
+    int bandRow = 0;
+    for (int k = 1; k < bandCount; ++k) {
+        const qint64 targetMcu = qint64(mcuRows) * k / bandCount * mcusPerRow;
+        int segment = int((targetMcu + interval - 1) / interval);
+        while (segment < count && (qint64(segment) * interval) % mcusPerRow != 0) {
+            ++segment;
+        }
+        if (segment >= count) {
+            break;
+        }
+        const int row = int(qint64(segment) * interval / mcusPerRow);
+        if (row <= bandRow) {
+            continue;
+        }
+        bands.append({bandSegment, segment, bandRow * mcuHeight, (row - bandRow) * mcuHeight});
+        bandSegment = segment;
+        bandRow = row;
+    }
+    bands.append({bandSegment, count, bandRow * mcuHeight, imageSize.height() - bandRow * mcuHeight});
+    return bands;
+}
+
+JpegRestartDecoder::Band JpegRestartDecoder::contextBand(const Band &band) const
+{
+    const qint64 mcusPerRow = (imageSize.width() + mcuWidth - 1) / mcuWidth;
+    const int count = int(segments.size());
+    const auto rowOf = [&](int segment) { return int(qint64(segment) * interval / mcusPerRow); };
+    const auto atRowStart = [&](int segment) { return (qint64(segment) * interval) % mcusPerRow == 0; };
+
+    Band context = band;
+    if (band.firstSegment > 0) {
+        int segment = band.firstSegment - 1;
+        while (segment > 0 && !atRowStart(segment)) {
+            --segment;
+        }
+        context.firstSegment = segment;
+        context.firstRow = rowOf(segment) * mcuHeight;
+    }
+    int endRow = band.firstRow + band.rowCount;
+    if (band.segmentEnd < count) {
+        int segment = band.segmentEnd + 1;
+        while (segment < count && !atRowStart(segment)) {
+            ++segment;
+        }
+        context.segmentEnd = segment;
+        endRow = segment < count ? rowOf(segment) * mcuHeight : imageSize.height();
+    }
+    context.rowCount = endRow - context.firstRow;
+    return context;
+}
+
+// 原文件头（高度改为带高）+ 带内的段（RSTn 从 0 重新编号）+ EOI
+QByteArray JpegRestartDecoder::bandStream(const Band &band) const
+{
+    qsizetype size = headerLength + 2;
+    for (int s = band.firstSegment; s < band.segmentEnd; ++s) {
+        size += segments.at(s).length + 2;
+    }
+
+    QByteArray stream;
+    stream.reserve(size);
+    stream.append(data.constData(), headerLength);
+    stream[heightOffset] = char((band.rowCount >> 8) & 0xFF);
+    stream[heightOffset + 1] = char(band.rowCount & 0xFF);
+
+    for (int s = band.firstSegment; s < band.segmentEnd; ++s) {
+        if (s > band.firstSegment) {
+            stream.append(char(0xFF));
+            stream.append(char(0xD0 + ((s - band.firstSegment - 1) & 7)));
+        }
+        const Segment &segment = segments.at(s);
+        stream.append(data.constData() + segment.offset, segment.length);
+    }
+    stream.append("\xFF\xD9", 2);
+    return stream;
+}
+
+bool JpegRestartDecoder::decodeInto(QImage &image, int scaleNum, int scaleDenom) const
+{
+#ifdef HAVE_TURBOJPEG
+    if (!valid || image.format() != QImage::Format_RGB32 || scaleNum <= 0 || scaleDenom <= 0) {
+        return false;
+    }
+    const tjscalingfactor factor = {scaleNum, scaleDenom};
+    if (image.size() != QSize(TJSCALED(imageSize.width(), factor), TJSCALED(imageSize.height(), factor))) {
+        return false;
+    }
+
+    QVector<Band> bands = planBands(QThread::idealThreadCount() * 2);
+    if (bands.size() < 2) {
+        return false;
+    }
+    // 缩放后每个带（含上方的相邻行）的起始行必须落在整数行上
+    for (const Band &band : std::as_const(bands)) {
+        if ((qint64(band.firstRow) * scaleNum) % scaleDenom != 0 ||
+            (qint64(contextBand(band).firstRow) * scaleNum) % scaleDenom != 0) {
+            return false;
+        }
+    }
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    const int pixelFormat = TJPF_BGRX;
+#else
+    const int pixelFormat = TJPF_XRGB;
+#endif
+    uchar *bits = image.bits();
+    const qsizetype bytesPerLine = image.bytesPerLine();
+    const int outputWidth = image.width();
+    const int outputHeight = image.height();
+    QAtomicInt failures(0);
+
+    // 与 ImageCodecs 的整张解码使用相同的标志（平滑色度上采样）：带连同上下相邻的 MCU 行
+    // 解码到临时缓冲区，只复制本带的行，相邻带之间没有接缝，和不拆分时的结果一致
+    QtConcurrent::blockingMap(bands, [&](const Band &band) {
+        if (failures.loadRelaxed() != 0) {
+            return;
+        }
+        const Band context = contextBand(band);
+        const QByteArray stream = bandStream(context);
+        const int firstRow = int(qint64(band.firstRow) * scaleNum / scaleDenom);
+        const int rowCount = TJSCALED(band.rowCount, factor);
+        const int contextFirstRow = int(qint64(context.firstRow) * scaleNum / scaleDenom);
+        const int contextRowCount = TJSCALED(context.rowCount, factor);
+        const int skipRows = firstRow - contextFirstRow;
+        if (firstRow + rowCount > outputHeight || skipRows + rowCount > contextRowCount) {
+            failures.ref();
+            return;
+        }
+        tjhandle handle = tjInitDecompress();
+        if (!handle) {
+            failures.ref();
+            return;
+        }
+        std::vector<uchar> buffer(size_t(contextRowCount) * size_t(bytesPerLine));
+        if (tjDecompress2(handle, reinterpret_cast<const unsigned char *>(stream.constData()),
+                          static_cast<unsigned long>(stream.size()), buffer.data(),
+                          outputWidth, int(bytesPerLine), contextRowCount, pixelFormat, 0) != 0) {
+            qDebug() << "JPEG 并行解码失败，行" << firstRow << ":" << tjGetErrorStr2(handle);
+            failures.ref();
+        } else {
+            memcpy(bits + firstRow * bytesPerLine, buffer.data() + size_t(skipRows) * size_t(bytesPerLine),
+                   size_t(rowCount) * size_t(bytesPerLine));
+        }
+        tjDestroy(handle);
+    });
+
+    if (failures.loadRelaxed() != 0) {
+        return false;
+    }
+    qDebug() << "JPEG 按重启标记并行解码:" << imageSize << "段" << segments.size() << "带" << bands.size();
+    return true;
+#else
+    Q_UNUSED(image)
+    Q_UNUSED(scaleNum)
+    Q_UNUSED(scaleDenom)
+    return false;
+#endif
+}
+
+void JpegRestartDecoder::setParallelEnabled(bool enabled)
+{
+    parallelDecode.storeRelease(enabled ? 1 : 0);
+}
+
+bool JpegRestartDecoder::parallelEnabled()
+{
+    return parallelDecode.loadAcquire() != 0;
+}
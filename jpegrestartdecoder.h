@@ -0,0 +1,68 @@
+// jpegrestartdecoder.h
+#ifndef JPEGRESTARTDECODER_H
+#define JPEGRESTARTDECODER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QSize>
+#include <QVector>
+
+// 利用重启标记（DRI / RSTn）并行解码单张基线 JPEG
+// 熵编码数据在每个 RSTn 处重置 DC 预测，各段互相独立。按 MCU 行对齐的段分成若干带，
+// 每个带拼成一个独立的小 JPEG（原文件头 + 改写的高度 + 该带的段，RSTn 重新从 0 编号），
+// 在 QtConcurrent 线程池中用 TurboJPEG 解码。和整张解码一样使用平滑色度上采样：每个带上下各多解码
+// 到相邻的 MCU 行边界，边界处的色度插值与整张解码一致，多出的行丢弃。
+// 只支持单次扫描的基线 / 扩展哈夫曼 JPEG；渐进式、算术编码、没有重启标记或段与 MCU 行不对齐时
+// isValid() 为 false，由调用方按普通方式解码。
+class JpegRestartDecoder
+{
+public:
+    explicit JpegRestartDecoder(const QByteArray &data);
+
+    bool isValid() const { return valid; }
+    QSize size() const { return imageSize; }
+    int restartInterval() const { return interval; }
+    int segmentCount() const { return segments.size(); }
+
+    // 以 scaleNum/scaleDenom 的 DCT 缩放比例解码到 image（尺寸必须与该比例下的输出一致，
+    // 格式为 RGB32）。任何一个带失败时返回 false，image 内容不确定。
+    bool decodeInto(QImage &image, int scaleNum = 1, int scaleDenom = 1) const;
+
+    // 像素数达到此值才值得拆分
+    static constexpr qint64 kMinParallelPixels = 8LL * 1024 * 1024;
+
+    // 基准测试用：关闭后 ImageCodecs 不再使用并行解码
+    static void setParallelEnabled(bool enabled);
+    static bool parallelEnabled();
+
+private:
+    struct Segment {
+        int offset;   // 熵编码数据在文件中的起点（不含前面的 RSTn）
+        int length;
+    };
+
+    struct Band {
+        int firstSegment;
+        int segmentEnd;   // 不含
+        int firstRow;     // 像素行
+        int rowCount;
+    };
+
+    bool parse();
+    QVector<Band> planBands(int bandCount) const;
+    // band 向上、向下各扩展到相邻的 MCU 行对齐段，提供色度上采样需要的相邻行
+    Band contextBand(const Band &band) const;
+    QByteArray bandStream(const Band &band) const;
+
+    QByteArray data;
+    bool valid;
+    QSize imageSize;
+    int interval;
+    int heightOffset;     // SOF 中高度字段的位置
+    int headerLength;     // SOI 到 SOS 结束
+    int mcuWidth;
+    int mcuHeight;
+    QVector<Segment> segments;
+};
+
+#endif // JPEGRESTARTDECODER_H
@@ -7,6 +7,9 @@
 #include <QDir>
 #include <QImageReader>  // 添加这个头文件
 
+#include "archiveinput.h"
+#include "benchmark.h"
+
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
@@ -48,7 +51,8 @@ int main(int argc, char *argv[])
     QCommandLineParser parser;
     QCommandLineOption langOption("lang", "Set language (zh_CN, en_US)", "language");
     parser.addOption(langOption);
-    parser.process(app);
+    // 此时其余选项还没有注册，只解析不报错
+    parser.parse(app.arguments());
 
     if (parser.isSet(langOption)) {
         locale = parser.value(langOption);
@@ -90,8 +94,55 @@ int main(int argc, char *argv[])
                                     "mb", "1024");
     parser.addOption(memoryOption);
 
+    // 压缩包输入层选项
+    QCommandLineOption archiveInputOption("archive-input",
+                                          "Archive input mode: mmap or read",
+                                          "mode", "mmap");
+    parser.addOption(archiveInputOption);
+    QCommandLineOption archiveBlockOption("archive-block-size",
+                                          "Archive read block size in KB",
+                                          "kb", "1024");
+    parser.addOption(archiveBlockOption);
+
+    // 基准测试选项：位置参数为压缩包路径
+    QCommandLineOption benchArchiveOption("bench-archive",
+                                          "Benchmark archive scan/extract throughput for the given archives");
+    parser.addOption(benchArchiveOption);
+    QCommandLineOption benchResampleOption("bench-resample",
+                                           "Benchmark image resampling kernels (synthetic image when no files are given)");
+    parser.addOption(benchResampleOption);
+    QCommandLineOption benchCodecsOption("bench-codecs",
+                                         "Benchmark Qt image plugins against the direct JPEG/PNG/WebP decoders");
+    parser.addOption(benchCodecsOption);
+
     parser.process(app);
 
+    // 处理压缩包输入层选项
+    {
+        ArchiveInput::Options inputOptions = ArchiveInput::defaultOptions();
+        if (parser.value(archiveInputOption) == "read") {
+            inputOptions.mode = ArchiveInput::BufferedRead;
+        }
+        bool ok;
+        int blockKB = parser.value(archiveBlockOption).toInt(&ok);
+        if (ok && blockKB > 0) {
+            inputOptions.blockSize = blockKB * 1024;
+        }
+        ArchiveInput::setDefaultOptions(inputOptions);
+        qDebug() << "Archive input:" << ArchiveInput::modeName(inputOptions.mode)
+                 << "block size:" << inputOptions.blockSize / 1024 << "KB";
+    }
+
+    if (parser.isSet(benchArchiveOption)) {
+        return Benchmark::runArchiveBenchmark(parser.positionalArguments());
+    }
+    if (parser.isSet(benchResampleOption)) {
+        return Benchmark::runResampleBenchmark(parser.positionalArguments());
+    }
+    if (parser.isSet(benchCodecsOption)) {
+        return Benchmark::runCodecBenchmark(parser.positionalArguments());
+    }
+
     // 处理内存限制选项
     if (parser.isSet(memoryOption)) {
         bool ok;
@@ -135,25 +186,23 @@ int main(int argc, char *argv[])
         if (QFile::exists(filePath)) {
             QFileInfo fileInfo(filePath);
 
-            // 检查文件大小，避免加载过大的文件
-            qint64 fileSize = fileInfo.size();
-            if (fileSize > 500 * 1024 * 1024) { // 500MB
-                qWarning() << "File too large:" << filePath << "Size:" << fileSize / (1024 * 1024) << "MB";
-                QMessageBox::warning(
-                    nullptr,
-                    QCoreApplication::translate("main", "文件过大"),
-                    QCoreApplication::translate("main", "文件过大 (%1 MB)，可能无法加载:\n%2")
-                        .arg(fileSize / (1024 * 1024))
-                        .arg(filePath)
-                    );
+            if (fileInfo.isDir()) {
+                window.setCurrentDir(QDir(filePath));
+                window.loadImageList();
             } else {
-                if (fileInfo.isDir()) {
-                    window.setCurrentDir(QDir(filePath));
-                    window.loadImageList();
-                } else {
-                    window.loadImage(filePath);
-                    window.switchToSingleView();
+                // 超大图片由区域解码处理，只有加载失败时才提示文件过大
+                qint64 fileSize = fileInfo.size();
+                if (!window.loadImage(filePath) && fileSize > 500 * 1024 * 1024) { // 500MB
+                    qWarning() << "File too large:" << filePath << "Size:" << fileSize / (1024 * 1024) << "MB";
+                    QMessageBox::warning(
+                        nullptr,
+                        QCoreApplication::translate("main", "文件过大"),
+                        QCoreApplication::translate("main", "文件过大 (%1 MB)，可能无法加载:\n%2")
+                            .arg(fileSize / (1024 * 1024))
+                            .arg(filePath)
+                        );
                 }
+                window.switchToSingleView();
             }
         } else {
             qWarning() << QCoreApplication::translate("main",
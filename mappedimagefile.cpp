@@ -0,0 +1,584 @@
+// mappedimagefile.cpp
+#include "mappedimagefile.h"
+#include "pixelbufferpool.h"
+#include <QFileInfo>
+#include <QHash>
+#include <QRgba64>
+#include <QDebug>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+quint16 readLE16(const uchar *p) { return quint16(p[0] | (p[1] << 8)); }
+quint32 readLE32(const uchar *p) { return quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) | (quint32(p[3]) << 24); }
+
+// TIFF 字段按文件字节序读取
+struct TiffReader {
+    const uchar *data;
+    qint64 size;
+    bool bigEndian;
+    bool bigTiff;
+
+    bool inRange(qint64 offset, qint64 length) const
+    {
+        return offset >= 0 && length >= 0 && offset <= size && length <= size - offset;
+    }
+
+    quint64 read(qint64 offset, int bytes) const
+    {
+        quint64 value = 0;
+        for (int i = 0; i < bytes; ++i) {
+            const int shift = bigEndian ? (bytes - 1 - i) * 8 : i * 8;
+            value |= quint64(data[offset + i]) << shift;
+        }
+        return value;
+    }
+};
+
+struct TiffEntry {
+    quint16 type = 0;
+    quint64 count = 0;
+    qint64 valueOffset = 0;   // 数值所在位置（内联时为条目中的值字段）
+};
+
+int tiffTypeSize(quint16 type)
+{
+    switch (type) {
+    case 1: case 2: case 6: case 7: return 1;   // BYTE ASCII SBYTE UNDEFINED
+    case 3: case 8: return 2;                   // SHORT SSHORT
+    case 4: case 9: case 11: case 13: return 4; // LONG SLONG FLOAT IFD
+    case 16: case 17: case 18: return 8;        // LONG8 SLONG8 IFD8
+    default: return 0;
+    }
+}
+
+} // namespace
+
+MappedImageFile::MappedImageFile(const QString &filePath)
+    : file(filePath),
+      mapped(nullptr),
+      mappedSize(0),
+      pixels(nullptr),
+      stride(0),
+      bottomUp(false),
+      bigEndian16(true),
+      maxValue(255),
+      layout(Rgb8)
+{
+}
+
+MappedImageFile::~MappedImageFile()
+{
+    if (mapped) {
+        file.unmap(const_cast<uchar *>(mapped));
+    }
+}
+
+QSharedPointer<MappedImageFile> MappedImageFile::open(const QString &filePath)
+{
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    const bool pnm = (suffix == "ppm" || suffix == "pgm" || suffix == "pnm");
+    const bool bmp = (suffix == "bmp" || suffix == "dib");
+    const bool tiff = (suffix == "tif" || suffix == "tiff");
+    if (!pnm && !bmp && !tiff) {
+        return QSharedPointer<MappedImageFile>();
+    }
+
+    QSharedPointer<MappedImageFile> image(new MappedImageFile(filePath));
+    if (!image->map()) {
+        return QSharedPointer<MappedImageFile>();
+    }
+
+    bool ok = false;
+    if (pnm) {
+        ok = image->parsePnm();
+    } else if (bmp) {
+        ok = image->parseBmp();
+    } else {
+        ok = image->parseTiff();
+    }
+    if (!ok) {
+        return QSharedPointer<MappedImageFile>();
+    }
+
+    qDebug() << "内存映射:" << filePath << image->name << image->imageSize
+             << (image->isZeroCopy() ? "零拷贝" : "逐行转换");
+    return image;
+}
+
+bool MappedImageFile::map()
+{
+    if (!file.open(QIODevice::ReadOnly) || file.size() < 16) {
+        return false;
+    }
+    mappedSize = file.size();
+    mapped = file.map(0, mappedSize);
+    return mapped != nullptr;
+}
+
+// P5 / P6：头部为魔数、宽、高、最大值，以空白和 # 注释分隔，最大值后跟一个空白字符
+bool MappedImageFile::parsePnm()
+{
+    if (mapped[0] != 'P' || (mapped[1] != '5' && mapped[1] != '6')) {
+        return false;
+    }
+    const bool color = (mapped[1] == '6');
+    qint64 pos = 2;
+    int values[3] = {0, 0, 0};
+    for (int &value : values) {
+        while (pos < mappedSize) {
+            if (mapped[pos] == '#') {
+                while (pos < mappedSize && mapped[pos] != '\n') {
+                    ++pos;
+                }
+            } else if (mapped[pos] == ' ' || mapped[pos] == '\t' || mapped[pos] == '\r' || mapped[pos] == '\n') {
+                ++pos;
+            } else {
+                break;
+            }
+        }
+        if (pos >= mappedSize || mapped[pos] < '0' || mapped[pos] > '9') {
+            return false;
+        }
+        qint64 number = 0;
+        while (pos < mappedSize && mapped[pos] >= '0' && mapped[pos] <= '9') {
+            number = number * 10 + (mapped[pos] - '0');
+            if (number > 0x7fffffff) {
+                return false;
+            }
+            ++pos;
+        }
+        value = int(number);
+    }
+    ++pos;   // 最大值后的单个空白
+
+    imageSize = QSize(values[0], values[1]);
+    maxValue = values[2];
+    // 8 位样本只接受 255，其他最大值需要逐像素缩放，交给 Qt 插件
+    if (maxValue == 255) {
+        layout = color ? Rgb8 : Gray8;
+    } else if (maxValue > 255 && maxValue <= 65535) {
+        layout = color ? Rgb16 : Gray16;
+        bigEndian16 = true;
+    } else {
+        return false;
+    }
+    name = color ? QStringLiteral("PPM") : QStringLiteral("PGM");
+    stride = qsizetype(imageSize.width()) * bytesPerPixel();
+    return finishLayout(pos);
+}
+
+// 只处理未压缩（BI_RGB / 标准掩码的 BI_BITFIELDS）的 8 / 24 / 32 位 BMP
+bool MappedImageFile::parseBmp()
+{
+    if (mappedSize < 54 || mapped[0] != 'B' || mapped[1] != 'M') {
+        return false;
+    }
+    const quint32 pixelOffset = readLE32(mapped + 10);
+    const quint32 headerSize = readLE32(mapped + 14);
+    if (headerSize < 40 || 14 + qint64(headerSize) > mappedSize) {
+        return false;
+    }
+    const qint32 width = qint32(readLE32(mapped + 18));
+    const qint32 height = qint32(readLE32(mapped + 22));
+    const quint16 planes = readLE16(mapped + 26);
+    const quint16 bitCount = readLE16(mapped + 28);
+    const quint32 compression = readLE32(mapped + 30);
+    if (planes != 1 || width <= 0 || height == 0 || height == INT_MIN) {
+        return false;
+    }
+
+    imageSize = QSize(width, height < 0 ? -height : height);
+    bottomUp = height > 0;
+    name = QStringLiteral("BMP");
+
+    if (bitCount == 8 && compression == 0) {
+        quint32 colors = readLE32(mapped + 46);
+        if (colors == 0 || colors > 256) {
+            colors = 256;
+        }
+        const qint64 paletteOffset = 14 + qint64(headerSize);
+        if (paletteOffset + qint64(colors) * 4 > mappedSize) {
+            return false;
+        }
+        colorTable.resize(256);
+        colorTable.fill(qRgb(0, 0, 0));
+        for (quint32 i = 0; i < colors; ++i) {
+            const uchar *entry = mapped + paletteOffset + i * 4;
+            colorTable[int(i)] = qRgb(entry[2], entry[1], entry[0]);
+        }
+        layout = Indexed8;
+    } else if (bitCount == 24 && compression == 0) {
+        layout = Bgr8;
+    } else if (bitCount == 32 && compression == 0) {
+        layout = Bgrx8;
+    } else if (bitCount == 32 && compression == 3) {
+        // 掩码紧跟在 40 字节的信息头之后，V4/V5 头中也在同一位置
+        if (mappedSize < 66) {
+            return false;
+        }
+        if (readLE32(mapped + 54) != 0x00FF0000 || readLE32(mapped + 58) != 0x0000FF00 ||
+            readLE32(mapped + 62) != 0x000000FF) {
+            return false;
+        }
+        const bool alpha = headerSize >= 56 && mappedSize >= 70 && readLE32(mapped + 66) == 0xFF000000;
+        layout = alpha ? Bgra8 : Bgrx8;
+    } else {
+        return false;
+    }
+
+    // 每行按 4 字节对齐
+    stride = ((qsizetype(imageSize.width()) * bitCount + 31) / 32) * 4;
+    return finishLayout(pixelOffset);
+}
+
+// 经典 TIFF 和 BigTIFF 的第一个 IFD：未压缩、单平面、条带连续存放的 8 位灰度 / RGB / RGBA 和 16 位灰度 / RGB
+bool MappedImageFile::parseTiff()
+{
+    TiffReader reader = {mapped, mappedSize, false, false};
+    if (mapped[0] == 'M' && mapped[1] == 'M') {
+        reader.bigEndian = true;
+    } else if (!(mapped[0] == 'I' && mapped[1] == 'I')) {
+        return false;
+    }
+
+    const quint64 magic = reader.read(2, 2);
+    qint64 ifdOffset = 0;
+    if (magic == 42) {
+        ifdOffset = qint64(reader.read(4, 4));
+    } else if (magic == 43 && reader.read(4, 2) == 8) {
+        reader.bigTiff = true;
+        ifdOffset = qint64(reader.read(8, 8));
+    } else {
+        return false;
+    }
+
+    const int countBytes = reader.bigTiff ? 8 : 2;
+    const int entryBytes = reader.bigTiff ? 20 : 12;
+    const int valueBytes = reader.bigTiff ? 8 : 4;
+    if (!reader.inRange(ifdOffset, countBytes)) {
+        return false;
+    }
+    const quint64 entryCount = reader.read(ifdOffset, countBytes);
+    if (!reader.inRange(ifdOffset + countBytes, qint64(entryCount) * entryBytes)) {
+        return false;
+    }
+
+    QHash<quint16, TiffEntry> entries;
+    for (quint64 i = 0; i < entryCount; ++i) {
+        const qint64 at = ifdOffset + countBytes + qint64(i) * entryBytes;
+        TiffEntry entry;
+        const quint16 tag = quint16(reader.read(at, 2));
+        entry.type = quint16(reader.read(at + 2, 2));
+        entry.count = reader.read(at + 4, reader.bigTiff ? 8 : 4);
+        const qint64 valueField = at + (reader.bigTiff ? 12 : 8);
+        const int typeSize = tiffTypeSize(entry.type);
+        if (typeSize == 0 || entry.count > quint64(mappedSize)) {
+            continue;
+        }
+        entry.valueOffset = (entry.count * typeSize <= quint64(valueBytes))
+            ? valueField : qint64(reader.read(valueField, valueBytes));
+        if (!reader.inRange(entry.valueOffset, qint64(entry.count) * typeSize)) {
+            return false;
+        }
+        entries.insert(tag, entry);
+    }
+
+    auto value = [&](quint16 tag, quint64 index, quint64 defaultValue) -> quint64 {
+        auto it = entries.constFind(tag);
+        if (it == entries.constEnd() || index >= it->count) {
+            return defaultValue;
+        }
+        const int typeSize = tiffTypeSize(it->type);
+        return reader.read(it->valueOffset + qint64(index) * typeSize, typeSize);
+    };
+
+    if (entries.contains(322) || !entries.contains(273)) {   // TileWidth / StripOffsets
+        return false;
+    }
+    const quint64 width = value(256, 0, 0);
+    const quint64 height = value(257, 0, 0);
+    const quint64 samples = value(277, 0, 1);
+    const quint64 bits = value(258, 0, 1);
+    const quint64 photometric = value(262, 0, 1);
+    if (width == 0 || height == 0 || width > 0x7fffffff || height > 0x7fffffff ||
+        value(259, 0, 1) != 1 || value(284, 0, 1) != 1 || value(274, 0, 1) != 1) {
+        return false;   // 压缩、分平面存储或带方向标记
+    }
+    for (quint64 i = 1; i < samples; ++i) {
+        if (value(258, i, bits) != bits) {
+            return false;
+        }
+    }
+
+    if (photometric == 1 && samples == 1 && bits == 8) {
+        layout = Gray8;
+    } else if (photometric == 1 && samples == 1 && bits == 16) {
+        layout = Gray16;
+    } else if (photometric == 2 && samples == 3 && bits == 8) {
+        layout = Rgb8;
+    } else if (photometric == 2 && samples == 3 && bits == 16) {
+        layout = Rgb16;
+    } else if (photometric == 2 && samples == 4 && bits == 8) {
+        layout = value(338, 0, 2) == 1 ? Rgba8Premultiplied : Rgba8;
+    } else {
+        return false;
+    }
+    bigEndian16 = reader.bigEndian;
+    maxValue = bits == 16 ? 65535 : 255;
+    imageSize = QSize(int(width), int(height));
+    stride = qsizetype(width) * bytesPerPixel();
+    name = QStringLiteral("TIFF");
+
+    // 各条带必须首尾相接，整张图片才是一块连续的像素区
+    const quint64 rowsPerStrip = qMin(value(278, 0, height), height);
+    const quint64 strips = entries.value(273).count;
+    if (rowsPerStrip == 0 || strips != (height + rowsPerStrip - 1) / rowsPerStrip) {
+        return false;
+    }
+    const qint64 firstOffset = qint64(value(273, 0, 0));
+    const qint64 stripBytes = qint64(rowsPerStrip) * stride;
+    for (quint64 i = 1; i < strips; ++i) {
+        if (qint64(value(273, i, 0)) != firstOffset + qint64(i) * stripBytes) {
+            return false;
+        }
+    }
+    return finishLayout(firstOffset);
+}
+
+bool MappedImageFile::finishLayout(qint64 pixelOffset)
+{
+    if (imageSize.isEmpty() || stride <= 0 || pixelOffset <= 0) {
+        return false;
+    }
+    // 最后一行只需要实际像素，不要求行尾填充也在文件内
+    const qint64 lastRowBytes = qint64(imageSize.width()) * bytesPerPixel();
+    const qint64 required = qint64(stride) * (imageSize.height() - 1) + lastRowBytes;
+    if (pixelOffset > mappedSize || required > mappedSize - pixelOffset) {
+        qDebug() << "内存映射: 数据不完整" << file.fileName();
+        return false;
+    }
+    pixels = mapped + pixelOffset;
+    return true;
+}
+
+int MappedImageFile::bytesPerPixel() const
+{
+    switch (layout) {
+    case Gray8:
+    case Indexed8:
+        return 1;
+    case Gray16:
+        return 2;
+    case Rgb8:
+    case Bgr8:
+        return 3;
+    case Rgb16:
+        return 6;
+    default:
+        return 4;
+    }
+}
+
+QImage::Format MappedImageFile::directFormat() const
+{
+    switch (layout) {
+    case Gray8:
+        return QImage::Format_Grayscale8;
+    case Gray16:
+        if (maxValue == 65535 && bigEndian16 == (Q_BYTE_ORDER == Q_BIG_ENDIAN)) {
+            return QImage::Format_Grayscale16;
+        }
+        return QImage::Format_Invalid;
+    case Rgb8:
+        return QImage::Format_RGB888;
+    case Bgr8:
+        return QImage::Format_BGR888;
+    case Bgra8:
+        return Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? QImage::Format_ARGB32 : QImage::Format_Invalid;
+    case Rgba8:
+        return QImage::Format_RGBA8888;
+    case Rgba8Premultiplied:
+        return QImage::Format_RGBA8888_Premultiplied;
+    case Indexed8:
+        return QImage::Format_Indexed8;
+    default:
+        return QImage::Format_Invalid;   // Rgb16 / Bgrx8 需要转换
+    }
+}
+
+QImage::Format MappedImageFile::convertedFormat() const
+{
+    switch (layout) {
+    case Gray16:
+        return QImage::Format_Grayscale16;
+    case Rgb16:
+        return QImage::Format_RGBX64;
+    case Bgrx8:
+        return QImage::Format_RGB32;
+    case Bgra8:
+        return QImage::Format_ARGB32;
+    default:
+        return directFormat();
+    }
+}
+
+quint16 MappedImageFile::sample16(const uchar *p) const
+{
+    const quint32 value = bigEndian16 ? (quint32(p[0]) << 8 | p[1]) : (quint32(p[1]) << 8 | p[0]);
+    return maxValue == 65535 ? quint16(value) : quint16(qMin<quint32>(value, maxValue) * 65535 / maxValue);
+}
+
+// 一行像素从文件布局转换为 convertedFormat()
+void MappedImageFile::convertRow(const uchar *src, int count, uchar *dst) const
+{
+    switch (layout) {
+    case Gray16: {
+        quint16 *out = reinterpret_cast<quint16 *>(dst);
+        for (int i = 0; i < count; ++i, src += 2) {
+            out[i] = sample16(src);
+        }
+        break;
+    }
+    case Rgb16: {
+        QRgba64 *out = reinterpret_cast<QRgba64 *>(dst);
+        for (int i = 0; i < count; ++i, src += 6) {
+            out[i] = QRgba64::fromRgba64(sample16(src), sample16(src + 2), sample16(src + 4), 65535);
+        }
+        break;
+    }
+    case Bgrx8: {
+        QRgb *out = reinterpret_cast<QRgb *>(dst);
+        for (int i = 0; i < count; ++i, src += 4) {
+            out[i] = qRgb(src[2], src[1], src[0]);
+        }
+        break;
+    }
+    case Bgra8: {
+        QRgb *out = reinterpret_cast<QRgb *>(dst);
+        for (int i = 0; i < count; ++i, src += 4) {
+            out[i] = qRgba(src[2], src[1], src[0], src[3]);
+        }
+        break;
+    }
+    default:
+        memcpy(dst, src, size_t(count) * bytesPerPixel());
+        break;
+    }
+}
+
+bool MappedImageFile::isZeroCopy() const
+{
+    if (bottomUp || directFormat() == QImage::Format_Invalid) {
+        return false;
+    }
+    // 16 / 32 位格式要求起始地址和行跨度按像素对齐
+    const int alignment = (layout == Gray16) ? 2 : (bytesPerPixel() == 4 ? 4 : 1);
+    return reinterpret_cast<quintptr>(pixels) % alignment == 0 && stride % alignment == 0;
+}
+
+QImage MappedImageFile::image() const
+{
+    if (!isZeroCopy()) {
+        return region(QRect(QPoint(0, 0), imageSize));
+    }
+
+    // 清理函数持有一份引用，映射随最后一个 QImage 一起释放
+    QSharedPointer<const MappedImageFile> *keepAlive =
+        new QSharedPointer<const MappedImageFile>(sharedFromThis());
+    QImage image(pixels, imageSize.width(), imageSize.height(), stride, directFormat(),
+                 [](void *info) { delete static_cast<QSharedPointer<const MappedImageFile> *>(info); },
+                 keepAlive);
+    if (image.isNull()) {
+        delete keepAlive;
+        return region(QRect(QPoint(0, 0), imageSize));
+    }
+    if (layout == Indexed8) {
+        image.setColorTable(colorTable);
+    }
+    return image;
+}
+
+QImage MappedImageFile::region(const QRect &rect) const
+{
+    const QRect clipped = rect.intersected(QRect(QPoint(0, 0), imageSize));
+    if (clipped.isEmpty()) {
+        return QImage();
+    }
+
+    QImage result = PixelBufferPool::shared().createImage(clipped.size(), convertedFormat());
+    if (result.isNull()) {
+        return QImage();
+    }
+    if (layout == Indexed8) {
+        result.setColorTable(colorTable);
+    }
+
+    const int bpp = bytesPerPixel();
+    uchar *bits = result.bits();
+    const qsizetype bytesPerLine = result.bytesPerLine();
+    for (int y = 0; y < clipped.height(); ++y) {
+        convertRow(rowData(clipped.y() + y) + qsizetype(clipped.x()) * bpp, clipped.width(),
+                   bits + y * bytesPerLine);
+    }
+    return result;
+}
+
+void MappedImageFile::readRow(int y, int x, int count, QRgb *out) const
+{
+    const uchar *src = rowData(y) + qsizetype(x) * bytesPerPixel();
+    switch (layout) {
+    case Gray8:
+        for (int i = 0; i < count; ++i) {
+            out[i] = qRgb(src[i], src[i], src[i]);
+        }
+        break;
+    case Gray16:
+        for (int i = 0; i < count; ++i, src += 2) {
+            const int v = sample16(src) >> 8;
+            out[i] = qRgb(v, v, v);
+        }
+        break;
+    case Rgb8:
+        for (int i = 0; i < count; ++i, src += 3) {
+            out[i] = qRgb(src[0], src[1], src[2]);
+        }
+        break;
+    case Rgb16:
+        for (int i = 0; i < count; ++i, src += 6) {
+            out[i] = qRgb(sample16(src) >> 8, sample16(src + 2) >> 8, sample16(src + 4) >> 8);
+        }
+        break;
+    case Bgr8:
+        for (int i = 0; i < count; ++i, src += 3) {
+            out[i] = qRgb(src[2], src[1], src[0]);
+        }
+        break;
+    case Bgrx8:
+        for (int i = 0; i < count; ++i, src += 4) {
+            out[i] = qRgb(src[2], src[1], src[0]);
+        }
+        break;
+    case Bgra8:
+        for (int i = 0; i < count; ++i, src += 4) {
+            out[i] = qPremultiply(qRgba(src[2], src[1], src[0], src[3]));
+        }
+        break;
+    case Rgba8:
+        for (int i = 0; i < count; ++i, src += 4) {
+            out[i] = qPremultiply(qRgba(src[0], src[1], src[2], src[3]));
+        }
+        break;
+    case Rgba8Premultiplied:
+        for (int i = 0; i < count; ++i, src += 4) {
+            out[i] = qRgba(src[0], src[1], src[2], src[3]);
+        }
+        break;
+    case Indexed8:
+        for (int i = 0; i < count; ++i) {
+            out[i] = qPremultiply(colorTable.at(src[i]));
+        }
+        break;
+    }
+}
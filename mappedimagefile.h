@@ -0,0 +1,89 @@
+// mappedimagefile.h
+#ifndef MAPPEDIMAGEFILE_H
+#define MAPPEDIMAGEFILE_H
+
+#include <QFile>
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include <QSharedPointer>
+#include <QEnableSharedFromThis>
+
+// 未压缩图片的内存映射读取（PPM/PGM、BMP、未压缩 TIFF）
+// 文件中的像素已经是 Qt 能直接绘制的布局时，image() 返回直接引用映射区的只读 QImage，
+// 不读取、不复制；映射在最后一个引用它的 QImage 销毁后才解除。
+// 自下而上存储的 BMP、16 位大端样本、不透明度无效的 32 位 BMP 等只在需要时逐行转换。
+// 超大文件由 RegionImageSource 按区域复制或逐行缩小，不会整张展开。
+// 注意：文件在映射期间被截断时访问映射区会触发 SIGBUS，与其他基于 mmap 的查看器相同。
+class MappedImageFile : public QEnableSharedFromThis<MappedImageFile>
+{
+public:
+    // 格式可识别且数据完整时返回实例，否则返回空指针（交给其他解码路径）
+    static QSharedPointer<MappedImageFile> open(const QString &filePath);
+    ~MappedImageFile();
+
+    QSize size() const { return imageSize; }
+    QString formatName() const { return name; }
+    // image() 是否直接引用映射区
+    bool isZeroCopy() const;
+
+    // 整张图片：能零拷贝时引用映射区，否则转换到像素缓冲池中的新图像
+    QImage image() const;
+    // 复制 rect 区域（按需转换格式），自下而上的文件在这里翻正
+    QImage region(const QRect &rect) const;
+    // 第 y 行从 x 开始的 count 个像素转换为预乘 ARGB32（用于逐行缩小）
+    void readRow(int y, int x, int count, QRgb *out) const;
+
+private:
+    enum Layout {
+        Gray8,
+        Gray16,         // 字节序见 bigEndian16，最大值见 maxValue
+        Rgb8,
+        Rgb16,
+        Bgr8,           // BMP 24 位
+        Bgrx8,          // BMP 32 位，第四字节无效
+        Bgra8,          // BMP 32 位带 Alpha 掩码
+        Rgba8,          // TIFF 非预乘 Alpha
+        Rgba8Premultiplied,
+        Indexed8
+    };
+
+    MappedImageFile(const QString &filePath);
+    Q_DISABLE_COPY(MappedImageFile)
+
+    bool map();
+    bool parsePnm();
+    bool parseBmp();
+    bool parseTiff();
+    bool finishLayout(qint64 pixelOffset);
+
+    // 可以直接引用映射区的格式，否则为 Format_Invalid
+    QImage::Format directFormat() const;
+    // 需要转换时的输出格式
+    QImage::Format convertedFormat() const;
+    int bytesPerPixel() const;
+    quint16 sample16(const uchar *p) const;
+    void convertRow(const uchar *src, int count, uchar *dst) const;
+
+    const uchar *rowData(int y) const
+    {
+        return pixels + qsizetype(bottomUp ? imageSize.height() - 1 - y : y) * stride;
+    }
+
+    QFile file;
+    const uchar *mapped;
+    qint64 mappedSize;
+    const uchar *pixels;    // 文件中存储的第一行
+    qsizetype stride;
+    bool bottomUp;
+    bool bigEndian16;
+    int maxValue;
+    QSize imageSize;
+    Layout layout;
+    QVector<QRgb> colorTable;
+    QString name;
+};
+
+#endif // MAPPEDIMAGEFILE_H
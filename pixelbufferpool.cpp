@@ -0,0 +1,162 @@
+// pixelbufferpool.cpp
+#include "pixelbufferpool.h"
+#include <QMutexLocker>
+#include <QDebug>
+
+namespace {
+
+// 缓存行对齐，SIMD 缩放内核按行读取时不会跨行拆分
+const size_t kBufferAlignment = 64;
+
+} // namespace
+
+PixelBufferPool::PixelBufferPool()
+    : limit(kDefaultIdleLimit)
+{
+}
+
+// 有意不析构：静态对象析构阶段仍可能有缓存中的图像归还缓冲
+PixelBufferPool &PixelBufferPool::shared()
+{
+    static PixelBufferPool *pool = new PixelBufferPool;
+    return *pool;
+}
+
+qint64 PixelBufferPool::capacityFor(qint64 bytes)
+{
+    int shift = 0;
+    while ((qint64(1) << (shift + 1)) <= bytes) {
+        ++shift;
+    }
+    const qint64 base = qint64(1) << shift;
+    if (base == bytes) {
+        return bytes;
+    }
+    const qint64 step = base / 4;
+    return base + (bytes - base + step - 1) / step * step;
+}
+
+QImage PixelBufferPool::createImage(const QSize &size, QImage::Format format)
+{
+    if (size.isEmpty() || format == QImage::Format_Invalid) {
+        return QImage();
+    }
+
+    const int depth = QImage::toPixelFormat(format).bitsPerPixel();
+    const qsizetype bytesPerLine = ((qsizetype(size.width()) * depth + 31) / 32) * 4;
+    const qint64 bytes = qint64(bytesPerLine) * size.height();
+    if (bytes < kMinPooledBytes) {
+        return QImage(size, format);
+    }
+
+    const qint64 capacity = capacityFor(bytes);
+    Buffer *buffer = nullptr;
+    {
+        QMutexLocker locker(&mutex);
+        auto it = idleBuffers.find(capacity);
+        if (it != idleBuffers.end() && !it->isEmpty()) {
+            buffer = it->takeLast();
+            counters.idleBytes -= capacity;
+            ++counters.hits;
+            counters.bytesRecycled += capacity;
+        } else {
+            ++counters.misses;
+            counters.bytesAllocated += capacity;
+        }
+        counters.liveBytes += capacity;
+    }
+
+    if (!buffer) {
+        uchar *data = static_cast<uchar *>(qMallocAligned(size_t(capacity), kBufferAlignment));
+        if (!data) {
+            QMutexLocker locker(&mutex);
+            counters.liveBytes -= capacity;
+            qWarning() << "PixelBufferPool: 无法分配" << capacity / (1024 * 1024) << "MB";
+            return QImage();
+        }
+        buffer = new Buffer{data, capacity};
+    }
+
+    QImage image(buffer->data, size.width(), size.height(), bytesPerLine, format,
+                 &PixelBufferPool::releaseBuffer, buffer);
+    if (image.isNull()) {
+        release(buffer);
+    }
+    return image;
+}
+
+void PixelBufferPool::releaseBuffer(void *info)
+{
+    shared().release(static_cast<Buffer *>(info));
+}
+
+void PixelBufferPool::release(Buffer *buffer)
+{
+    QMutexLocker locker(&mutex);
+    counters.liveBytes -= buffer->capacity;
+    if (counters.idleBytes + buffer->capacity > limit) {
+        trimLocked(limit - buffer->capacity);
+    }
+    if (counters.idleBytes + buffer->capacity > limit) {
+        qFreeAligned(buffer->data);
+        delete buffer;
+        return;
+    }
+    idleBuffers[buffer->capacity].append(buffer);
+    counters.idleBytes += buffer->capacity;
+}
+
+// 从最大的容量级开始释放，直到空闲总量不超过 target
+void PixelBufferPool::trimLocked(qint64 target)
+{
+    while (counters.idleBytes > qMax<qint64>(0, target)) {
+        qint64 largest = -1;
+        for (auto it = idleBuffers.cbegin(); it != idleBuffers.cend(); ++it) {
+            if (!it->isEmpty() && it.key() > largest) {
+                largest = it.key();
+            }
+        }
+        if (largest < 0) {
+            break;
+        }
+        Buffer *buffer = idleBuffers[largest].takeFirst();
+        counters.idleBytes -= buffer->capacity;
+        qFreeAligned(buffer->data);
+        delete buffer;
+    }
+}
+
+void PixelBufferPool::trim()
+{
+    QMutexLocker locker(&mutex);
+    trimLocked(0);
+    idleBuffers.clear();
+}
+
+void PixelBufferPool::setIdleLimit(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    limit = qMax<qint64>(0, bytes);
+    trimLocked(limit);
+}
+
+qint64 PixelBufferPool::idleLimit() const
+{
+    QMutexLocker locker(&mutex);
+    return limit;
+}
+
+PixelBufferPool::Stats PixelBufferPool::stats() const
+{
+    QMutexLocker locker(&mutex);
+    return counters;
+}
+
+void PixelBufferPool::resetStats()
+{
+    QMutexLocker locker(&mutex);
+    counters.hits = 0;
+    counters.misses = 0;
+    counters.bytesRecycled = 0;
+    counters.bytesAllocated = 0;
+}
@@ -0,0 +1,68 @@
+// pixelbufferpool.h
+#ifndef PIXELBUFFERPOOL_H
+#define PIXELBUFFERPOOL_H
+
+#include <QImage>
+#include <QSize>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+
+// 按尺寸分级的像素缓冲池
+// 解码、缩放和旋转的输出图像构造在池中的内存上，QImage 销毁时通过清理函数把缓冲放回池中，
+// 下一张图片直接复用，稳定浏览时几乎不再 malloc/mmap，也不会每张图都重新触发缺页。
+// 每级容量为 2^k 的 1、1.25、1.5、1.75 倍，浪费不超过 25%；小于 kMinPooledBytes 的图像不入池。
+// 空闲缓冲总量超过上限时直接释放。线程安全。
+class PixelBufferPool
+{
+public:
+    struct Stats {
+        quint64 hits = 0;            // 从空闲缓冲取得
+        quint64 misses = 0;          // 新分配
+        qint64 bytesRecycled = 0;    // 复用的累计字节数
+        qint64 bytesAllocated = 0;   // 新分配的累计字节数
+        qint64 idleBytes = 0;        // 当前空闲缓冲
+        qint64 liveBytes = 0;        // 当前被图像使用的缓冲
+    };
+
+    static PixelBufferPool &shared();
+
+    // 分配图像（内容未初始化），失败时返回空图
+    QImage createImage(const QSize &size, QImage::Format format);
+    QImage createImage(int width, int height, QImage::Format format)
+    {
+        return createImage(QSize(width, height), format);
+    }
+
+    // 释放全部空闲缓冲
+    void trim();
+    void setIdleLimit(qint64 bytes);
+    qint64 idleLimit() const;
+
+    Stats stats() const;
+    void resetStats();
+
+    static constexpr qint64 kMinPooledBytes = 256 * 1024;
+    static constexpr qint64 kDefaultIdleLimit = 256LL * 1024 * 1024;
+
+private:
+    struct Buffer {
+        uchar *data;
+        qint64 capacity;
+    };
+
+    PixelBufferPool();
+    Q_DISABLE_COPY(PixelBufferPool)
+
+    static qint64 capacityFor(qint64 bytes);
+    static void releaseBuffer(void *info);
+    void release(Buffer *buffer);
+    void trimLocked(qint64 limit);
+
+    mutable QMutex mutex;
+    QHash<qint64, QVector<Buffer *>> idleBuffers;   // 容量 → 空闲缓冲（后进先出）
+    qint64 limit;
+    Stats counters;
+};
+
+#endif // PIXELBUFFERPOOL_H
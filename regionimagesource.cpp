@@ -0,0 +1,322 @@
+// regionimagesource.cpp
+#include "regionimagesource.h"
+#include "scanlinedownsampler.h"
+#include "imageresampler.h"
+#include "imagecodecs.h"
+#include "mappedimagefile.h"
+#include <QImageReader>
+#include <QFile>
+#include <QFileInfo>
+#include <QPainter>
+#include <QDebug>
+#include <vector>
+
+#ifdef HAVE_LIBTIFF
+#include <tiffio.h>
+#endif
+
+RegionImageSource::RegionImageSource(const QString &filePath, const QSize &size, Backend backend)
+    :
+#ifdef HAVE_LIBTIFF
+      tiff(nullptr),
+#endif
+      path(filePath),
+      imageSize(size),
+      backend(backend),
+      regionDecoding(backend != StreamOnly)
+{
+}
+
+RegionImageSource::~RegionImageSource()
+{
+#ifdef HAVE_LIBTIFF
+    if (tiff) {
+        TIFFClose(tiff);
+    }
+#endif
+}
+
+QSharedPointer<RegionImageSource> RegionImageSource::open(const QString &filePath)
+{
+    // 未压缩格式：像素直接从映射区读取，小图由 decodeImageFile 零拷贝显示
+    if (QSharedPointer<MappedImageFile> mappedFile = MappedImageFile::open(filePath)) {
+        const QSize size = mappedFile->size();
+        if (static_cast<qint64>(size.width()) * size.height() < kRegionModePixels) {
+            return QSharedPointer<RegionImageSource>();
+        }
+        QSharedPointer<RegionImageSource> source(new RegionImageSource(filePath, size, MappedPixels));
+        source->mapped = mappedFile;
+        qDebug() << "区域解码模式 (内存映射):" << filePath << size << mappedFile->formatName();
+        return source;
+    }
+
+#ifdef HAVE_LIBTIFF
+    QString suffix = QFileInfo(filePath).suffix().toLower();
+    if (suffix == "tif" || suffix == "tiff") {
+        TIFF *handle = TIFFOpen(QFile::encodeName(filePath).constData(), "r");
+        if (handle) {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            TIFFGetField(handle, TIFFTAG_IMAGEWIDTH, &width);
+            TIFFGetField(handle, TIFFTAG_IMAGELENGTH, &height);
+            if (static_cast<qint64>(width) * height >= kRegionModePixels) {
+                QSharedPointer<RegionImageSource> source(
+                    new RegionImageSource(filePath, QSize(width, height), TiffTiles));
+                source->tiff = handle;
+
+                // 条带过大时读取一块区域需要解码整个条带，只使用流式预览
+                if (!TIFFIsTiled(handle)) {
+                    uint32_t rowsPerStrip = 0;
+                    TIFFGetFieldDefaulted(handle, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
+                    rowsPerStrip = qMin(rowsPerStrip, height);
+                    source->regionDecoding = static_cast<qint64>(width) * rowsPerStrip * 4 <= kMaxStripBytes;
+                }
+                qDebug() << "区域解码模式 (libtiff):" << filePath << source->size()
+                         << (TIFFIsTiled(handle) ? "分块" : "条带")
+                         << (source->regionDecoding ? "" : "仅预览");
+                return source;
+            }
+            TIFFClose(handle);
+            return QSharedPointer<RegionImageSource>();
+        }
+    }
+#endif
+
+    QImageReader reader(filePath);
+    QSize size = reader.size();
+    if (!size.isValid() || static_cast<qint64>(size.width()) * size.height() < kRegionModePixels) {
+        return QSharedPointer<RegionImageSource>();
+    }
+
+    // 不支持的格式 QImageReader 会先解码整张图片再裁剪，不能用于区域解码；
+    // 能逐行读取的格式仍可以流式生成预览图
+    if (!reader.supportsOption(QImageIOHandler::ClipRect) ||
+        !reader.supportsOption(QImageIOHandler::ScaledSize)) {
+        if (ScanlineDownsampler::canStream(filePath)) {
+            qDebug() << "流式预览模式:" << filePath << size << reader.format();
+            return QSharedPointer<RegionImageSource>(new RegionImageSource(filePath, size, StreamOnly));
+        }
+        qDebug() << "格式不支持区域解码:" << reader.format() << size;
+        return QSharedPointer<RegionImageSource>();
+    }
+
+    qDebug() << "区域解码模式 (QImageReader):" << filePath << size << reader.format();
+    return QSharedPointer<RegionImageSource>(new RegionImageSource(filePath, size, QtReader));
+}
+
+QString RegionImageSource::backendName() const
+{
+    switch (backend) {
+    case TiffTiles:
+        return QStringLiteral("libtiff");
+    case StreamOnly:
+        return QStringLiteral("scanline");
+    case MappedPixels:
+        return QStringLiteral("mmap");
+    default:
+        return QStringLiteral("QImageReader");
+    }
+}
+
+QSize RegionImageSource::levelSize(const QSize &original, int level)
+{
+    QSize size = original;
+    for (int i = 0; i < level; ++i) {
+        size = QSize((size.width() + 1) / 2, (size.height() + 1) / 2);
+    }
+    return size;
+}
+
+int RegionImageSource::overviewLevel() const
+{
+    int level = 0;
+    QSize size = imageSize;
+    while (size.width() > kOverviewSize || size.height() > kOverviewSize) {
+        size = levelSize(size, 1);
+        ++level;
+    }
+    return level;
+}
+
+QSize RegionImageSource::overviewSize() const
+{
+    return levelSize(imageSize, overviewLevel());
+}
+
+QImage RegionImageSource::overview() const
+{
+    return downsampled(overviewSize());
+}
+
+QImage RegionImageSource::downsampled(const QSize &outputSize) const
+{
+    if (outputSize.isEmpty()) {
+        return QImage();
+    }
+
+    if (backend == MappedPixels) {
+        return decodeMappedRegion(QRect(QPoint(0, 0), imageSize), outputSize);
+    }
+
+    // PNG / TIFF 逐行读取并做盒式滤波；JPEG 由解码器按比例缩小（DCT 缩放）
+    if (backend != QtReader) {
+        QImage image = ScanlineDownsampler::downsampleFile(path, outputSize);
+        if (!image.isNull() || !regionDecoding) {
+            return image;
+        }
+    }
+
+    // 启用 TurboJPEG 时直接按 DCT 比例解码整张图，带重启标记的扫描件按段多核并行
+    if (ImageCodecs::backendFor(QFileInfo(path).suffix().toLatin1()) == ImageCodecs::TurboJpeg) {
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly)) {
+            QImage image = ImageCodecs::decodeWith(ImageCodecs::TurboJpeg, file.readAll(), "jpeg", outputSize);
+            if (!image.isNull()) {
+                if (image.size() != outputSize) {
+                    image = ImageResampler::scaled(image, outputSize,
+                                                   ImageResampler::defaultFilter(image.size(), outputSize));
+                }
+                return image;
+            }
+        }
+    }
+    return decodeRegion(QRect(QPoint(0, 0), imageSize), outputSize);
+}
+
+QImage RegionImageSource::decodeRegion(const QRect &rect, const QSize &outputSize) const
+{
+    QRect clipped = rect.intersected(QRect(QPoint(0, 0), imageSize));
+    if (!regionDecoding || clipped.isEmpty() || outputSize.isEmpty()) {
+        return QImage();
+    }
+
+#ifdef HAVE_LIBTIFF
+    if (backend == TiffTiles) {
+        return decodeTiffRegion(clipped, outputSize);
+    }
+#endif
+    if (backend == MappedPixels) {
+        return decodeMappedRegion(clipped, outputSize);
+    }
+    return decodeWithReader(clipped, outputSize);
+}
+
+// 缩小一半以上时逐行盒式滤波，内存只与输出尺寸成正比；否则复制区域后重采样
+QImage RegionImageSource::decodeMappedRegion(const QRect &rect, const QSize &outputSize) const
+{
+    if (outputSize.width() * 2 <= rect.width() && outputSize.height() * 2 <= rect.height()) {
+        ScanlineDownsampler sampler(rect.size(), outputSize);
+        std::vector<QRgb> row(rect.width());
+        for (int y = 0; y < rect.height(); ++y) {
+            mapped->readRow(rect.y() + y, rect.x(), rect.width(), row.data());
+            sampler.addRow(y, row.data());
+        }
+        return sampler.result();
+    }
+
+    QImage image = mapped->region(rect);
+    if (!image.isNull() && image.size() != outputSize) {
+        image = ImageResampler::scaled(image, outputSize, ImageResampler::defaultFilter(image.size(), outputSize));
+    }
+    return image;
+}
+
+QImage RegionImageSource::decodeWithReader(const QRect &rect, const QSize &outputSize) const
+{
+    // 每次使用独立的 reader，可以在多个线程中同时解码不同区域
+    QImageReader reader(path);
+    reader.setAutoTransform(false);
+    reader.setClipRect(rect);
+    reader.setScaledSize(outputSize);
+
+    QImage image;
+    if (!reader.read(&image)) {
+        qWarning() << "区域解码失败:" << path << rect << reader.errorString();
+        return QImage();
+    }
+    if (image.size() != outputSize) {
+        image = ImageResampler::scaled(image, outputSize,
+                                       ImageResampler::defaultFilter(image.size(), outputSize));
+    }
+    return image;
+}
+
+#ifdef HAVE_LIBTIFF
+// 逐个读取与区域相交的瓦片（或条带），每块单独缩小后绘制到输出图上，
+// 峰值内存为输出图加一个瓦片，与区域大小无关
+QImage RegionImageSource::decodeTiffRegion(const QRect &rect, const QSize &outputSize) const
+{
+    QMutexLocker locker(&tiffMutex);
+
+    const bool tiled = TIFFIsTiled(tiff);
+    uint32_t blockWidth = static_cast<uint32_t>(imageSize.width());
+    uint32_t blockHeight = 0;
+    if (tiled) {
+        TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &blockWidth);
+        TIFFGetField(tiff, TIFFTAG_TILELENGTH, &blockHeight);
+    } else {
+        TIFFGetFieldDefaulted(tiff, TIFFTAG_ROWSPERSTRIP, &blockHeight);
+        blockHeight = qMin<uint32_t>(blockHeight, static_cast<uint32_t>(imageSize.height()));
+    }
+    if (blockWidth == 0 || blockHeight == 0) {
+        return QImage();
+    }
+
+    std::vector<uint32_t> raster(static_cast<size_t>(blockWidth) * blockHeight);
+
+    QImage output(outputSize, QImage::Format_ARGB32_Premultiplied);
+    output.fill(Qt::transparent);
+    QPainter painter(&output);
+
+    const double scaleX = static_cast<double>(outputSize.width()) / rect.width();
+    const double scaleY = static_cast<double>(outputSize.height()) / rect.height();
+    // 输出边界统一取整，避免块之间出现缝隙
+    auto outX = [&](int x) { return qRound((x - rect.x()) * scaleX); };
+    auto outY = [&](int y) { return qRound((y - rect.y()) * scaleY); };
+
+    const int firstBlockY = rect.top() / blockHeight * blockHeight;
+    const int firstBlockX = tiled ? rect.left() / blockWidth * blockWidth : 0;
+
+    for (int blockY = firstBlockY; blockY <= rect.bottom(); blockY += blockHeight) {
+        const int rowsInBlock = tiled ? static_cast<int>(blockHeight)
+                                      : qMin<int>(blockHeight, imageSize.height() - blockY);
+
+        for (int blockX = firstBlockX; blockX <= rect.right(); blockX += blockWidth) {
+            int ok = tiled ? TIFFReadRGBATile(tiff, blockX, blockY, raster.data())
+                           : TIFFReadRGBAStrip(tiff, blockY, raster.data());
+            if (!ok) {
+                qWarning() << "TIFF 块读取失败:" << path << blockX << blockY;
+                continue;
+            }
+
+            QRect blockRect(blockX, blockY, blockWidth, rowsInBlock);
+            QRect part = blockRect.intersected(rect);
+
+            // libtiff 的 RGBA 栅格自下而上存放，像素为预乘的 ABGR 打包值
+            QImage partImage(part.size(), QImage::Format_ARGB32_Premultiplied);
+            for (int y = 0; y < part.height(); ++y) {
+                int rasterRow = rowsInBlock - 1 - (part.y() + y - blockY);
+                const uint32_t *src = raster.data() + static_cast<size_t>(rasterRow) * blockWidth +
+                                      (part.x() - blockX);
+                QRgb *dst = reinterpret_cast<QRgb *>(partImage.scanLine(y));
+                for (int x = 0; x < part.width(); ++x) {
+                    uint32_t pixel = src[x];
+                    dst[x] = qRgba(TIFFGetR(pixel), TIFFGetG(pixel), TIFFGetB(pixel), TIFFGetA(pixel));
+                }
+            }
+
+            QRect target(QPoint(outX(part.left()), outY(part.top())),
+                         QPoint(outX(part.right() + 1) - 1, outY(part.bottom() + 1) - 1));
+            if (target.isEmpty()) {
+                continue;
+            }
+            painter.drawImage(target.topLeft(),
+                              ImageResampler::scaled(partImage, target.size(),
+                                                     ImageResampler::defaultFilter(part.size(), target.size())));
+        }
+    }
+
+    painter.end();
+    return output;
+}
+#endif
@@ -0,0 +1,86 @@
+// regionimagesource.h
+#ifndef REGIONIMAGESOURCE_H
+#define REGIONIMAGESOURCE_H
+
+#include <QString>
+#include <QSize>
+#include <QRect>
+#include <QImage>
+#include <QMutex>
+#include <QSharedPointer>
+
+class MappedImageFile;
+
+#ifdef HAVE_LIBTIFF
+typedef struct tiff TIFF;
+#endif
+
+// 超大图片的区域解码
+// 只常驻一张缩小的预览图，原分辨率的细节按视口需要逐块解码：
+// JPEG 等支持 ClipRect/ScaledSize 的格式通过 QImageReader 解码指定区域，
+// TIFF（启用 libtiff 时）只读取与区域相交的瓦片或条带。
+// 未压缩的 PPM/PGM、BMP、TIFF 通过内存映射直接复制区域或逐行缩小，不经过解码器。
+// 无法按区域解码的 PNG 和大条带 TIFF 只提供流式缩小得到的预览图。
+class RegionImageSource
+{
+public:
+    // 超过该像素数（约 256MB ARGB32）的图片使用区域解码
+    static constexpr qint64 kRegionModePixels = 64LL * 1024 * 1024;
+    // 预览图最长边上限
+    static constexpr int kOverviewSize = 4096;
+    // 条带 TIFF 按区域解码时单个条带 RGBA 栅格的上限
+    static constexpr qint64 kMaxStripBytes = 64LL * 1024 * 1024;
+
+    ~RegionImageSource();
+
+    // 图片足够大且格式支持按区域解码时返回实例，否则返回空指针
+    static QSharedPointer<RegionImageSource> open(const QString &filePath);
+
+    QString filePath() const { return path; }
+    QSize size() const { return imageSize; }
+    QString backendName() const;
+    // 是否可以按区域解码原分辨率细节；否则只有预览图
+    bool supportsRegions() const { return regionDecoding; }
+
+    // 预览图所在的金字塔级（每级宽高减半）及其尺寸
+    int overviewLevel() const;
+    QSize overviewSize() const;
+    QImage overview() const;
+
+    // 整张图片缩小到 outputSize，内存与输出尺寸成正比（用于预览图和缩略图）
+    QImage downsampled(const QSize &outputSize) const;
+
+    // 解码原图中的 rect 区域并缩放到 outputSize（线程安全）
+    QImage decodeRegion(const QRect &rect, const QSize &outputSize) const;
+
+    // 与 TiledImageRenderer 一致的金字塔级尺寸
+    static QSize levelSize(const QSize &original, int level);
+
+private:
+    enum Backend {
+        QtReader,       // QImageReader::setClipRect + setScaledSize
+        TiffTiles,      // libtiff 按瓦片/条带读取
+        StreamOnly,     // 只能逐行读取（ScanlineDownsampler）
+        MappedPixels    // 内存映射的未压缩像素（MappedImageFile）
+    };
+
+    RegionImageSource(const QString &filePath, const QSize &size, Backend backend);
+
+    QImage decodeWithReader(const QRect &rect, const QSize &outputSize) const;
+    QImage decodeMappedRegion(const QRect &rect, const QSize &outputSize) const;
+#ifdef HAVE_LIBTIFF
+    QImage decodeTiffRegion(const QRect &rect, const QSize &outputSize) const;
+
+    TIFF *tiff;
+    mutable QMutex tiffMutex;   // libtiff 句柄不是线程安全的
+#endif
+
+    QSharedPointer<MappedImageFile> mapped;
+
+    QString path;
+    QSize imageSize;
+    Backend backend;
+    bool regionDecoding;
+};
+
+#endif // REGIONIMAGESOURCE_H
@@ -0,0 +1,372 @@
+// scanlinedownsampler.cpp
+#include "scanlinedownsampler.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QScopedPointer>
+#include <QDebug>
+#include <vector>
+
+#ifdef HAVE_LIBPNG
+#include <png.h>
+#endif
+
+#ifdef HAVE_LIBTIFF
+#include <tiffio.h>
+#endif
+
+ScanlineDownsampler::ScanlineDownsampler(const QSize &inputSize, const QSize &outputSize)
+    : inputSize(inputSize),
+      outputSize(outputSize.boundedTo(inputSize)),
+      nextFlushRow(0)
+{
+    if (this->inputSize.isEmpty() || this->outputSize.isEmpty()) {
+        return;
+    }
+
+    const qint64 inWidth = this->inputSize.width();
+    const qint64 outWidth = this->outputSize.width();
+    columnMap.resize(this->inputSize.width());
+    columnCount.fill(0, this->outputSize.width());
+    for (int x = 0; x < this->inputSize.width(); ++x) {
+        int column = static_cast<int>(x * outWidth / inWidth);
+        columnMap[x] = column;
+        ++columnCount[column];
+    }
+
+    output = QImage(this->outputSize, QImage::Format_ARGB32_Premultiplied);
+    output.fill(Qt::transparent);
+}
+
+// 输出行 outputRow 对应的第一个输入行
+int ScanlineDownsampler::firstInputRow(int outputRow) const
+{
+    const qint64 inHeight = inputSize.height();
+    const qint64 outHeight = outputSize.height();
+    return static_cast<int>((outputRow * inHeight + outHeight - 1) / outHeight);
+}
+
+void ScanlineDownsampler::addSpan(int y, int x, int count, const QRgb *pixels)
+{
+    if (output.isNull() || y < 0 || y >= inputSize.height()) {
+        return;
+    }
+
+    const int row = static_cast<int>(static_cast<qint64>(y) * outputSize.height() / inputSize.height());
+    QVector<quint64> &sums = openRows[row];
+    if (sums.isEmpty()) {
+        sums.fill(0, outputSize.width() * 4);
+    }
+
+    quint64 *data = sums.data();
+    const int end = qMin(x + count, inputSize.width());
+    for (int i = qMax(0, x); i < end; ++i) {
+        const QRgb pixel = pixels[i - x];
+        quint64 *target = data + columnMap[i] * 4;
+        target[0] += qAlpha(pixel);
+        target[1] += qRed(pixel);
+        target[2] += qGreen(pixel);
+        target[3] += qBlue(pixel);
+    }
+}
+
+void ScanlineDownsampler::finishRows(int rowsDone)
+{
+    while (nextFlushRow < outputSize.height() && firstInputRow(nextFlushRow + 1) <= rowsDone) {
+        flushRow(nextFlushRow);
+        ++nextFlushRow;
+    }
+}
+
+void ScanlineDownsampler::addRow(int y, const QRgb *pixels)
+{
+    addSpan(y, 0, inputSize.width(), pixels);
+    finishRows(y + 1);
+}
+
+void ScanlineDownsampler::flushRow(int outputRow)
+{
+    QVector<quint64> sums = openRows.take(outputRow);
+    if (sums.isEmpty()) {
+        return;
+    }
+
+    const quint64 rowCount = firstInputRow(outputRow + 1) - firstInputRow(outputRow);
+    QRgb *line = reinterpret_cast<QRgb *>(output.scanLine(outputRow));
+    const quint64 *data = sums.constData();
+    for (int column = 0; column < outputSize.width(); ++column) {
+        const quint64 count = rowCount * columnCount[column];
+        const quint64 half = count / 2;
+        const quint64 *pixel = data + column * 4;
+        line[column] = qRgba(static_cast<int>((pixel[1] + half) / count),
+                             static_cast<int>((pixel[2] + half) / count),
+                             static_cast<int>((pixel[3] + half) / count),
+                             static_cast<int>((pixel[0] + half) / count));
+    }
+}
+
+namespace {
+
+#ifdef HAVE_LIBPNG
+// PNG 文件头中的隔行扫描标志（IHDR 固定位于签名之后）
+bool isInterlacedPng(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return true;
+    }
+    QByteArray header = file.read(29);
+    if (header.size() < 29 || !header.startsWith("\x89PNG\r\n\x1a\n") || header.mid(12, 4) != "IHDR") {
+        return true;
+    }
+    return header.at(28) != 0;
+}
+
+// setjmp 之后修改的状态都放在这里，只通过 png_get_io_ptr 取得的指针访问：
+// png_error 跳回时它们的值仍然有效，可以正常析构
+struct PngStreamState {
+    QFile file;
+    std::vector<png_byte> row;
+    std::vector<QRgb> pixels;
+    QScopedPointer<ScanlineDownsampler> sampler;
+};
+
+void pngReadCallback(png_structp png, png_bytep data, png_size_t length)
+{
+    PngStreamState *state = static_cast<PngStreamState *>(png_get_io_ptr(png));
+    if (state->file.read(reinterpret_cast<char *>(data), static_cast<qint64>(length)) != static_cast<qint64>(length)) {
+        png_error(png, "read error");
+    }
+}
+
+QImage streamPng(const QString &filePath, const QSize &outputSize)
+{
+    PngStreamState streamState;
+    streamState.file.setFileName(filePath);
+    if (!streamState.file.open(QIODevice::ReadOnly)) {
+        return QImage();
+    }
+
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    if (!png) {
+        return QImage();
+    }
+    png_infop info = png_create_info_struct(png);
+    if (!info) {
+        png_destroy_read_struct(&png, nullptr, nullptr);
+        return QImage();
+    }
+
+    png_set_read_fn(png, &streamState, pngReadCallback);
+
+    if (setjmp(png_jmpbuf(png))) {
+        qWarning() << "PNG 流式读取失败:" << filePath;
+        png_destroy_read_struct(&png, &info, nullptr);
+        return QImage();
+    }
+
+    PngStreamState *state = static_cast<PngStreamState *>(png_get_io_ptr(png));
+    png_read_info(png, info);
+
+    const png_uint_32 width = png_get_image_width(png, info);
+    const png_uint_32 height = png_get_image_height(png, info);
+    const int colorType = png_get_color_type(png, info);
+
+    if (png_get_interlace_type(png, info) != PNG_INTERLACE_NONE) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        return QImage();
+    }
+
+    // 统一转换为 8 位 RGBA
+    png_set_expand(png);
+    png_set_strip_16(png);
+    if (colorType == PNG_COLOR_TYPE_GRAY || colorType == PNG_COLOR_TYPE_GRAY_ALPHA) {
+        png_set_gray_to_rgb(png);
+    }
+    png_set_filler(png, 0xff, PNG_FILLER_AFTER);
+    png_read_update_info(png, info);
+
+    state->row.resize(png_get_rowbytes(png, info));
+    state->pixels.resize(width);
+    state->sampler.reset(new ScanlineDownsampler(QSize(width, height), outputSize));
+
+    for (png_uint_32 y = 0; y < height; ++y) {
+        png_read_row(png, state->row.data(), nullptr);
+        const png_byte *src = state->row.data();
+        for (png_uint_32 x = 0; x < width; ++x, src += 4) {
+            state->pixels[x] = qPremultiply(qRgba(src[0], src[1], src[2], src[3]));
+        }
+        state->sampler->addRow(static_cast<int>(y), state->pixels.data());
+    }
+
+    png_destroy_read_struct(&png, &info, nullptr);
+    return state->sampler->result();
+}
+#endif
+
+#ifdef HAVE_LIBTIFF
+// 无法逐行读取时，单个条带 RGBA 栅格的上限
+const qint64 kMaxStripBytes = 256LL * 1024 * 1024;
+
+// 8 位、像素交错的 RGB(A) 或灰度条带 TIFF 可以逐行读取，与条带大小无关
+bool tiffSupportsScanlines(TIFF *tiff)
+{
+    uint16_t bitsPerSample = 0;
+    uint16_t samplesPerPixel = 0;
+    uint16_t planarConfig = 0;
+    uint16_t photometric = 0;
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_BITSPERSAMPLE, &bitsPerSample);
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLESPERPIXEL, &samplesPerPixel);
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_PLANARCONFIG, &planarConfig);
+    if (!TIFFGetField(tiff, TIFFTAG_PHOTOMETRIC, &photometric)) {
+        return false;
+    }
+    if (bitsPerSample != 8 || planarConfig != PLANARCONFIG_CONTIG) {
+        return false;
+    }
+    return (photometric == PHOTOMETRIC_RGB && samplesPerPixel >= 3) ||
+           (photometric == PHOTOMETRIC_MINISBLACK && samplesPerPixel >= 1);
+}
+
+QImage streamTiff(const QString &filePath, const QSize &outputSize)
+{
+    TIFF *tiff = TIFFOpen(QFile::encodeName(filePath).constData(), "r");
+    if (!tiff) {
+        return QImage();
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &height);
+    ScanlineDownsampler sampler(QSize(width, height), outputSize);
+    std::vector<QRgb> pixels;
+    bool ok = true;
+
+    if (TIFFIsTiled(tiff)) {
+        // 逐行瓦片读取，libtiff 的 RGBA 栅格自下而上存放
+        uint32_t tileWidth = 0;
+        uint32_t tileHeight = 0;
+        TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &tileWidth);
+        TIFFGetField(tiff, TIFFTAG_TILELENGTH, &tileHeight);
+        std::vector<uint32_t> raster(static_cast<size_t>(tileWidth) * tileHeight);
+        pixels.resize(tileWidth);
+
+        for (uint32_t tileY = 0; ok && tileY < height; tileY += tileHeight) {
+            const uint32_t rows = qMin(tileHeight, height - tileY);
+            for (uint32_t tileX = 0; tileX < width; tileX += tileWidth) {
+                if (!TIFFReadRGBATile(tiff, tileX, tileY, raster.data())) {
+                    ok = false;
+                    break;
+                }
+                const uint32_t columns = qMin(tileWidth, width - tileX);
+                for (uint32_t y = 0; y < rows; ++y) {
+                    const uint32_t *src = raster.data() + static_cast<size_t>(tileHeight - 1 - y) * tileWidth;
+                    for (uint32_t x = 0; x < columns; ++x) {
+                        pixels[x] = qRgba(TIFFGetR(src[x]), TIFFGetG(src[x]), TIFFGetB(src[x]), TIFFGetA(src[x]));
+                    }
+                    sampler.addSpan(tileY + y, tileX, columns, pixels.data());
+                }
+            }
+            sampler.finishRows(tileY + rows);
+        }
+    } else if (tiffSupportsScanlines(tiff)) {
+        uint16_t samplesPerPixel = 1;
+        uint16_t photometric = 0;
+        TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLESPERPIXEL, &samplesPerPixel);
+        TIFFGetField(tiff, TIFFTAG_PHOTOMETRIC, &photometric);
+        const bool hasAlpha = (photometric == PHOTOMETRIC_RGB) ? samplesPerPixel >= 4 : samplesPerPixel >= 2;
+
+        std::vector<uint8_t> line(TIFFScanlineSize(tiff));
+        pixels.resize(width);
+        for (uint32_t y = 0; y < height; ++y) {
+            if (TIFFReadScanline(tiff, line.data(), y, 0) < 0) {
+                ok = false;
+                break;
+            }
+            const uint8_t *src = line.data();
+            for (uint32_t x = 0; x < width; ++x, src += samplesPerPixel) {
+                QRgb pixel = (photometric == PHOTOMETRIC_RGB)
+                                 ? qRgba(src[0], src[1], src[2], hasAlpha ? src[3] : 0xff)
+                                 : qRgba(src[0], src[0], src[0], hasAlpha ? src[1] : 0xff);
+                pixels[x] = qPremultiply(pixel);
+            }
+            sampler.addRow(y, pixels.data());
+        }
+    } else {
+        // 其他格式按条带读取 RGBA
+        uint32_t rowsPerStrip = 0;
+        TIFFGetFieldDefaulted(tiff, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
+        rowsPerStrip = qMin(rowsPerStrip, height);
+        if (static_cast<qint64>(width) * rowsPerStrip * 4 > kMaxStripBytes) {
+            qWarning() << "TIFF 条带过大，无法流式读取:" << filePath << rowsPerStrip << "行/条带";
+            TIFFClose(tiff);
+            return QImage();
+        }
+        std::vector<uint32_t> raster(static_cast<size_t>(width) * rowsPerStrip);
+        pixels.resize(width);
+
+        for (uint32_t stripY = 0; ok && stripY < height; stripY += rowsPerStrip) {
+            const uint32_t rows = qMin(rowsPerStrip, height - stripY);
+            if (!TIFFReadRGBAStrip(tiff, stripY, raster.data())) {
+                ok = false;
+                break;
+            }
+            for (uint32_t y = 0; y < rows; ++y) {
+                const uint32_t *src = raster.data() + static_cast<size_t>(rows - 1 - y) * width;
+                for (uint32_t x = 0; x < width; ++x) {
+                    pixels[x] = qRgba(TIFFGetR(src[x]), TIFFGetG(src[x]), TIFFGetB(src[x]), TIFFGetA(src[x]));
+                }
+                sampler.addRow(stripY + y, pixels.data());
+            }
+        }
+    }
+
+    TIFFClose(tiff);
+    if (!ok) {
+        qWarning() << "TIFF 流式读取失败:" << filePath;
+        return QImage();
+    }
+    return sampler.result();
+}
+#endif
+
+} // namespace
+
+bool ScanlineDownsampler::canStream(const QString &filePath)
+{
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+#ifdef HAVE_LIBPNG
+    if (suffix == "png") {
+        return !isInterlacedPng(filePath);
+    }
+#endif
+#ifdef HAVE_LIBTIFF
+    if (suffix == "tif" || suffix == "tiff") {
+        return true;
+    }
+#endif
+    Q_UNUSED(suffix);
+    return false;
+}
+
+QImage ScanlineDownsampler::downsampleFile(const QString &filePath, const QSize &outputSize)
+{
+    if (!canStream(filePath) || outputSize.isEmpty()) {
+        return QImage();
+    }
+
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    QImage result;
+#ifdef HAVE_LIBPNG
+    if (suffix == "png") {
+        result = streamPng(filePath, outputSize);
+    }
+#endif
+#ifdef HAVE_LIBTIFF
+    if (suffix == "tif" || suffix == "tiff") {
+        result = streamTiff(filePath, outputSize);
+    }
+#endif
+    qDebug() << "流式缩小:" << filePath << "->" << result.size();
+    return result;
+}
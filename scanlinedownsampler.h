@@ -0,0 +1,47 @@
+// scanlinedownsampler.h
+#ifndef SCANLINEDOWNSAMPLER_H
+#define SCANLINEDOWNSAMPLER_H
+
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include <QHash>
+
+// 流式盒式滤波缩小
+// 按行（或按行内的片段）输入像素，累加到对应的输出像素上，输出行的输入全部到齐后立即写出。
+// 内存只与输出尺寸成正比，用于无法按区域解码的超大 PNG / 条带 TIFF 的预览图和缩略图。
+class ScanlineDownsampler
+{
+public:
+    // outputSize 大于 inputSize 时按 inputSize 输出（不放大）
+    ScanlineDownsampler(const QSize &inputSize, const QSize &outputSize);
+
+    // 输入第 y 行从 x 开始的 count 个预乘 ARGB32 像素；行可以分多段、以任意列顺序输入
+    void addSpan(int y, int x, int count, const QRgb *pixels);
+    // 前 rowsDone 行已全部输入，写出不再有输入的输出行
+    void finishRows(int rowsDone);
+    // 输入完整的一行（按行顺序调用）
+    void addRow(int y, const QRgb *pixels);
+
+    QImage result() const { return output; }
+
+    // 文件是否可以流式读取（不隔行扫描的 PNG、TIFF，取决于编译时启用的库）
+    static bool canStream(const QString &filePath);
+    // 流式读取文件并缩小到 outputSize，不支持时返回空图
+    static QImage downsampleFile(const QString &filePath, const QSize &outputSize);
+
+private:
+    int firstInputRow(int outputRow) const;
+    void flushRow(int outputRow);
+
+    QSize inputSize;
+    QSize outputSize;
+    QVector<int> columnMap;                  // 输入列 → 输出列
+    QVector<int> columnCount;                // 每个输出列包含的输入列数
+    QHash<int, QVector<quint64>> openRows;   // 正在累加的输出行，每像素 A/R/G/B 四个通道
+    int nextFlushRow;
+    QImage output;
+};
+
+#endif // SCANLINEDOWNSAMPLER_H
@@ -0,0 +1,657 @@
+// tarcheckpointindex.cpp
+#include "tarcheckpointindex.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const int kTarBlockSize = 512;
+const int kWindowSize = 32768;          // deflate 最大回溯距离
+const int kInputChunkSize = 256 * 1024;
+const int kOutputChunkSize = 256 * 1024;
+const quint32 kIndexMagic = 0x50565458; // "PVTX"
+const quint32 kIndexVersion = 1;
+
+// 解析 tar 头中的数字字段（八进制文本或 GNU base-256）
+qint64 parseTarNumber(const char *field, int length)
+{
+    if (static_cast<unsigned char>(field[0]) & 0x80) {
+        qint64 value = field[0] & 0x7f;
+        for (int i = 1; i < length; ++i) {
+            value = (value << 8) | static_cast<unsigned char>(field[i]);
+        }
+        return value;
+    }
+
+    qint64 value = 0;
+    int i = 0;
+    while (i < length && (field[i] == ' ' || field[i] == '\0')) {
+        ++i;
+    }
+    for (; i < length && field[i] >= '0' && field[i] <= '7'; ++i) {
+        value = value * 8 + (field[i] - '0');
+    }
+    return value;
+}
+
+QString tarString(const char *field, int length)
+{
+    return QString::fromUtf8(field, static_cast<int>(qstrnlen(field, length)));
+}
+
+bool verifyTarChecksum(const char *header)
+{
+    qint64 stored = parseTarNumber(header + 148, 8);
+    qint64 sum = 0;
+    for (int i = 0; i < kTarBlockSize; ++i) {
+        sum += (i >= 148 && i < 156) ? ' ' : static_cast<unsigned char>(header[i]);
+    }
+    return sum == stored;
+}
+
+// 逐块消费未压缩的 tar 流，记录每个普通文件条目的数据偏移
+class TarStreamParser
+{
+public:
+    explicit TarStreamParser(QVector<TarCheckpointIndex::Entry> &entries)
+        : entries(entries) {}
+
+    void feed(const char *data, qint64 length)
+    {
+        while (length > 0 && state != Done && state != Failed) {
+            qint64 take = 0;
+            switch (state) {
+            case Header:
+                take = qMin<qint64>(kTarBlockSize - header.size(), length);
+                header.append(data, take);
+                position += take;
+                if (header.size() == kTarBlockSize) {
+                    handleHeader();
+                }
+                break;
+            case Data:
+                take = qMin(remaining, length);
+                if (collectData) {
+                    collected.append(data, take);
+                }
+                position += take;
+                remaining -= take;
+                if (remaining == 0) {
+                    finishData();
+                }
+                break;
+            case Padding:
+                take = qMin(remaining, length);
+                position += take;
+                remaining -= take;
+                if (remaining == 0) {
+                    state = Header;
+                }
+                break;
+            default:
+                break;
+            }
+            data += take;
+            length -= take;
+        }
+    }
+
+    bool failed() const { return state == Failed; }
+    bool finished() const { return state == Done; }
+    // 流在条目边界处结束也视为完整（部分打包工具不写结束块）
+    bool atBoundary() const { return state == Header && header.isEmpty(); }
+
+private:
+    enum State { Header, Data, Padding, Done, Failed };
+
+    void handleHeader()
+    {
+        const char *raw = header.constData();
+        bool allZero = std::all_of(raw, raw + kTarBlockSize,
+                                   [](char c) { return c == 0; });
+        if (allZero) {
+            header.clear();
+            if (++zeroBlocks >= 2) {
+                state = Done;
+            }
+            return;
+        }
+        zeroBlocks = 0;
+
+        if (!verifyTarChecksum(raw)) {
+            qDebug() << "tar 头校验失败，偏移:" << position - kTarBlockSize;
+            state = Failed;
+            return;
+        }
+
+        char type = raw[156];
+        qint64 size = parseTarNumber(raw + 124, 12);
+
+        QString name = tarString(raw, 100);
+        if (std::memcmp(raw + 257, "ustar", 5) == 0) {
+            QString prefix = tarString(raw + 345, 155);
+            if (!prefix.isEmpty()) {
+                name = prefix + "/" + name;
+            }
+        }
+        if (!pendingPaxPath.isEmpty()) {
+            name = pendingPaxPath;
+        } else if (!pendingLongName.isEmpty()) {
+            name = pendingLongName;
+        }
+
+        collectData = false;
+        collectType = type;
+        collected.clear();
+
+        if (type == 'L' || type == 'x') {
+            // GNU 长文件名 / pax 扩展头：数据描述下一个条目
+            collectData = true;
+        } else {
+            if (type == '0' || type == '\0' || type == '7') {
+                TarCheckpointIndex::Entry entry;
+                entry.name = name;
+                entry.dataOffset = position;
+                entry.size = size;
+                entries.append(entry);
+            }
+            pendingLongName.clear();
+            pendingPaxPath.clear();
+        }
+
+        header.clear();
+        remaining = size;
+        padding = (kTarBlockSize - size % kTarBlockSize) % kTarBlockSize;
+        if (remaining > 0) {
+            state = Data;
+        } else {
+            state = Header;
+        }
+    }
+
+    void finishData()
+    {
+        if (collectData) {
+            if (collectType == 'L') {
+                pendingLongName = QString::fromUtf8(collected.constData(),
+                                                    static_cast<int>(qstrnlen(collected.constData(), collected.size())));
+            } else {
+                parsePaxPath();
+            }
+            collected.clear();
+        }
+
+        remaining = padding;
+        state = remaining > 0 ? Padding : Header;
+    }
+
+    // pax 记录格式: "<长度> <键>=<值>\n"
+    void parsePaxPath()
+    {
+        int offset = 0;
+        while (offset < collected.size()) {
+            int space = collected.indexOf(' ', offset);
+            if (space < 0) break;
+            int recordLength = collected.mid(offset, space - offset).toInt();
+            if (recordLength <= 0 || offset + recordLength > collected.size()) break;
+
+            QByteArray record = collected.mid(space + 1, offset + recordLength - space - 2);
+            if (record.startsWith("path=")) {
+                pendingPaxPath = QString::fromUtf8(record.mid(5));
+            }
+            offset += recordLength;
+        }
+    }
+
+    QVector<TarCheckpointIndex::Entry> &entries;
+    State state = Header;
+    qint64 position = 0;
+    QByteArray header;
+    qint64 remaining = 0;
+    qint64 padding = 0;
+    int zeroBlocks = 0;
+
+    bool collectData = false;
+    char collectType = 0;
+    QByteArray collected;
+    QString pendingLongName;
+    QString pendingPaxPath;
+};
+
+} // namespace
+
+TarCheckpointIndex::TarCheckpointIndex()
+    : archiveSize(0),
+    archiveModified(0),
+    valid(false)
+{
+}
+
+bool TarCheckpointIndex::isCandidate(const QString &archivePath)
+{
+    QString lowerName = archivePath.toLower();
+    if (!lowerName.endsWith(".gz") && !lowerName.endsWith(".tgz")) {
+        return false;
+    }
+
+    QFile file(archivePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray magic = file.read(2);
+    return magic.size() == 2 &&
+           static_cast<unsigned char>(magic[0]) == 0x1f &&
+           static_cast<unsigned char>(magic[1]) == 0x8b;
+}
+
+void TarCheckpointIndex::clear()
+{
+    archivePath.clear();
+    archiveSize = 0;
+    archiveModified = 0;
+    valid = false;
+    entryList.clear();
+    entryLookup.clear();
+    checkpoints.clear();
+}
+
+void TarCheckpointIndex::setArchive(const QString &path)
+{
+    clear();
+
+    QFileInfo fileInfo(path);
+    archivePath = fileInfo.absoluteFilePath();
+    archiveSize = fileInfo.size();
+    archiveModified = fileInfo.lastModified().toMSecsSinceEpoch();
+}
+
+void TarCheckpointIndex::finishLoading()
+{
+    for (int i = 0; i < entryList.size(); ++i) {
+        entryLookup.insert(entryList[i].name, i);
+    }
+    valid = true;
+}
+
+bool TarCheckpointIndex::loadSaved(const QString &path)
+{
+    setArchive(path);
+    if (!load()) {
+        clear();
+        return false;
+    }
+    qDebug() << "已加载 tar.gz 检查点索引:" << archivePath
+             << "条目:" << entryList.size() << "检查点:" << checkpoints.size();
+    finishLoading();
+    return true;
+}
+
+bool TarCheckpointIndex::loadOrBuild(const QString &path, const QAtomicInt *cancelled)
+{
+    if (loadSaved(path)) {
+        return true;
+    }
+
+    setArchive(path);
+    if (build(cancelled)) {
+        qDebug() << "已建立 tar.gz 检查点索引:" << archivePath
+                 << "条目:" << entryList.size() << "检查点:" << checkpoints.size();
+        save();
+    } else {
+        qDebug() << "无法建立 tar.gz 检查点索引，继续顺序解压:" << archivePath;
+        clear();
+        return false;
+    }
+
+    finishLoading();
+    return true;
+}
+
+QStringList TarCheckpointIndex::entryNames() const
+{
+    QStringList names;
+    names.reserve(entryList.size());
+    for (const Entry &entry : entryList) {
+        names.append(entry.name);
+    }
+    return names;
+}
+
+bool TarCheckpointIndex::build(const QAtomicInt *cancelled)
+{
+    QFile file(archivePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    z_stream strm;
+    std::memset(&strm, 0, sizeof(strm));
+    // 47 = 自动识别 zlib/gzip 头
+    if (inflateInit2(&strm, 47) != Z_OK) {
+        return false;
+    }
+
+    QByteArray input(kInputChunkSize, Qt::Uninitialized);
+    QByteArray window(kWindowSize, Qt::Uninitialized);
+    unsigned char *windowData = reinterpret_cast<unsigned char *>(window.data());
+
+    TarStreamParser parser(entryList);
+
+    // 第一个检查点：文件开头
+    checkpoints.append(Checkpoint());
+
+    qint64 totalIn = 0;
+    qint64 totalOut = 0;
+    qint64 lastCheckpointOut = 0;
+    bool windowFull = false;
+    int ret = Z_OK;
+    bool ok = false;
+
+    strm.avail_out = 0;
+    while (!parser.finished() && !parser.failed()) {
+        if (cancelled && cancelled->loadRelaxed()) {
+            break;
+        }
+        qint64 got = file.read(input.data(), input.size());
+        if (got <= 0) {
+            // 输入结束：只有在 gzip 流完整结束时才算成功
+            ok = (ret == Z_STREAM_END) && parser.atBoundary();
+            break;
+        }
+        strm.next_in = reinterpret_cast<Bytef *>(input.data());
+        strm.avail_in = static_cast<uInt>(got);
+
+        // avail_out 为 0 时解压器可能还有未输出的数据，需要继续调用
+        while ((strm.avail_in > 0 || strm.avail_out == 0) &&
+               !parser.finished() && !parser.failed()) {
+            if (ret == Z_STREAM_END) {
+                if (strm.avail_in == 0) {
+                    break;
+                }
+                // 多成员 gzip（pigz 等）：继续解析下一个成员
+                inflateReset(&strm);
+            }
+            if (strm.avail_out == 0) {
+                strm.next_out = windowData;
+                strm.avail_out = kWindowSize;
+                windowFull = windowFull || totalOut > 0;
+            }
+
+            unsigned char *outStart = strm.next_out;
+            totalIn += strm.avail_in;
+            totalOut += strm.avail_out;
+            ret = inflate(&strm, Z_BLOCK);
+            totalIn -= strm.avail_in;
+            totalOut -= strm.avail_out;
+
+            parser.feed(reinterpret_cast<const char *>(outStart), strm.next_out - outStart);
+
+            if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR ||
+                ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR) {
+                qDebug() << "gzip 解压失败:" << (strm.msg ? strm.msg : "") << "输入偏移:" << totalIn;
+                break;
+            }
+            if (ret == Z_BUF_ERROR) {
+                ret = Z_OK;
+                continue;
+            }
+
+            // 在 deflate 块边界（且不是最后一块）记录检查点
+            if (ret != Z_STREAM_END && (strm.data_type & 128) && !(strm.data_type & 64) &&
+                totalOut - lastCheckpointOut > kCheckpointSpan) {
+                int writePos = kWindowSize - static_cast<int>(strm.avail_out);
+                QByteArray history;
+                if (windowFull) {
+                    history = window.mid(writePos) + window.left(writePos);
+                } else {
+                    history = window.left(writePos);
+                }
+
+                Checkpoint checkpoint;
+                checkpoint.out = totalOut;
+                checkpoint.in = totalIn;
+                checkpoint.bits = strm.data_type & 7;
+                checkpoint.window = qCompress(history, 1);
+                checkpoints.append(checkpoint);
+                lastCheckpointOut = totalOut;
+            }
+        }
+
+        if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR ||
+            ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR) {
+            // tar 已经读完，之后的多余数据（填充）可以忽略
+            ok = parser.finished();
+            break;
+        }
+    }
+
+    if (parser.finished()) {
+        ok = true;
+    }
+    if (cancelled && cancelled->loadRelaxed()) {
+        ok = false;
+    }
+
+    inflateEnd(&strm);
+
+    if (parser.failed()) {
+        qDebug() << "不是 tar 格式或 tar 头损坏:" << archivePath;
+        return false;
+    }
+    return ok;
+}
+
+int TarCheckpointIndex::findCheckpoint(qint64 offset) const
+{
+    auto it = std::upper_bound(checkpoints.cbegin(), checkpoints.cend(), offset,
+                               [](qint64 value, const Checkpoint &checkpoint) {
+                                   return value < checkpoint.out;
+                               });
+    return qMax(0, static_cast<int>(it - checkpoints.cbegin()) - 1);
+}
+
+QByteArray TarCheckpointIndex::extract(const QString &entryName) const
+{
+    if (!valid) {
+        return QByteArray();
+    }
+
+    auto lookup = entryLookup.constFind(entryName);
+    if (lookup == entryLookup.constEnd()) {
+        return QByteArray();
+    }
+
+    const Entry &entry = entryList.at(lookup.value());
+    if (entry.size <= 0) {
+        return QByteArray();
+    }
+
+    const Checkpoint &checkpoint = checkpoints.at(findCheckpoint(entry.dataOffset));
+
+    QFile file(archivePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    z_stream strm;
+    std::memset(&strm, 0, sizeof(strm));
+    bool rawMode = checkpoint.out > 0;
+
+    if (!rawMode) {
+        if (inflateInit2(&strm, 47) != Z_OK) {
+            return QByteArray();
+        }
+    } else {
+        // 从检查点恢复：原始 deflate 模式 + 未用完的位 + 历史窗口
+        if (inflateInit2(&strm, -15) != Z_OK) {
+            return QByteArray();
+        }
+        file.seek(checkpoint.in - (checkpoint.bits ? 1 : 0));
+        if (checkpoint.bits) {
+            char byte = 0;
+            if (!file.getChar(&byte)) {
+                inflateEnd(&strm);
+                return QByteArray();
+            }
+            inflatePrime(&strm, checkpoint.bits,
+                         static_cast<unsigned char>(byte) >> (8 - checkpoint.bits));
+        }
+        QByteArray history = qUncompress(checkpoint.window);
+        inflateSetDictionary(&strm, reinterpret_cast<const Bytef *>(history.constData()),
+                             static_cast<uInt>(history.size()));
+    }
+
+    QByteArray result;
+    result.reserve(entry.size);
+    QByteArray input(kInputChunkSize, Qt::Uninitialized);
+    QByteArray output(kOutputChunkSize, Qt::Uninitialized);
+    qint64 position = checkpoint.out;
+
+    while (result.size() < entry.size) {
+        if (strm.avail_in == 0) {
+            qint64 got = file.read(input.data(), input.size());
+            if (got <= 0) {
+                break;
+            }
+            strm.next_in = reinterpret_cast<Bytef *>(input.data());
+            strm.avail_in = static_cast<uInt>(got);
+        }
+
+        strm.next_out = reinterpret_cast<Bytef *>(output.data());
+        strm.avail_out = static_cast<uInt>(output.size());
+        int ret = inflate(&strm, Z_NO_FLUSH);
+        if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR ||
+            ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR) {
+            qDebug() << "从检查点解压失败:" << entryName << (strm.msg ? strm.msg : "");
+            break;
+        }
+
+        // 跳过条目之前的数据，只保留目标条目
+        qint64 produced = output.size() - strm.avail_out;
+        qint64 chunkStart = position;
+        position += produced;
+        if (position > entry.dataOffset) {
+            qint64 from = qMax<qint64>(0, entry.dataOffset - chunkStart);
+            qint64 take = qMin<qint64>(produced - from, entry.size - result.size());
+            result.append(output.constData() + from, take);
+        }
+
+        if (ret == Z_STREAM_END) {
+            if (rawMode) {
+                // 原始模式不会处理 gzip 尾部（CRC32 + ISIZE），手动跳过后切回 gzip 模式
+                uInt skipped = qMin<uInt>(8, strm.avail_in);
+                strm.next_in += skipped;
+                strm.avail_in -= skipped;
+                if (skipped < 8) {
+                    file.seek(file.pos() + (8 - skipped));
+                }
+                inflateReset2(&strm, 47);
+                rawMode = false;
+            } else {
+                inflateReset(&strm);
+            }
+        }
+    }
+
+    inflateEnd(&strm);
+
+    if (result.size() != entry.size) {
+        qDebug() << "检查点提取不完整:" << entryName << result.size() << "/" << entry.size;
+        return QByteArray();
+    }
+    return result;
+}
+
+QString TarCheckpointIndex::indexFilePath() const
+{
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+                       "/archive_index";
+    QByteArray hash = QCryptographicHash::hash(archivePath.toUtf8(),
+                                               QCryptographicHash::Sha1).toHex();
+    return cacheDir + "/" + QString::fromLatin1(hash) + ".pvidx";
+}
+
+bool TarCheckpointIndex::load()
+{
+    QFile file(indexFilePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint64 storedSize = 0;
+    qint64 storedModified = 0;
+    qint64 storedSpan = 0;
+    in >> magic >> version >> storedSize >> storedModified >> storedSpan;
+
+    // 压缩包被修改过或格式不匹配时重新建立索引
+    if (magic != kIndexMagic || version != kIndexVersion ||
+        storedSize != archiveSize || storedModified != archiveModified ||
+        storedSpan != kCheckpointSpan) {
+        return false;
+    }
+
+    qint32 entryCount = 0;
+    in >> entryCount;
+    if (entryCount < 0) return false;
+    entryList.resize(entryCount);
+    for (Entry &entry : entryList) {
+        in >> entry.name >> entry.dataOffset >> entry.size;
+    }
+
+    qint32 checkpointCount = 0;
+    in >> checkpointCount;
+    if (checkpointCount <= 0) return false;
+    checkpoints.resize(checkpointCount);
+    for (Checkpoint &checkpoint : checkpoints) {
+        qint32 bits = 0;
+        in >> checkpoint.out >> checkpoint.in >> bits >> checkpoint.window;
+        checkpoint.bits = bits;
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        entryList.clear();
+        checkpoints.clear();
+        return false;
+    }
+    return true;
+}
+
+bool TarCheckpointIndex::save() const
+{
+    QString path = indexFilePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "无法保存检查点索引:" << path;
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << kIndexMagic << kIndexVersion << archiveSize << archiveModified << kCheckpointSpan;
+
+    out << static_cast<qint32>(entryList.size());
+    for (const Entry &entry : entryList) {
+        out << entry.name << entry.dataOffset << entry.size;
+    }
+
+    out << static_cast<qint32>(checkpoints.size());
+    for (const Checkpoint &checkpoint : checkpoints) {
+        out << checkpoint.out << checkpoint.in << static_cast<qint32>(checkpoint.bits)
+            << checkpoint.window;
+    }
+
+    return out.status() == QDataStream::Ok;
+}
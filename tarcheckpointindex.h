@@ -0,0 +1,78 @@
+// tarcheckpointindex.h
+#ifndef TARCHECKPOINTINDEX_H
+#define TARCHECKPOINTINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QAtomicInt>
+
+// gzip 压缩的 tar 包随机访问索引（zran 方式）
+// 第一次完整解压时每隔一段未压缩数据记录一次解压器状态（输入位置 + 32KB 窗口），
+// 同时记录每个 tar 条目在未压缩流中的偏移。之后提取任意条目时，
+// 从最近的检查点恢复解压，无需从文件头重新解压。
+// 只处理 gzip：项目只链接了 zlib。bzip2 块虽然可以从位偏移独立解码，但 libbz2 不接受位偏移起点，
+// 需要自己按位搜索块头并重新拼出流头；xz 只有多块文件（xz -T、pixz）才有块索引，需要链接 liblzma。
+// 这两种格式仍由 libarchive 顺序解压（固实压缩包的游标和暂存缓存）。
+class TarCheckpointIndex
+{
+public:
+    struct Entry {
+        QString name;
+        qint64 dataOffset = 0;  // 条目数据在未压缩流中的偏移
+        qint64 size = 0;        // 条目数据大小
+    };
+
+    TarCheckpointIndex();
+
+    // 是否是可以建立检查点索引的 tar.gz 文件（检查后缀和 gzip 魔数）
+    static bool isCandidate(const QString &archivePath);
+
+    // 只加载已保存的索引（读一个小文件，可以在界面线程调用）
+    bool loadSaved(const QString &archivePath);
+    // 加载已保存的索引，不存在或已过期则完整扫描一次并保存（耗时，应在后台线程调用）。
+    // cancelled 非零时中止扫描并返回 false
+    bool loadOrBuild(const QString &archivePath, const QAtomicInt *cancelled = nullptr);
+
+    void clear();
+    bool isValid() const { return valid; }
+
+    // 条目列表（按在包内的顺序）
+    QStringList entryNames() const;
+    const QVector<Entry> &entries() const { return entryList; }
+
+    // 从最近的检查点恢复解压并提取条目数据（线程安全，每次调用使用独立的文件句柄）
+    QByteArray extract(const QString &entryName) const;
+
+    // 检查点间隔（未压缩字节数）
+    static constexpr qint64 kCheckpointSpan = 4 * 1024 * 1024;
+
+private:
+    struct Checkpoint {
+        qint64 out = 0;        // 对应的未压缩偏移
+        qint64 in = 0;         // 对应的压缩流偏移
+        int bits = 0;          // in 之前一个字节中尚未使用的位数
+        QByteArray window;     // 压缩后的 32KB 历史窗口，为空表示从文件头开始
+    };
+
+    void setArchive(const QString &archivePath);
+    void finishLoading();
+    bool build(const QAtomicInt *cancelled);
+    bool load();
+    bool save() const;
+    QString indexFilePath() const;
+    int findCheckpoint(qint64 offset) const;
+
+    QString archivePath;
+    qint64 archiveSize;
+    qint64 archiveModified;
+    bool valid;
+
+    QVector<Entry> entryList;
+    QHash<QString, int> entryLookup;
+    QVector<Checkpoint> checkpoints;
+};
+
+#endif // TARCHECKPOINTINDEX_H
@@ -10,13 +10,12 @@
 #include <QScrollArea>
 #include <QElapsedTimer>
 #include <QImageReader>
-#include <QCache>
 #include <QTimer>
 #include <QFont>
-
-// 初始化静态成员变量
-QMap<QString, QPixmap> ThumbnailWidget::thumbnailCache;
-QMutex ThumbnailWidget::cacheMutex;
+#include "regionimagesource.h"
+#include "imageresampler.h"
+#include "decodedimagecache.h"
+#include "imagecodecs.h"
 
 ThumbnailWidget::ThumbnailWidget(ImageWidget *imageWidget, QWidget *parent)
     : QWidget(parent),
@@ -24,11 +23,9 @@ ThumbnailWidget::ThumbnailWidget(ImageWidget *imageWidget, QWidget *parent)
     thumbnailSize(250, 250),
     thumbnailSpacing(7),
     selectedIndex(-1),
-    loadedCount(0),
     totalCount(0),
     futureWatcher(nullptr),
     isLoading(false),
-    smartThumbnailCache(perfConfig.maxCacheSize),
     currentBatchIndex(0),
     batchLoadTimer(this),
     diagnosticTimer(nullptr)
@@ -63,13 +60,14 @@ void ThumbnailWidget::setImageList(const QStringList &list, const QDir &dir)
     imageList = list;
     currentDir = dir;
     selectedIndex = -1;
-    loadedCount = 0;
     totalCount = list.size();
 
     // 重置加载状态
     currentBatchIndex = 0;
     pendingLoadRequests.clear();
     allFilesToLoad.clear();
+    loadedThumbnails.clear();
+    queuedThumbnails.clear();
 
     update();
 
@@ -79,6 +77,195 @@ void ThumbnailWidget::setImageList(const QStringList &list, const QDir &dir)
     startLoadingAllThumbnails();
 }
 
+void ThumbnailWidget::setMetadataTable(const QSharedPointer<const ImageMetadataTable> &table)
+{
+    metadataTable = table;
+    update();
+}
+
+void ThumbnailWidget::addImages(const QStringList &list, const QStringList &added)
+{
+    const QString selectedName = imageList.value(selectedIndex);
+    imageList = list;
+    if (!selectedName.isEmpty()) {
+        selectedIndex = imageList.indexOf(selectedName);
+    }
+    totalCount = imageList.size();
+
+    queueThumbnails(added);
+    updateMinimumHeight();
+    update();
+    emit loadingProgress(loadedCount(), totalCount);
+    resumeLoading();
+}
+
+void ThumbnailWidget::removeImages(const QStringList &list, const QStringList &removed)
+{
+    const QSet<QString> removedSet(removed.cbegin(), removed.cend());
+    const QString selectedName = imageList.value(selectedIndex);
+    const int previousSelected = selectedIndex;
+    imageList = list;
+    if (!selectedName.isEmpty()) {
+        selectedIndex = imageList.indexOf(selectedName);
+        // 选中的文件被删除时停在原位置（即下一个文件）
+        if (selectedIndex < 0 && !imageList.isEmpty()) {
+            selectedIndex = qMin(previousSelected, imageList.size() - 1);
+        }
+    }
+
+    for (const QString &fileName : removed) {
+        forgetThumbnail(getCacheKey(fileName));
+    }
+
+    // 只保留还没开始加载的部分，已排队的被删文件不再加载
+    QStringList remaining;
+    for (int i = currentBatchIndex; i < allFilesToLoad.size(); ++i) {
+        if (!removedSet.contains(allFilesToLoad.at(i))) {
+            remaining.append(allFilesToLoad.at(i));
+        }
+    }
+    allFilesToLoad = remaining;
+    currentBatchIndex = 0;
+
+    totalCount = imageList.size();
+    updateMinimumHeight();
+    update();
+    emit loadingProgress(loadedCount(), totalCount);
+}
+
+void ThumbnailWidget::removeImageAt(int index)
+{
+    if (index < 0 || index >= imageList.size()) {
+        return;
+    }
+    const QString fileName = imageList.takeAt(index);
+    if (selectedIndex > index || (selectedIndex == index && selectedIndex >= imageList.size())) {
+        --selectedIndex;
+    }
+
+    forgetThumbnail(getCacheKey(fileName));
+
+    // 还在队列中就不再加载
+    const int queued = allFilesToLoad.indexOf(fileName, currentBatchIndex);
+    if (queued >= 0) {
+        allFilesToLoad.removeAt(queued);
+    }
+
+    totalCount = imageList.size();
+    updateMinimumHeight();
+    update();
+    emit loadingProgress(loadedCount(), totalCount);
+}
+
+void ThumbnailWidget::insertImageAt(int index, const QString &fileName)
+{
+    index = qBound(0, index, int(imageList.size()));
+    imageList.insert(index, fileName);
+    if (selectedIndex >= index) {
+        ++selectedIndex;
+    }
+    totalCount = imageList.size();
+
+    queueThumbnails(QStringList{fileName});
+    updateMinimumHeight();
+    update();
+    emit loadingProgress(loadedCount(), totalCount);
+    resumeLoading();
+}
+
+void ThumbnailWidget::invalidateImages(const QStringList &fileNames)
+{
+    for (const QString &fileName : fileNames) {
+        forgetThumbnail(getCacheKey(fileName));
+    }
+    queueThumbnails(fileNames);
+    update();
+    emit loadingProgress(loadedCount(), totalCount);
+    resumeLoading();
+}
+
+void ThumbnailWidget::reorderImages(const QStringList &list)
+{
+    const QString selectedName = imageList.value(selectedIndex);
+    imageList = list;
+    if (!selectedName.isEmpty()) {
+        selectedIndex = imageList.indexOf(selectedName);
+        ensureVisible(selectedIndex);
+    }
+    update();
+}
+
+// 队列已经跑完时重新启动；定时器还在等待下一批时新文件自然排在后面
+void ThumbnailWidget::resumeLoading()
+{
+    if (!batchLoadTimer.isActive() && currentBatchIndex < allFilesToLoad.size()) {
+        processBatchLoad();
+    }
+}
+
+void ThumbnailWidget::queueThumbnails(const QStringList &fileNames, bool front)
+{
+    if (front) {
+        // 已经处理过的部分不再保留，队列不随反复淘汰增长
+        allFilesToLoad.remove(0, currentBatchIndex);
+        currentBatchIndex = 0;
+        allFilesToLoad = fileNames + allFilesToLoad;
+    } else {
+        allFilesToLoad.append(fileNames);
+    }
+    for (const QString &fileName : fileNames) {
+        queuedThumbnails.insert(getCacheKey(fileName));
+    }
+}
+
+// 缩略图只保存在有预算的共用缓存中，滚动回来时可能已被淘汰：从已加载中去掉并优先重新加载
+void ThumbnailWidget::reloadEvictedThumbnails(const QStringList &fileNames)
+{
+    QStringList evicted;
+    for (const QString &fileName : fileNames) {
+        const QString cacheKey = getCacheKey(fileName);
+        if (!loadedThumbnails.contains(cacheKey) || queuedThumbnails.contains(cacheKey) ||
+            failedThumbnails.contains(cacheKey) ||
+            DecodedImageCache::shared().contains(DecodedImageCache::Thumbnails, cacheKey)) {
+            continue;
+        }
+        loadedThumbnails.remove(cacheKey);
+        evicted.append(fileName);
+    }
+    if (evicted.isEmpty()) {
+        return;
+    }
+    qDebug() << "重新加载被缓存淘汰的缩略图:" << evicted.size();
+    queueThumbnails(evicted, true);
+    emit loadingProgress(loadedCount(), totalCount);
+    resumeLoading();
+}
+
+// 从缓存和加载状态中去掉一个缩略图；正在加载的结果回来时不再计入
+void ThumbnailWidget::forgetThumbnail(const QString &cacheKey)
+{
+    DecodedImageCache::shared().remove(DecodedImageCache::Thumbnails, cacheKey);
+    failedThumbnails.remove(cacheKey);
+    loadingErrors.remove(cacheKey);
+    loadedThumbnails.remove(cacheKey);
+    queuedThumbnails.remove(cacheKey);
+}
+
+// 加载结果回到界面线程：只计入仍在排队的键
+void ThumbnailWidget::finishThumbnails(const QStringList &loadedKeys, const QStringList &failedKeys)
+{
+    for (const QString &cacheKey : failedKeys) {
+        queuedThumbnails.remove(cacheKey);
+    }
+    for (const QString &cacheKey : loadedKeys) {
+        if (queuedThumbnails.remove(cacheKey)) {
+            loadedThumbnails.insert(cacheKey);
+        }
+    }
+    emit loadingProgress(loadedCount(), totalCount);
+    update();
+}
+
 // 开始加载所有缩略图
 void ThumbnailWidget::startLoadingAllThumbnails()
 {
@@ -87,7 +274,8 @@ void ThumbnailWidget::startLoadingAllThumbnails()
     qDebug() << "开始加载所有缩略图，总数:" << imageList.size();
 
     // 准备所有需要加载的文件
-    allFilesToLoad = imageList;
+    allFilesToLoad.clear();
+    queueThumbnails(imageList);
     currentBatchIndex = 0;
 
     // 立即开始第一批加载
@@ -136,69 +324,46 @@ void ThumbnailWidget::processBatchLoad()
 void ThumbnailWidget::loadThumbnailsBatch(const QStringList &fileNames)
 {
     QtConcurrent::run([this, fileNames]() {
-        QList<QPair<QString, QPixmap>> results;
-
-        for (const QString &fileName : fileNames) {
-            QPixmap thumbnail = loadSingleThumbnail(fileName);
-            if (!thumbnail.isNull()) {
-                QString cacheKey = getCacheKey(fileName);
-                results.append(qMakePair(cacheKey, thumbnail));
+        QStringList loadedKeys;
+        QStringList failedKeys;
+
+        // 压缩包条目先合并为一次顺序读取，避免固实压缩包每张缩略图都从头解压
+        if (imageWidget) {
+            QStringList archiveEntries;
+            for (const QString &fileName : fileNames) {
+                if (fileName.contains("|")) {
+                    archiveEntries.append(fileName);
+                }
             }
-        }
-
-        // 在主线程更新
-        QMetaObject::invokeMethod(this, [this, results]() {
-            for (const auto &result : results) {
-                // 更新智能缓存
-                smartThumbnailCache.insert(result.first, new QPixmap(result.second));
-
-                // 同时更新静态缓存以保持兼容性
-                QMutexLocker locker(&cacheMutex);
-                thumbnailCache.insert(result.first, result.second);
+            if (!archiveEntries.isEmpty()) {
+                imageWidget->prefetchArchiveEntries(archiveEntries);
             }
+        }
 
-            // 更新加载计数
-            loadedCount += results.size();
-            emit loadingProgress(loadedCount, totalCount);
-
-            // 更新UI
-            update();
+        // 缩略图已由 loadSingleThumbnail 写入共用缓存，界面线程只更新计数并重绘
+        for (const QString &fileName : fileNames) {
+            const bool loaded = !loadSingleThumbnail(fileName).isNull();
+            (loaded ? loadedKeys : failedKeys).append(getCacheKey(fileName));
+        }
 
+        // 在主线程更新加载计数和界面
+        QMetaObject::invokeMethod(this, [this, loadedKeys, failedKeys]() {
+            finishThumbnails(loadedKeys, failedKeys);
         }, Qt::QueuedConnection);
     });
 }
 
-// 加载单个缩略图
-QPixmap ThumbnailWidget::loadSingleThumbnail(const QString &fileName)
+// 加载单个缩略图（在后台线程调用），新生成的缩略图写入共用缓存
+QImage ThumbnailWidget::loadSingleThumbnail(const QString &fileName)
 {
     QString cacheKey = getCacheKey(fileName);
 
     qDebug() << "加载缩略图:" << fileName << "缓存键:" << cacheKey;
 
-    // 快速缓存检查
-    if (QPixmap* cached = smartThumbnailCache.object(cacheKey)) {
-        if (!cached->isNull()) {
-            qDebug() << "从智能缓存获取:" << fileName;
-            return *cached;
-        } else {
-            qDebug() << "智能缓存中的缩略图为空，重新加载:" << fileName;
-            smartThumbnailCache.remove(cacheKey);
-        }
-    }
-
-    // 回退到静态缓存检查
-    {
-        QMutexLocker locker(&cacheMutex);
-        if (thumbnailCache.contains(cacheKey)) {
-            QPixmap cached = thumbnailCache.value(cacheKey);
-            if (!cached.isNull()) {
-                qDebug() << "从静态缓存获取:" << fileName;
-                return cached;
-            } else {
-                qDebug() << "静态缓存中的缩略图为空，移除:" << fileName;
-                thumbnailCache.remove(cacheKey);
-            }
-        }
+    QImage cached = DecodedImageCache::shared().lookupImage(DecodedImageCache::Thumbnails, cacheKey);
+    if (!cached.isNull()) {
+        qDebug() << "从缓存获取:" << fileName;
+        return cached;
     }
 
     QPixmap result;
@@ -261,7 +426,9 @@ QPixmap ThumbnailWidget::loadSingleThumbnail(const QString &fileName)
         result = createArchiveIcon();
     }
 
-    return result;
+    const QImage image = result.toImage();
+    DecodedImageCache::shared().insertImage(DecodedImageCache::Thumbnails, cacheKey, image);
+    return image;
 }
 
 // 高效图片加载
@@ -284,6 +451,26 @@ QPixmap ThumbnailWidget::loadImageFileFast(const QString &filePath)
         return QPixmap();
     }
 
+    // 超大图片：流式缩小或按比例解码到缩略图尺寸，不整张解码
+    if (QSharedPointer<RegionImageSource> region = RegionImageSource::open(filePath)) {
+        QSize targetSize = region->size().scaled(thumbnailSize, Qt::KeepAspectRatio);
+        QImage image = region->downsampled(targetSize.expandedTo(QSize(1, 1)));
+        if (!image.isNull()) {
+            qDebug() << "超大图片缩略图:" << filePath << region->size() << "via" << region->backendName();
+            return QPixmap::fromImage(scaleImageWithAspectRatio(image));
+        }
+    }
+
+    // 方法0: 直接解码后端（JPEG 按 DCT 比例直接解码到接近缩略图的尺寸）
+    const int thumbnailEdge = qMax(thumbnailSize.width(), thumbnailSize.height());
+    ImageCodecs::Backend backend = ImageCodecs::QtPlugin;
+    if (ImageCodecs::backendFor(fileInfo.suffix().toLatin1()) != ImageCodecs::QtPlugin) {
+        QImage image = ImageCodecs::decodeFile(filePath, QSize(thumbnailEdge, thumbnailEdge), &backend);
+        if (!image.isNull() && backend != ImageCodecs::QtPlugin) {
+            return QPixmap::fromImage(scaleImageWithAspectRatio(image));
+        }
+    }
+
     // 方法1: 使用 QImageReader（最可靠）
     QImageReader reader(filePath);
 
@@ -352,7 +539,7 @@ QPixmap ThumbnailWidget::scaleThumbnailWithAspectRatio(const QPixmap &original)
     if (original.isNull()) return QPixmap();
 
     // 保持宽高比进行缩放
-    return original.scaled(thumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    return QPixmap::fromImage(ImageResampler::scaled(original.toImage(), thumbnailSize, Qt::KeepAspectRatio));
 }
 
 QImage ThumbnailWidget::scaleImageWithAspectRatio(const QImage &original) const
@@ -360,7 +547,7 @@ QImage ThumbnailWidget::scaleImageWithAspectRatio(const QImage &original) const
     if (original.isNull()) return QImage();
 
     // 保持宽高比进行缩放
-    return original.scaled(thumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    return ImageResampler::scaled(original, thumbnailSize, Qt::KeepAspectRatio);
 }
 
 // 绘制方法
@@ -390,8 +577,16 @@ void ThumbnailWidget::paintEvent(QPaintEvent *event)
 
     int itemsPerRow = calculateItemsPerRow();
 
-    // 绘制所有缩略图
-    for (int i = 0; i < imageList.size(); ++i) {
+    // 只遍历与脏矩形相交的行，几十万个文件时重绘也不随列表长度增长
+    const int rowHeight = thumbnailSize.height() + thumbnailSpacing + 25;
+    const int firstRow = qMax(0, (event->rect().top() - thumbnailSpacing) / rowHeight);
+    const int lastRow = qMax(0, (event->rect().bottom() - thumbnailSpacing) / rowHeight);
+    const int firstIndex = qMin(static_cast<qsizetype>(firstRow) * itemsPerRow, imageList.size());
+    const int endIndex = qMin(static_cast<qsizetype>(lastRow + 1) * itemsPerRow, imageList.size());
+
+    // 绘制可见的缩略图
+    QStringList evicted;
+    for (int i = firstIndex; i < endIndex; ++i) {
         QString fileName = imageList.at(i);
 
         // 计算位置
@@ -410,43 +605,38 @@ void ThumbnailWidget::paintEvent(QPaintEvent *event)
         QString cacheKey = getCacheKey(fileName);
         bool isTopLevelArchive = isArchiveFile(fileName) && !fileName.contains("|");
 
-        // 获取缩略图（智能缓存优先）
-        QPixmap thumbnail = getCachedThumbnail(cacheKey);
-        if (thumbnail.isNull() && isTopLevelArchive) {
-            thumbnail = createArchiveIcon();
+        // 没有缩略图的顶层压缩包由 drawThumbnailItem 画图标
+        QImage thumbnail = getCachedThumbnail(cacheKey);
+        if (thumbnail.isNull() && loadedThumbnails.contains(cacheKey) && !failedThumbnails.contains(cacheKey)) {
+            evicted.append(fileName);
         }
 
         drawThumbnailItem(painter, i, currentX, currentY, fileName, thumbnail, isTopLevelArchive);
     }
+    if (!evicted.isEmpty()) {
+        // 不在绘制过程中修改加载队列和发出信号
+        QMetaObject::invokeMethod(this, [this, evicted]() {
+            reloadEvictedThumbnails(evicted);
+        }, Qt::QueuedConnection);
+    }
 
     // 显示加载状态
     if (isLoading) {
         painter.setPen(QColor(200, 200, 200));
-        painter.drawText(10, 20, QString("加载中: %1/%2").arg(loadedCount).arg(totalCount));
+        painter.drawText(10, 20, QString("加载中: %1/%2").arg(loadedCount()).arg(totalCount));
     }
 
     updateMinimumHeight();
 }
 
-QPixmap ThumbnailWidget::getCachedThumbnail(const QString &cacheKey)
+QImage ThumbnailWidget::getCachedThumbnail(const QString &cacheKey) const
 {
-    // 优先使用智能缓存
-    if (QPixmap* cached = smartThumbnailCache.object(cacheKey)) {
-        return *cached;
-    }
-
-    // 回退到静态缓存
-    QMutexLocker locker(&cacheMutex);
-    if (thumbnailCache.contains(cacheKey)) {
-        return thumbnailCache.value(cacheKey);
-    }
-
-    return QPixmap();
+    return DecodedImageCache::shared().lookupImage(DecodedImageCache::Thumbnails, cacheKey);
 }
 
 void ThumbnailWidget::drawThumbnailItem(QPainter &painter, int index,
                                         int x, int y, const QString &fileName,
-                                        const QPixmap &thumbnail, bool isArchive)
+                                        const QImage &thumbnail, bool isArchive)
 {
     QRect borderRect(x, y, thumbnailSize.width(), thumbnailSize.height());
 
@@ -467,7 +657,7 @@ void ThumbnailWidget::drawThumbnailItem(QPainter &painter, int index,
         int thumbY = y + (thumbnailSize.height() - thumbnail.height()) / 2;
         QRect thumbRect(thumbX, thumbY, thumbnail.width(), thumbnail.height());
 
-        painter.drawPixmap(thumbRect, thumbnail);
+        painter.drawImage(thumbRect, thumbnail);
 
         // 绘制边框
         painter.setPen(QColor(100, 100, 100));
@@ -477,7 +667,16 @@ void ThumbnailWidget::drawThumbnailItem(QPainter &painter, int index,
         QPixmap archiveIcon = createArchiveIcon();
         painter.drawPixmap(borderRect, archiveIcon);
     } else {
-        // 加载中占位符
+        // 加载中占位符：已知原图尺寸时先画出与缩略图相同比例的框，加载完成时布局不跳动
+        QSize displaySize;
+        if (metadataTable && metadataTable->folder() == currentDir.absolutePath()) {
+            displaySize = metadataTable->entry(fileName).displaySize();
+        }
+        if (!displaySize.isEmpty()) {
+            QRect placeholderRect(QPoint(0, 0), displaySize.scaled(thumbnailSize, Qt::KeepAspectRatio));
+            placeholderRect.moveCenter(borderRect.center());
+            painter.fillRect(placeholderRect, QColor(60, 60, 60));
+        }
         painter.setPen(QColor(150, 150, 150));
         painter.drawText(borderRect, Qt::AlignCenter, tr("加载中..."));
     }
@@ -566,9 +765,9 @@ void ThumbnailWidget::diagnoseLoadingIssues()
 {
     qDebug() << "=== 缩略图加载问题诊断 ===";
     qDebug() << "总图片数量:" << imageList.size();
-    qDebug() << "智能缓存数量:" << smartThumbnailCache.size();
-    qDebug() << "静态缓存数量:" << thumbnailCache.size();
-    qDebug() << "已加载数量:" << loadedCount;
+    qDebug() << "共用缓存数量:" << DecodedImageCache::shared().count(DecodedImageCache::Thumbnails)
+             << "占用:" << DecodedImageCache::shared().usedBytes(DecodedImageCache::Thumbnails) / 1024 << "KB";
+    qDebug() << "已加载数量:" << loadedCount();
     qDebug() << "失败缩略图:" << failedThumbnails.size();
 
     // 检查每个文件的状态
@@ -576,11 +775,10 @@ void ThumbnailWidget::diagnoseLoadingIssues()
         QString fileName = imageList.at(i);
         QString cacheKey = getCacheKey(fileName);
 
-        bool inSmartCache = smartThumbnailCache.contains(cacheKey);
-        bool inStaticCache = thumbnailCache.contains(cacheKey);
+        bool inCache = DecodedImageCache::shared().contains(DecodedImageCache::Thumbnails, cacheKey);
         bool isFailed = failedThumbnails.contains(cacheKey);
 
-        if (!inSmartCache && !inStaticCache && !isFailed) {
+        if (!inCache && !isFailed) {
             qDebug() << "未加载的文件:" << fileName;
             qDebug() << "  - 索引:" << i;
             qDebug() << "  - 缓存键:" << cacheKey;
@@ -603,7 +801,7 @@ void ThumbnailWidget::logThumbnailStatus()
         QString fileName = imageList.at(i);
         QString cacheKey = getCacheKey(fileName);
 
-        if (smartThumbnailCache.contains(cacheKey) || thumbnailCache.contains(cacheKey)) {
+        if (DecodedImageCache::shared().contains(DecodedImageCache::Thumbnails, cacheKey)) {
             loaded++;
         }
     }
@@ -626,15 +824,13 @@ void ThumbnailWidget::forceReloadAll()
     stopLoading();
 
     // 清空所有缓存和状态
-    smartThumbnailCache.clear();
-    {
-        QMutexLocker locker(&cacheMutex);
-        thumbnailCache.clear();
-    }
+    DecodedImageCache::shared().clear(DecodedImageCache::Thumbnails);
 
     pendingLoadRequests.clear();
     failedThumbnails.clear();
     loadingErrors.clear();
+    loadedThumbnails.clear();
+    queuedThumbnails.clear();
     currentBatchIndex = 0;
 
     // 重新开始加载
@@ -658,19 +854,17 @@ void ThumbnailWidget::retryFailedThumbnails()
         }
 
         // 重新加载这个文件
-        QtConcurrent::run([this, fileName]() {
-            QPixmap thumbnail = loadSingleThumbnail(fileName);
-
-            QMetaObject::invokeMethod(this, [this, fileName, thumbnail]() {
-                QString cacheKey = getCacheKey(fileName);
-                if (!thumbnail.isNull()) {
-                    smartThumbnailCache.insert(cacheKey, new QPixmap(thumbnail));
-                    QMutexLocker locker(&cacheMutex);
-                    thumbnailCache.insert(cacheKey, thumbnail);
+        queuedThumbnails.insert(cacheKey);
+        QtConcurrent::run([this, fileName, cacheKey]() {
+            const bool loaded = !loadSingleThumbnail(fileName).isNull();
+
+            QMetaObject::invokeMethod(this, [this, cacheKey, loaded]() {
+                if (loaded) {
                     failedThumbnails.remove(cacheKey);
                     loadingErrors.remove(cacheKey);
-                    loadedCount++;
-                    update();
+                    finishThumbnails(QStringList{cacheKey}, QStringList());
+                } else {
+                    finishThumbnails(QStringList(), QStringList{cacheKey});
                 }
             }, Qt::QueuedConnection);
         });
@@ -724,15 +918,12 @@ void ThumbnailWidget::ensureVisible(int index)
 
 void ThumbnailWidget::clearThumbnailCache()
 {
-    QMutexLocker locker(&cacheMutex);
-    thumbnailCache.clear();
-    smartThumbnailCache.clear();
+    DecodedImageCache::shared().clear(DecodedImageCache::Thumbnails);
 }
 
 void ThumbnailWidget::clearThumbnailCacheForImage(const QString &imagePath)
 {
-    QMutexLocker locker(&cacheMutex);
-    thumbnailCache.remove(imagePath);
+    DecodedImageCache::shared().remove(DecodedImageCache::Thumbnails, imagePath);
 }
 
 void ThumbnailWidget::setThumbnailSize(const QSize &size)
@@ -740,17 +931,15 @@ void ThumbnailWidget::setThumbnailSize(const QSize &size)
     if (thumbnailSize != size) {
         thumbnailSize = size;
         // 尺寸变化时清空缓存
-        smartThumbnailCache.clear();
-        QMutexLocker locker(&cacheMutex);
-        thumbnailCache.clear();
+        DecodedImageCache::shared().clear(DecodedImageCache::Thumbnails);
         update();
     }
 }
 
 void ThumbnailWidget::setCacheSize(int maxSizeMB)
 {
-    perfConfig.maxCacheSize = maxSizeMB * 1024 * 1024;
-    smartThumbnailCache.setMaxCost(perfConfig.maxCacheSize);
+    DecodedImageCache::shared().setBudget(DecodedImageCache::Thumbnails,
+                                          static_cast<qint64>(maxSizeMB) * 1024 * 1024);
 }
 
 // 鼠标和键盘事件处理保持不变...
@@ -9,9 +9,10 @@
 #include <QStringList>
 #include <QMap>
 #include <QMutex>
-#include <QCache>
 #include <QTimer>
 #include <QSet>
+#include <QSharedPointer>
+#include "imagemetadatatable.h"
 
 class ImageWidget;  // 前向声明
 
@@ -24,6 +25,20 @@ public:
     ~ThumbnailWidget();
 
     void setImageList(const QStringList &list, const QDir &dir);
+    // 文件头信息到达后，尚未加载的缩略图按原图比例绘制占位框
+    void setMetadataTable(const QSharedPointer<const ImageMetadataTable> &table);
+    // 列表增加了 added 中的文件（list 为增加后的完整列表）：保留缓存、选中项和正在进行的加载，
+    // 只把新文件排进加载队列
+    void addImages(const QStringList &list, const QStringList &added);
+    // 列表删除了 removed 中的文件：丢弃它们的缓存和排队中的加载，选中项按文件名保留
+    void removeImages(const QStringList &list, const QStringList &removed);
+    // 单个文件的增删（删除图片、新建文件时）：只移动后面的项，其余缩略图和加载进度不变
+    void removeImageAt(int index);
+    void insertImageAt(int index, const QString &fileName);
+    // 文件内容已改变：丢弃旧缩略图并重新排进加载队列
+    void invalidateImages(const QStringList &fileNames);
+    // 同样的文件换了顺序（排序方式改变）
+    void reorderImages(const QStringList &list);
     void setSelectedIndex(int index);
     int getSelectedIndex() const;
     void ensureVisible(int index);
@@ -67,19 +82,25 @@ private:
 
     // 性能优化方法
     void startLoadingAllThumbnails();
+    void resumeLoading();
+    // front 为 true 时排在待加载队列最前（可见的缩略图被缓存淘汰后重新加载）
+    void queueThumbnails(const QStringList &fileNames, bool front = false);
+    void reloadEvictedThumbnails(const QStringList &fileNames);
+    void forgetThumbnail(const QString &cacheKey);
+    void finishThumbnails(const QStringList &loadedKeys, const QStringList &failedKeys);
     void loadThumbnailsBatch(const QStringList &fileNames);
-    QPixmap loadSingleThumbnail(const QString &fileName);
+    QImage loadSingleThumbnail(const QString &fileName);
     QPixmap loadImageFileFast(const QString &filePath);
     int calculateItemsPerRow() const;
     void drawThumbnailItem(QPainter &painter, int index, int x, int y,
-                           const QString &fileName, const QPixmap &thumbnail, bool isArchive);
+                           const QString &fileName, const QImage &thumbnail, bool isArchive);
     QString getCacheKey(const QString &fileName) const;
     QString getDisplayName(const QString &fileName) const;
     void updateMinimumHeight();
 
     // 缓存管理
     void cleanupOldCache();
-    QPixmap getCachedThumbnail(const QString &cacheKey);
+    QImage getCachedThumbnail(const QString &cacheKey) const;
     QPixmap scaleThumbnailWithAspectRatio(const QPixmap &original) const;
     QImage scaleImageWithAspectRatio(const QImage &original) const;
 
@@ -90,21 +111,21 @@ private:
     QStringList imageList;
     QDir currentDir;
     int selectedIndex;
+    QSharedPointer<const ImageMetadataTable> metadataTable;
 
-    // 加载相关
-    int loadedCount;
+    // 加载相关：按缓存键记录已完成的缩略图，进度由集合大小得出，增删、失败和重新加载都不会累积误差。
+    // queuedThumbnails 是已排队或正在加载的键，加载结果只在键仍在其中时计入（列表中已删除的不算）
+    QSet<QString> loadedThumbnails;
+    QSet<QString> queuedThumbnails;
+    int loadedCount() const { return loadedThumbnails.size(); }
     int totalCount;
     QFutureWatcher<QPixmap> *futureWatcher;
     bool isLoading;
 
-    // 静态缓存 - 保持向后兼容
-    static QMap<QString, QPixmap> thumbnailCache;
-    static QMutex cacheMutex;
-
     // === 性能优化成员 ===
 
-    // 智能缓存系统
-    QCache<QString, QPixmap> smartThumbnailCache;
+    // 缩略图只保存在 DecodedImageCache 的缩略图命名空间（QImage，线程安全，按字节计费）：
+    // 加载线程直接写入，绘制时直接 drawImage，界面线程不做像素转换，也没有第二份副本
 
     // 批量加载系统
     QTimer batchLoadTimer;
@@ -114,7 +135,6 @@ private:
 
     // 性能配置
     struct PerformanceConfig {
-        int maxCacheSize = 200 * 1024 * 1024; // 200MB
         int batchLoadSize = 10;  // 每次批量加载10个
         int batchLoadDelay = 50; // 批次间延迟50ms
         bool enableMemoryOptimization = true;
@@ -0,0 +1,387 @@
+// tiledimagerenderer.cpp
+#include "tiledimagerenderer.h"
+#include "imageresampler.h"
+#include <QPainter>
+#include <QPointer>
+#include <QtConcurrent>
+#include <QDebug>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const int kMinLevelSize = 64;       // 金字塔最小一级的边长
+const int kTileMargin = 4;          // 瓦片四周多取的像素（覆盖 Lanczos3 的支撑范围），避免拼接处产生接缝
+const qint64 kDefaultCacheLimit = 96 * 1024 * 1024;
+const int kRegionTilesPerTask = 4;  // 区域瓦片每个后台任务解码的数量
+
+quint64 doubleBits(double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+} // namespace
+
+QRect TiledImageRenderer::TileLayout::sourceRect(int column, int row) const
+{
+    return QRect(column * tileSpan, row * tileSpan, tileSpan, tileSpan)
+        .intersected(QRect(QPoint(0, 0), levelSize));
+}
+
+// 瓦片边界统一取整，保证相邻瓦片之间没有缝隙
+QRect TiledImageRenderer::TileLayout::destRect(int column, int row) const
+{
+    auto edgeX = [&](int c) {
+        return qRound(qMin(c * tileSpan, levelSize.width()) * scaleX);
+    };
+    auto edgeY = [&](int r) {
+        return qRound(qMin(r * tileSpan, levelSize.height()) * scaleY);
+    };
+    return QRect(origin.x() + edgeX(column), origin.y() + edgeY(row),
+                 edgeX(column + 1) - edgeX(column), edgeY(row + 1) - edgeY(row));
+}
+
+TiledImageRenderer::TileKey TiledImageRenderer::TileLayout::key(int column, int row) const
+{
+    return TileKey{level, column, row, doubleBits(scaleX), doubleBits(scaleY)};
+}
+
+TiledImageRenderer::TiledImageRenderer(QObject *parent)
+    : QObject(parent),
+      residentLevel(0),
+      tileCache(kDefaultCacheLimit),
+      generation(0)
+{
+}
+
+void TiledImageRenderer::setImage(const QImage &image)
+{
+    clear();
+    if (!image.isNull()) {
+        sourceSize = image.size();
+        pyramid.append(image);
+    }
+}
+
+void TiledImageRenderer::setRegionSource(const QSharedPointer<RegionImageSource> &source,
+                                         const QImage &overview)
+{
+    clear();
+    if (!source || overview.isNull()) {
+        return;
+    }
+
+    regionSource = source;
+    sourceSize = source->size();
+    residentLevel = source->overviewLevel();
+
+    QSize expected = source->overviewSize();
+    pyramid.resize(residentLevel);
+    pyramid.append(overview.size() == expected
+                       ? overview
+                       : ImageResampler::scaled(overview, expected));
+    qDebug() << "区域渲染: 原图" << sourceSize << "预览级" << residentLevel << expected;
+}
+
+void TiledImageRenderer::clear()
+{
+    sourceSize = QSize();
+    residentLevel = 0;
+    pyramid.clear();
+    regionSource.reset();
+    tileCache.clear();
+    pendingTiles.clear();
+    ++generation;
+}
+
+QSize TiledImageRenderer::imageSize() const
+{
+    return sourceSize;
+}
+
+void TiledImageRenderer::setCacheLimit(qint64 bytes)
+{
+    tileCache.setMaxCost(bytes);
+}
+
+QImage TiledImageRenderer::halfLevel(const QImage &previous)
+{
+    QSize halfSize((previous.width() + 1) / 2, (previous.height() + 1) / 2);
+    return ImageResampler::scaled(previous, halfSize, ImageResampler::Area);
+}
+
+// 按需生成金字塔的第 index 级（每级宽高减半），index 不能低于 residentLevel
+const QImage &TiledImageRenderer::level(int index)
+{
+    while (pyramid.size() <= index) {
+        pyramid.append(halfLevel(pyramid.last()));
+        qDebug() << "生成金字塔第" << pyramid.size() - 1 << "级:" << pyramid.last().size();
+    }
+    return pyramid.at(index);
+}
+
+// 选择分辨率不低于目标缩放的最小一级
+int TiledImageRenderer::chooseLevel(double scale) const
+{
+    int index = 0;
+    while (true) {
+        QSize next = RegionImageSource::levelSize(sourceSize, index + 1);
+        if (next.width() < kMinLevelSize || next.height() < kMinLevelSize) {
+            break;
+        }
+        double nextScale = static_cast<double>(next.width()) / sourceSize.width();
+        if (nextScale < scale) {
+            break;
+        }
+        ++index;
+    }
+    return index;
+}
+
+bool TiledImageRenderer::computeLayout(const QRectF &targetRect, const QRect &viewport,
+                                       TileLayout &layout) const
+{
+    if (isNull() || targetRect.isEmpty()) {
+        return false;
+    }
+
+    QRectF visible = QRectF(viewport).intersected(targetRect);
+    if (visible.isEmpty()) {
+        return false;
+    }
+
+    layout.level = chooseLevel(targetRect.width() / sourceSize.width());
+    layout.levelSize = RegionImageSource::levelSize(sourceSize, layout.level);
+
+    // 当前级到控件坐标的缩放比例
+    layout.scaleX = targetRect.width() / layout.levelSize.width();
+    layout.scaleY = targetRect.height() / layout.levelSize.height();
+
+    // 放大显示时缩小来源瓦片，使每个输出瓦片保持在 kTileSize 左右
+    layout.tileSpan = kTileSize;
+    if (layout.scaleX > 1.0) {
+        layout.tileSpan = qMax(16, static_cast<int>(kTileSize / layout.scaleX));
+    }
+
+    layout.origin = targetRect.topLeft().toPoint();
+    const int columns = (layout.levelSize.width() + layout.tileSpan - 1) / layout.tileSpan;
+    const int rows = (layout.levelSize.height() + layout.tileSpan - 1) / layout.tileSpan;
+    const double spanX = layout.tileSpan * layout.scaleX;
+    const double spanY = layout.tileSpan * layout.scaleY;
+
+    layout.firstColumn = qBound(0, static_cast<int>(std::floor((visible.left() - layout.origin.x()) / spanX)), columns - 1);
+    layout.lastColumn = qBound(0, static_cast<int>(std::floor((visible.right() - layout.origin.x()) / spanX)), columns - 1);
+    layout.firstRow = qBound(0, static_cast<int>(std::floor((visible.top() - layout.origin.y()) / spanY)), rows - 1);
+    layout.lastRow = qBound(0, static_cast<int>(std::floor((visible.bottom() - layout.origin.y()) / spanY)), rows - 1);
+    return true;
+}
+
+void TiledImageRenderer::paint(QPainter &painter, const QRectF &targetRect, const QRect &viewport,
+                               Quality quality)
+{
+    TileLayout layout;
+    if (!computeLayout(targetRect, viewport, layout)) {
+        return;
+    }
+
+    // 区域瓦片：缺失时用常驻的预览级放大代替，并提交后台解码
+    const bool regionTiles = layout.level < residentLevel;
+
+    // 交互期间不在界面线程生成新的金字塔级，用已有的最接近一级代替
+    const QImage &levelImage = regionTiles ? pyramid.at(residentLevel)
+                               : (quality == Smooth || layout.level < pyramid.size())
+                                   ? level(layout.level)
+                                   : pyramid.last();
+    const double ratioX = static_cast<double>(levelImage.width()) / layout.levelSize.width();
+    const double ratioY = static_cast<double>(levelImage.height()) / layout.levelSize.height();
+
+    QVector<TileJob> regionJobs;
+
+    painter.save();
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, regionTiles);
+
+    for (int row = layout.firstRow; row <= layout.lastRow; ++row) {
+        for (int column = layout.firstColumn; column <= layout.lastColumn; ++column) {
+            QRect destRect = layout.destRect(column, row);
+            if (destRect.isEmpty()) {
+                continue;
+            }
+
+            TileKey key = layout.key(column, row);
+            if (QPixmap *tile = tileCache.object(key)) {
+                painter.drawPixmap(destRect.topLeft(), *tile);
+                continue;
+            }
+
+            QRect sourceRect = layout.sourceRect(column, row);
+            if (quality == Interactive || regionTiles) {
+                // 交互期间为最近邻采样，代价只与输出像素数有关
+                QRectF scaledSource(sourceRect.x() * ratioX, sourceRect.y() * ratioY,
+                                    sourceRect.width() * ratioX, sourceRect.height() * ratioY);
+                painter.drawImage(QRectF(destRect), levelImage, scaledSource);
+
+                if (regionTiles && quality == Smooth && regionSource->supportsRegions() &&
+                    !pendingTiles.contains(key)) {
+                    regionJobs.append({key, sourceRect, destRect.size()});
+                }
+                continue;
+            }
+
+            QPixmap rendered = QPixmap::fromImage(
+                renderTile(levelImage, sourceRect, destRect.size(), layout.scaleX, layout.scaleY));
+            painter.drawPixmap(destRect.topLeft(), rendered);
+            insertTile(key, rendered);
+        }
+    }
+
+    painter.restore();
+
+    if (!regionJobs.isEmpty()) {
+        startTileJobs(layout, regionJobs);
+    }
+}
+
+void TiledImageRenderer::requestSmoothTiles(const QRectF &targetRect, const QRect &viewport)
+{
+    TileLayout layout;
+    if (!computeLayout(targetRect, viewport, layout) ||
+        (layout.level < residentLevel && !regionSource->supportsRegions())) {
+        emit tilesReady();
+        return;
+    }
+
+    QVector<TileJob> jobs;
+    for (int row = layout.firstRow; row <= layout.lastRow; ++row) {
+        for (int column = layout.firstColumn; column <= layout.lastColumn; ++column) {
+            TileKey key = layout.key(column, row);
+            QRect destRect = layout.destRect(column, row);
+            if (!destRect.isEmpty() && !tileCache.contains(key) && !pendingTiles.contains(key)) {
+                jobs.append({key, layout.sourceRect(column, row), destRect.size()});
+            }
+        }
+    }
+
+    if (jobs.isEmpty()) {
+        emit tilesReady();
+        return;
+    }
+
+    startTileJobs(layout, jobs);
+}
+
+void TiledImageRenderer::startTileJobs(const TileLayout &layout, const QVector<TileJob> &jobs)
+{
+    const bool regionTiles = layout.level < residentLevel;
+
+    // 缺失的金字塔级从已有的最后一级开始在后台生成；区域瓦片直接从原图解码
+    const int baseIndex = regionTiles ? residentLevel
+                                      : qMin(layout.level, static_cast<int>(pyramid.size()) - 1);
+    const QImage baseImage = pyramid.at(baseIndex);
+    const QSharedPointer<RegionImageSource> source = regionSource;
+    const quint64 requestGeneration = generation;
+    QPointer<TiledImageRenderer> guard(this);
+
+    // 区域解码较慢，拆成多个任务并行；普通瓦片共用一次金字塔生成，放在同一个任务里
+    const int tasksPerChunk = regionTiles ? kRegionTilesPerTask : jobs.size();
+    for (int start = 0; start < jobs.size(); start += tasksPerChunk) {
+        QVector<TileJob> chunk = jobs.mid(start, tasksPerChunk);
+        for (const TileJob &job : chunk) {
+            pendingTiles.insert(job.key);
+        }
+
+        QtConcurrent::run([guard, source, baseImage, baseIndex, layout, chunk, regionTiles,
+                           requestGeneration]() {
+            QVector<QImage> newLevels;
+            QImage levelImage = baseImage;
+            if (!regionTiles) {
+                for (int i = baseIndex; i < layout.level; ++i) {
+                    levelImage = halfLevel(levelImage);
+                    newLevels.append(levelImage);
+                }
+            }
+
+            QVector<QPair<TileKey, QImage>> tiles;
+            tiles.reserve(chunk.size());
+            for (const TileJob &job : chunk) {
+                QImage tile = regionTiles
+                                  ? renderRegionTile(*source, layout.levelSize, job.sourceRect,
+                                                     job.destSize, layout.scaleX, layout.scaleY)
+                                  : renderTile(levelImage, job.sourceRect, job.destSize,
+                                               layout.scaleX, layout.scaleY);
+                tiles.append(qMakePair(job.key, tile));
+            }
+
+            if (!guard) {
+                return;
+            }
+            QMetaObject::invokeMethod(guard, [guard, baseIndex, newLevels, tiles, requestGeneration]() {
+                if (!guard || guard->generation != requestGeneration) {
+                    return;
+                }
+                // 同一代内金字塔只会增长，补上界面线程尚未生成的级别
+                for (int i = guard->pyramid.size() - baseIndex - 1; i < newLevels.size(); ++i) {
+                    guard->pyramid.append(newLevels.at(i));
+                }
+                for (const auto &tile : tiles) {
+                    guard->pendingTiles.remove(tile.first);
+                    if (!tile.second.isNull()) {
+                        guard->insertTile(tile.first, QPixmap::fromImage(tile.second));
+                    }
+                }
+                emit guard->tilesReady();
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+bool TiledImageRenderer::insertTile(const TileKey &key, const QPixmap &tile)
+{
+    qint64 cost = static_cast<qint64>(tile.width()) * tile.height() * 4;
+    return tileCache.insert(key, new QPixmap(tile), cost);
+}
+
+QImage TiledImageRenderer::renderTile(const QImage &levelImage, const QRect &sourceRect,
+                                      const QSize &destSize, double scaleX, double scaleY)
+{
+    QRect padded = sourceRect.adjusted(-kTileMargin, -kTileMargin, kTileMargin, kTileMargin)
+                       .intersected(levelImage.rect());
+    QSize paddedSize(qMax(1, qRound(padded.width() * scaleX)),
+                     qMax(1, qRound(padded.height() * scaleY)));
+
+    QImage scaled = ImageResampler::scaled(levelImage.copy(padded), paddedSize,
+                                           ImageResampler::defaultFilter(padded.size(), paddedSize));
+
+    int offsetX = qRound((sourceRect.x() - padded.x()) * scaleX);
+    int offsetY = qRound((sourceRect.y() - padded.y()) * scaleY);
+    return scaled.copy(offsetX, offsetY, destSize.width(), destSize.height());
+}
+
+// 把当前级坐标中的瓦片（含边距）换算到原图坐标，按区域解码后裁掉边距
+QImage TiledImageRenderer::renderRegionTile(const RegionImageSource &source, const QSize &levelSize,
+                                            const QRect &sourceRect, const QSize &destSize,
+                                            double scaleX, double scaleY)
+{
+    QRect padded = sourceRect.adjusted(-kTileMargin, -kTileMargin, kTileMargin, kTileMargin)
+                       .intersected(QRect(QPoint(0, 0), levelSize));
+    QSize paddedSize(qMax(1, qRound(padded.width() * scaleX)),
+                     qMax(1, qRound(padded.height() * scaleY)));
+
+    const QSize fullSize = source.size();
+    const double toFullX = static_cast<double>(fullSize.width()) / levelSize.width();
+    const double toFullY = static_cast<double>(fullSize.height()) / levelSize.height();
+    QRect fullRect(QPoint(static_cast<int>(std::floor(padded.left() * toFullX)),
+                          static_cast<int>(std::floor(padded.top() * toFullY))),
+                   QPoint(static_cast<int>(std::ceil((padded.right() + 1) * toFullX)) - 1,
+                          static_cast<int>(std::ceil((padded.bottom() + 1) * toFullY)) - 1));
+
+    QImage scaled = source.decodeRegion(fullRect, paddedSize);
+    if (scaled.isNull()) {
+        return QImage();
+    }
+
+    int offsetX = qRound((sourceRect.x() - padded.x()) * scaleX);
+    int offsetY = qRound((sourceRect.y() - padded.y()) * scaleY);
+    return scaled.copy(offsetX, offsetY, destSize.width(), destSize.height());
+}
@@ -0,0 +1,124 @@
+// tiledimagerenderer.h
+#ifndef TILEDIMAGERENDERER_H
+#define TILEDIMAGERENDERER_H
+
+#include <QObject>
+#include <QImage>
+#include <QPixmap>
+#include <QCache>
+#include <QVector>
+#include <QRect>
+#include <QRectF>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include "regionimagesource.h"
+
+class QPainter;
+
+// 单张模式的分块渲染器
+// 保存原图的 mip 金字塔（每级缩小一半，按需生成），绘制时只缩放与视口相交的瓦片，
+// 并选择不低于目标分辨率的最近一级作为来源。缩放后的瓦片按 LRU 缓存。
+// 内存占用与视口大小成正比，与缩放倍数无关；缩小显示时也不再对原图整体重采样。
+// 区域解码模式下只常驻预览图及更小的级别，更高分辨率的瓦片在后台从 RegionImageSource 解码，
+// 解码完成前用预览图放大代替。
+class TiledImageRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Quality {
+        Smooth,         // 缺失的瓦片同步平滑缩放
+        Interactive     // 拖动/滚轮缩放期间：缺失的瓦片直接用最近邻从已有金字塔级绘制
+    };
+
+    explicit TiledImageRenderer(QObject *parent = nullptr);
+
+    // 设置原图，清空金字塔与瓦片缓存
+    void setImage(const QImage &image);
+    // 区域解码模式：overview 为 source->overviewLevel() 级的预览图
+    void setRegionSource(const QSharedPointer<RegionImageSource> &source, const QImage &overview);
+    void clear();
+
+    bool isNull() const { return sourceSize.isEmpty(); }
+    QSize imageSize() const;
+
+    // targetRect：整张图片在控件坐标中的位置（已包含缩放和平移）
+    // viewport：需要重绘的区域，只绘制与之相交的瓦片
+    void paint(QPainter &painter, const QRectF &targetRect, const QRect &viewport,
+               Quality quality = Smooth);
+
+    // 在后台线程生成 viewport 内缺失的平滑瓦片（以及所需的金字塔级），完成后发出 tilesReady
+    void requestSmoothTiles(const QRectF &targetRect, const QRect &viewport);
+
+    // 瓦片缓存上限（字节）
+    void setCacheLimit(qint64 bytes);
+
+    static constexpr int kTileSize = 256;
+
+signals:
+    void tilesReady();
+
+private:
+    struct TileKey {
+        int level;
+        int column;
+        int row;
+        quint64 scaleX;
+        quint64 scaleY;
+
+        bool operator==(const TileKey &other) const {
+            return level == other.level && column == other.column && row == other.row &&
+                   scaleX == other.scaleX && scaleY == other.scaleY;
+        }
+        friend size_t qHash(const TileKey &key, size_t seed = 0) {
+            return qHashMulti(seed, key.level, key.column, key.row, key.scaleX, key.scaleY);
+        }
+    };
+
+    // 某一缩放下可见瓦片的布局
+    struct TileLayout {
+        int level = 0;
+        QSize levelSize;
+        double scaleX = 1.0;
+        double scaleY = 1.0;
+        int tileSpan = kTileSize;
+        QPoint origin;
+        int firstColumn = 0;
+        int lastColumn = -1;
+        int firstRow = 0;
+        int lastRow = -1;
+
+        QRect sourceRect(int column, int row) const;
+        QRect destRect(int column, int row) const;
+        TileKey key(int column, int row) const;
+    };
+
+    struct TileJob {
+        TileKey key;
+        QRect sourceRect;
+        QSize destSize;
+    };
+
+    bool computeLayout(const QRectF &targetRect, const QRect &viewport, TileLayout &layout) const;
+    void startTileJobs(const TileLayout &layout, const QVector<TileJob> &jobs);
+    const QImage &level(int index);
+    int chooseLevel(double scale) const;
+    static QImage halfLevel(const QImage &previous);
+    static QImage renderTile(const QImage &levelImage, const QRect &sourceRect,
+                             const QSize &destSize, double scaleX, double scaleY);
+    static QImage renderRegionTile(const RegionImageSource &source, const QSize &levelSize,
+                                   const QRect &sourceRect, const QSize &destSize,
+                                   double scaleX, double scaleY);
+    bool insertTile(const TileKey &key, const QPixmap &tile);
+
+    QSize sourceSize;                     // 原图尺寸
+    int residentLevel;                    // 常驻内存的最高分辨率级，普通模式为 0
+    QVector<QImage> pyramid;              // pyramid[i] 为第 i 级，低于 residentLevel 的为空
+    QSharedPointer<RegionImageSource> regionSource;
+    QCache<TileKey, QPixmap> tileCache;
+    QSet<TileKey> pendingTiles;           // 已提交后台解码、尚未完成的区域瓦片
+    quint64 generation;                   // setImage/clear 时递增，丢弃过期的后台结果
+};
+
+#endif // TILEDIMAGERENDERER_H